@@ -447,9 +447,7 @@ namespace vks
 		// Vertex buffer
 		VkDeviceSize vertexBufferSize = imDrawData->TotalVtxCount * sizeof(ImDrawVert);
 		if ((!frameObjects[frameIndex].vertexBuffer) || (imDrawData->TotalVtxCount > frameObjects[frameIndex].vertexCount)) {
-			if (frameObjects[frameIndex].vertexBuffer) {
-				delete frameObjects[frameIndex].vertexBuffer;
-			}
+			VulkanContext::deletionQueue.retire(frameObjects[frameIndex].vertexBuffer);
 			frameObjects[frameIndex].vertexBuffer = new Buffer({
 				.usageFlags = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
 				.size = vertexBufferSize,
@@ -461,9 +459,7 @@ namespace vks
 		// Index buffer
 		VkDeviceSize indexBufferSize = imDrawData->TotalIdxCount * sizeof(ImDrawIdx);
 		if ((!frameObjects[frameIndex].indexBuffer) || (imDrawData->TotalIdxCount > frameObjects[frameIndex].indexCount)) {
-			if (frameObjects[frameIndex].indexBuffer) {
-				delete frameObjects[frameIndex].indexBuffer;
-			}
+			VulkanContext::deletionQueue.retire(frameObjects[frameIndex].indexBuffer);
 			frameObjects[frameIndex].indexBuffer = new Buffer({
 				.usageFlags = VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
 				.size = indexBufferSize,
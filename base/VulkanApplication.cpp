@@ -7,6 +7,8 @@
  */
 
 #include "VulkanApplication.h"
+#include <fstream>
+#include <filesystem>
 
 #undef VMA_DEDICATED_ALLOCATION 
 #undef VMA_BIND_MEMORY2
@@ -175,6 +177,15 @@ void VulkanApplication::prepare()
 		throw std::runtime_error("Could not init Vulkan Memory Allocator");
 	}
 
+	VkSemaphoreTypeCreateInfo semaphoreTypeCI{
+		.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO,
+		.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE,
+		.initialValue = 0
+	};
+	VkSemaphoreCreateInfo timelineSemaphoreCI = vks::initializers::semaphoreCreateInfo();
+	timelineSemaphoreCI.pNext = &semaphoreTypeCI;
+	VK_CHECK_RESULT(vkCreateSemaphore(*vulkanDevice, &timelineSemaphoreCI, nullptr, &frameTimelineSemaphore));
+
 	initSwapchain();
 	// Default command Pool
 	commandPool = new CommandPool({
@@ -185,9 +196,12 @@ void VulkanApplication::prepare()
 	swapChain->create(&width, &height, settings.vsync);
 	setupDepthStencil();
 	setupImages();
-	// Default pipeline cache
+	// Default pipeline cache, initialized with the data from the last run (if compatible)
+	const std::vector<uint8_t> pipelineCacheData = loadPipelineCacheData();
 	VkPipelineCacheCreateInfo pipelineCacheCreateInfo{};
 	pipelineCacheCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+	pipelineCacheCreateInfo.initialDataSize = pipelineCacheData.size();
+	pipelineCacheCreateInfo.pInitialData = pipelineCacheData.empty() ? nullptr : pipelineCacheData.data();
 	VK_CHECK_RESULT(vkCreatePipelineCache(*vulkanDevice, &pipelineCacheCreateInfo, nullptr, &pipelineCache));
 	// ImGUI based overlay
 	overlay = new vks::UIOverlay({
@@ -250,6 +264,15 @@ void VulkanApplication::renderFrame()
 	//updateOverlay();
 }
 
+void VulkanApplication::requestExit()
+{
+#if defined(_WIN32)
+	window->close();
+#elif defined(VK_USE_PLATFORM_WAYLAND_KHR) || defined(_DIRECT2DISPLAY) || defined(VK_USE_PLATFORM_XCB_KHR)
+	quit = true;
+#endif
+}
+
 void VulkanApplication::renderLoop()
 {
 	destWidth = width;
@@ -575,9 +598,7 @@ void VulkanApplication::updateOverlay(uint32_t frameIndex)
 	//Check if the overlay's index and vertex buffers needs to be updated (recreated), e.g. because new elements are visible and indices or vertices require additional buffer space
    //@todo: remove?
 	if (overlay->bufferUpdateRequired(frameIndex)) {
-		// Ensure all command buffers have finished execution, so we don't change vertex and/or index buffers still in use
-		// @todo: wait for fences instead?
-		vkQueueWaitIdle(queue);
+		// Buffers that are replaced are handed to the deletion queue, so there's no need to wait for command buffers to finish
 		overlay->allocateBuffers(frameIndex);
 	}
 	// @todo: cap update rate
@@ -616,6 +637,8 @@ VulkanApplication::VulkanApplication()
 	commandLineParser.add("height", { "-h", "--height" }, 1, "Set window height");
 	commandLineParser.add("gpuselection", { "-g", "--gpu" }, 1, "Select GPU to run on");
 	commandLineParser.add("gpulist", { "-gl", "--listgpus" }, 0, "Display a list of available Vulkan devices");
+	commandLineParser.add("framesinflight", { "-fif", "--framesinflight" }, 1, "No. of frames in flight (1-4, default: 2)");
+	commandLineParser.add("cachepath", { "--cachepath" }, 1, "Directory for the pipeline and shader caches (default: cache/, empty to disable)");
 
 	commandLineParser.parse(args);
 	if (commandLineParser.isSet("help")) {
@@ -641,6 +664,18 @@ VulkanApplication::VulkanApplication()
 	if (commandLineParser.isSet("fullscreen")) {
 		settings.fullscreen = true;
 	}
+	if (commandLineParser.isSet("framesinflight")) {
+		renderAhead = std::clamp(static_cast<uint32_t>(commandLineParser.getValueAsInt("framesinflight", renderAhead)), 1u, maxRenderAhead);
+	}
+	if (commandLineParser.isSet("cachepath")) {
+		cachePath = commandLineParser.getValueAsString("cachepath", cachePath);
+		if (!cachePath.empty() && (cachePath.back() != '/')) {
+			cachePath += '/';
+		}
+	}
+
+	// Required for frame pacing
+	Device::enabledFeatures12.timelineSemaphore = VK_TRUE;
 	
 #if defined(VK_USE_PLATFORM_ANDROID_KHR)
 	// Vulkan library is loaded dynamically on Android
@@ -664,6 +699,80 @@ VulkanApplication::VulkanApplication()
 #endif
 }
 
+static const uint32_t pipelineCacheFileMagic = 0x50435631; // "PCV1"
+static const uint32_t pipelineCacheFileVersion = 1;
+
+std::vector<uint8_t> VulkanApplication::loadPipelineCacheData()
+{
+	std::vector<uint8_t> data{};
+	if (cachePath.empty()) {
+		return data;
+	}
+	std::ifstream file(cachePath + "pipelines.bin", std::ios::binary);
+	if (!file.is_open()) {
+		return data;
+	}
+	PipelineCacheFileHeader header{};
+	file.read(reinterpret_cast<char*>(&header), sizeof(header));
+	const VkPhysicalDeviceProperties& properties = vulkanDevice->properties;
+	const bool compatible = file &&
+		(header.magic == pipelineCacheFileMagic) &&
+		(header.version == pipelineCacheFileVersion) &&
+		(header.vendorID == properties.vendorID) &&
+		(header.deviceID == properties.deviceID) &&
+		(header.driverVersion == properties.driverVersion) &&
+		(memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) == 0);
+	if (!compatible) {
+		std::cout << "Discarding pipeline cache from a different device or driver\n";
+		return data;
+	}
+	data.resize(header.dataSize);
+	file.read(reinterpret_cast<char*>(data.data()), header.dataSize);
+	if (!file) {
+		std::cout << "Discarding incomplete pipeline cache\n";
+		data.clear();
+	}
+	return data;
+}
+
+void VulkanApplication::savePipelineCacheData()
+{
+	if (cachePath.empty() || (pipelineCache == VK_NULL_HANDLE)) {
+		return;
+	}
+	size_t dataSize{ 0 };
+	if ((vkGetPipelineCacheData(*vulkanDevice, pipelineCache, &dataSize, nullptr) != VK_SUCCESS) || (dataSize == 0)) {
+		return;
+	}
+	std::vector<uint8_t> data(dataSize);
+	if (vkGetPipelineCacheData(*vulkanDevice, pipelineCache, &dataSize, data.data()) != VK_SUCCESS) {
+		return;
+	}
+	const VkPhysicalDeviceProperties& properties = vulkanDevice->properties;
+	PipelineCacheFileHeader header{
+		.magic = pipelineCacheFileMagic,
+		.version = pipelineCacheFileVersion,
+		.vendorID = properties.vendorID,
+		.deviceID = properties.deviceID,
+		.driverVersion = properties.driverVersion,
+		.dataSize = dataSize
+	};
+	memcpy(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE);
+	std::error_code error;
+	std::filesystem::create_directories(cachePath, error);
+	// Written to a temporary file first so an interrupted write doesn't leave a broken cache behind
+	const std::string fileName = cachePath + "pipelines.bin";
+	std::ofstream file(fileName + ".tmp", std::ios::binary);
+	if (!file.is_open()) {
+		std::cerr << "Could not write pipeline cache to " << fileName << "\n";
+		return;
+	}
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	file.write(reinterpret_cast<const char*>(data.data()), dataSize);
+	file.close();
+	std::filesystem::rename(fileName + ".tmp", fileName, error);
+}
+
 VulkanApplication::~VulkanApplication()
 {
 	delete swapChain;
@@ -672,6 +781,7 @@ VulkanApplication::~VulkanApplication()
 	vkDestroyImage(*vulkanDevice, depthStencil.image, nullptr);
 	vkFreeMemory(*vulkanDevice, depthStencil.memory, nullptr);
 
+	savePipelineCacheData();
 	vkDestroyPipelineCache(*vulkanDevice, pipelineCache, nullptr);
 
 	if (settings.sampleCount > VK_SAMPLE_COUNT_1_BIT) {
@@ -683,7 +793,10 @@ VulkanApplication::~VulkanApplication()
 		vkFreeMemory(*vulkanDevice, multisampleTarget.depth.memory, nullptr);
 	}
 
-	// @todo: deletion queue
+	vulkanDevice->waitIdle();
+	VulkanContext::deletionQueue.flushAll();
+
+	vkDestroySemaphore(*vulkanDevice, frameTimelineSemaphore, nullptr);
 
 	if (settings.validation)
 	{
@@ -1904,9 +2017,21 @@ void VulkanApplication::OnUpdateOverlay(vks::UIOverlay &overlay) {}
 
 void VulkanApplication::prepareFrame(VulkanFrameObjects& frame)
 {
-	// Ensure command buffer execution has finished
-	VK_CHECK_RESULT(vkWaitForFences(*vulkanDevice, 1, &frame.renderCompleteFence, VK_TRUE, UINT64_MAX));
-	VK_CHECK_RESULT(vkResetFences(*vulkanDevice, 1, &frame.renderCompleteFence));
+	// Ensure the frame that last used this frame's resources (renderAhead frames ago) has finished execution
+	if (frame.frameNumber > 0) {
+		VkSemaphoreWaitInfo waitInfo{
+			.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
+			.semaphoreCount = 1,
+			.pSemaphores = &frameTimelineSemaphore,
+			.pValues = &frame.frameNumber
+		};
+		VK_CHECK_RESULT(vkWaitSemaphores(*vulkanDevice, &waitInfo, UINT64_MAX));
+	}
+	frameNumber++;
+	frame.frameNumber = frameNumber;
+	// Destroy resources retired in frames that have finished by now
+	VulkanContext::deletionQueue.setFrameNumber(frameNumber);
+	VulkanContext::deletionQueue.flush(getCompletedFrameNumber());
 	// Acquire the next image from the swap chain
 	VkResult result = swapChain->acquireNextImage(frame.presentCompleteSemaphore, &currentBuffer);
 	// @todo: rework after removing currentBuffer
@@ -1928,11 +2053,23 @@ void VulkanApplication::submitFrame(VulkanFrameObjects& frame)
 	submitInfo.pWaitDstStageMask = &submitWaitStages;
 	submitInfo.waitSemaphoreCount = 1;
 	submitInfo.pWaitSemaphores = &frame.presentCompleteSemaphore;
-	submitInfo.signalSemaphoreCount = 1;
-	submitInfo.pSignalSemaphores = &frame.renderCompleteSemaphore;
+	// The binary semaphore is required for presentation, the timeline semaphore signals completion of this frame
+	const VkSemaphore signalSemaphores[2] = { frame.renderCompleteSemaphore, frameTimelineSemaphore };
+	const uint64_t waitValue = 0;
+	const uint64_t signalValues[2] = { 0, frame.frameNumber };
+	VkTimelineSemaphoreSubmitInfo timelineSubmitInfo{
+		.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO,
+		.waitSemaphoreValueCount = 1,
+		.pWaitSemaphoreValues = &waitValue,
+		.signalSemaphoreValueCount = 2,
+		.pSignalSemaphoreValues = signalValues
+	};
+	submitInfo.pNext = &timelineSubmitInfo;
+	submitInfo.signalSemaphoreCount = 2;
+	submitInfo.pSignalSemaphores = signalSemaphores;
 	submitInfo.commandBufferCount = 1;
 	submitInfo.pCommandBuffers = &frame.commandBuffer->handle;
-	VK_CHECK_RESULT(vkQueueSubmit(queue, 1, &submitInfo, frame.renderCompleteFence));
+	VK_CHECK_RESULT(vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE));
 
 	// Present image to queue
 	VkResult result = swapChain->queuePresent(queue, currentBuffer, frame.renderCompleteSemaphore);
@@ -1963,14 +2100,24 @@ uint32_t VulkanApplication::getCurrentFrameIndex()
 	return frameIndex;
 }
 
+uint64_t VulkanApplication::getCurrentFrameNumber()
+{
+	return frameNumber;
+}
+
+uint64_t VulkanApplication::getCompletedFrameNumber()
+{
+	uint64_t value{ 0 };
+	VK_CHECK_RESULT(vkGetSemaphoreCounterValue(*vulkanDevice, frameTimelineSemaphore, &value));
+	return value;
+}
+
 void VulkanApplication::createBaseFrameObjects(VulkanFrameObjects& frame)
 {
 	frame.commandBuffer = new CommandBuffer({
 		.device = *vulkanDevice,
 		.pool = commandPool
 	});
-	VkFenceCreateInfo fenceCreateInfo = vks::initializers::fenceCreateInfo(VK_FENCE_CREATE_SIGNALED_BIT);
-	VK_CHECK_RESULT(vkCreateFence(*vulkanDevice, &fenceCreateInfo, nullptr, &frame.renderCompleteFence));
 	VkSemaphoreCreateInfo semaphoreCreateInfo = vks::initializers::semaphoreCreateInfo();
 	VK_CHECK_RESULT(vkCreateSemaphore(*vulkanDevice, &semaphoreCreateInfo, nullptr, &frame.presentCompleteSemaphore));
 	VK_CHECK_RESULT(vkCreateSemaphore(*vulkanDevice, &semaphoreCreateInfo, nullptr, &frame.renderCompleteSemaphore));
@@ -1978,7 +2125,6 @@ void VulkanApplication::createBaseFrameObjects(VulkanFrameObjects& frame)
 
 void VulkanApplication::destroyBaseFrameObjects(VulkanFrameObjects& frame)
 {
-	vkDestroyFence(*vulkanDevice, frame.renderCompleteFence, nullptr);
 	vkDestroySemaphore(*vulkanDevice, frame.presentCompleteSemaphore, nullptr);
 	vkDestroySemaphore(*vulkanDevice, frame.renderCompleteSemaphore, nullptr);
 }
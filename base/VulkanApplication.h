@@ -66,7 +66,8 @@ struct VulkanFrameObjects
 {
 	size_t index;
 	CommandBuffer* commandBuffer;
-	VkFence renderCompleteFence;
+	// Frame number that was last submitted with this frame's resources, the frame timeline semaphore reaches this value once the GPU has finished it
+	uint64_t frameNumber{ 0 };
 	VkSemaphore renderCompleteSemaphore;
 	VkSemaphore presentCompleteSemaphore;
 };
@@ -88,8 +89,21 @@ private:
 	void handleMouseMove(int32_t x, int32_t y);
 	VkDebugUtilsMessengerEXT debugUtilsMessenger;
 	VkPhysicalDeviceDynamicRenderingFeatures dynamicRenderingFeatures{};
-	CommandLineParser commandLineParser;
+	// Header written in front of the pipeline cache data, so caches from other devices or driver versions are discarded
+	struct PipelineCacheFileHeader {
+		uint32_t magic;
+		uint32_t version;
+		uint32_t vendorID;
+		uint32_t deviceID;
+		uint32_t driverVersion;
+		uint8_t pipelineCacheUUID[VK_UUID_SIZE];
+		uint64_t dataSize;
+	};
+	std::vector<uint8_t> loadPipelineCacheData();
+	void savePipelineCacheData();
 protected:
+	// Applications can add their own arguments (and parse again)
+	CommandLineParser commandLineParser;
 	struct MultisampleTarget {
 		ImageAttachment color;
 		ImageAttachment depth;
@@ -108,9 +122,16 @@ protected:
 	CommandPool* commandPool;
 	uint32_t currentBuffer = 0;
 	VkPipelineCache pipelineCache;
+	// Directory for data persisted between runs (pipeline cache, compiled shaders), can be set via command line
+	std::string cachePath{ "cache/" };
 	SwapChain* swapChain;
 	uint32_t frameIndex = 0;
+	// No. of frames in flight, can be set via command line to trade latency against throughput
 	uint32_t renderAhead = 2;
+	static constexpr uint32_t maxRenderAhead = 4;
+	// Frame pacing is done with a single timeline semaphore that's signalled with the (monotonically increasing) frame number of each submitted frame
+	VkSemaphore frameTimelineSemaphore{ VK_NULL_HANDLE };
+	uint64_t frameNumber = 0;
 public: 
 	bool prepared = false;
 	uint32_t width = 1024;
@@ -298,6 +319,9 @@ public:
 	// Start the main render loop
 	void renderLoop();
 
+	// Leaves the render loop (or skips it if called before the loop has been entered), not supported on all platforms
+	void requestExit();
+
 	// Render one frame of a render loop on platforms that sync rendering
 	void renderFrame();
 
@@ -313,6 +337,10 @@ public:
 	void submitFrame(VulkanFrameObjects& frame);
 	uint32_t getFrameCount();
 	uint32_t getCurrentFrameIndex();
+	// Number of the frame that's currently being recorded, starts at 1
+	uint64_t getCurrentFrameNumber();
+	// All frames up to and including this number have finished on the GPU, so resources last used by them are safe to reuse or destroy
+	uint64_t getCompletedFrameNumber();
 
 	void createBaseFrameObjects(VulkanFrameObjects& frame);
 	void destroyBaseFrameObjects(VulkanFrameObjects& frame);
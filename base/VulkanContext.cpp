@@ -14,3 +14,4 @@ VkQueue VulkanContext::copyQueue = VK_NULL_HANDLE;
 VkQueue VulkanContext::graphicsQueue = VK_NULL_HANDLE;
 Device* VulkanContext::device = nullptr;
 VmaAllocator VulkanContext::vmaAllocator = VK_NULL_HANDLE;
+vks::DeletionQueue VulkanContext::deletionQueue{};
@@ -9,6 +9,7 @@
 #include "volk.h"
 #include "Device.hpp"
 #include "vk_mem_alloc.h"
+#include "DeletionQueue.hpp"
 
 #pragma once
 
@@ -18,6 +19,8 @@ public:
 	static VkQueue graphicsQueue;
 	static Device* device;
 	static VmaAllocator vmaAllocator;
+	// Resources that may still be in use by frames in flight are handed to this instead of being destroyed directly
+	static vks::DeletionQueue deletionQueue;
 };
 
 extern VulkanContext vulkanContext;
\ No newline at end of file
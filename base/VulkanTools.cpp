@@ -250,5 +250,37 @@ namespace vks
 			std::ifstream f(filename.c_str());
 			return !f.fail();
 		}
+
+		bool isBlockCompressed(VkFormat format)
+		{
+			return (format >= VK_FORMAT_BC1_RGB_UNORM_BLOCK) && (format <= VK_FORMAT_BC7_SRGB_BLOCK);
+		}
+
+		VkDeviceSize getImageSize(VkFormat format, uint32_t width, uint32_t height)
+		{
+			const VkDeviceSize blockCount = static_cast<VkDeviceSize>((width + 3) / 4) * ((height + 3) / 4);
+			switch (format)
+			{
+			case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+			case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+			case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+			case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+				return blockCount * 8;
+			case VK_FORMAT_BC3_UNORM_BLOCK:
+			case VK_FORMAT_BC3_SRGB_BLOCK:
+			case VK_FORMAT_BC7_UNORM_BLOCK:
+			case VK_FORMAT_BC7_SRGB_BLOCK:
+				return blockCount * 16;
+			case VK_FORMAT_R8_UNORM:
+			case VK_FORMAT_R8_UINT:
+				return static_cast<VkDeviceSize>(width) * height;
+			case VK_FORMAT_R16_UINT:
+			case VK_FORMAT_R16_SFLOAT:
+				return static_cast<VkDeviceSize>(width) * height * 2;
+			default:
+				assert(!isBlockCompressed(format));
+				return static_cast<VkDeviceSize>(width) * height * 4;
+			}
+		}
 	}
 }
\ No newline at end of file
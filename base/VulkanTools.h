@@ -107,5 +107,10 @@ namespace vks
 
 		/** @brief Checks if a file exists */
 		bool fileExists(const std::string &filename);
+
+		// Returns true for block compressed (BCn) formats
+		bool isBlockCompressed(VkFormat format);
+		// Size in bytes of a single image with the given dimensions, supports 8, 16 and 32 bit uncompressed formats and BC1, BC3 and BC7
+		VkDeviceSize getImageSize(VkFormat format, uint32_t width, uint32_t height);
 	}
 }
@@ -7,24 +7,186 @@
  */
 
 #include "slang.hpp"
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <filesystem>
+#include <algorithm>
+#include <thread>
 
 SlangCompiler* slangCompiler{ nullptr };
 
+// FNV-1a
+static void hashBytes(uint64_t& hash, const void* data, size_t size)
+{
+	const uint8_t* bytes = static_cast<const uint8_t*>(data);
+	for (size_t i = 0; i < size; i++) {
+		hash = (hash ^ bytes[i]) * 1099511628211ull;
+	}
+}
+
 Slang::ComPtr<slang::ISession> SlangCompiler::createSession()
+{
+	return createSession(globalSession);
+}
+
+Slang::ComPtr<slang::ISession> SlangCompiler::createSession(slang::IGlobalSession* globalSession)
 {
 	Slang::ComPtr<slang::ISession> session;
 	auto targets{ std::to_array<slang::TargetDesc>({ {.format{SLANG_SPIRV}, .profile{globalSession->findProfile("spirv_1_6")} } }) };
 	auto options{ std::to_array<slang::CompilerOptionEntry>({ { slang::CompilerOptionName::EmitSpirvDirectly, {slang::CompilerOptionValueKind::Int, 1} } }) };
 	slang::SessionDesc desc{ .targets{targets.data()}, .targetCount{SlangInt(targets.size())}, .compilerOptionEntries{options.data()}, .compilerOptionEntryCount{uint32_t(options.size())} };
 	desc.defaultMatrixLayoutMode = SLANG_MATRIX_LAYOUT_COLUMN_MAJOR;
-	SlangResult res = slangCompiler->globalSession->createSession(desc, session.writeRef());
+	SlangResult res = globalSession->createSession(desc, session.writeRef());
 	if (res == SLANG_FAIL) {
 		throw std::runtime_error("Could not init Slang library");
 	}
 	return session;
 }
 
+Slang::ComPtr<slang::IGlobalSession> SlangCompiler::acquireGlobalSession()
+{
+	{
+		std::lock_guard<std::mutex> lock(globalSessionMutex);
+		if (!idleGlobalSessions.empty()) {
+			Slang::ComPtr<slang::IGlobalSession> session = idleGlobalSessions.back();
+			idleGlobalSessions.pop_back();
+			return session;
+		}
+	}
+	// Only happens if more threads than ever before compile at the same time
+	Slang::ComPtr<slang::IGlobalSession> session;
+	slang::createGlobalSession(session.writeRef());
+	return session;
+}
+
+void SlangCompiler::releaseGlobalSession(Slang::ComPtr<slang::IGlobalSession> session)
+{
+	std::lock_guard<std::mutex> lock(globalSessionMutex);
+	idleGlobalSessions.push_back(session);
+}
+
+// Hashes the file and (recursively) all files it includes or imports from the same directory
+void SlangCompiler::hashSourceFile(const std::string& filename, uint64_t& hash, std::set<std::string>& visited)
+{
+	if (!visited.insert(filename).second) {
+		return;
+	}
+	std::ifstream file(filename, std::ios::binary);
+	if (!file.is_open()) {
+		// Missing dependencies (e.g. modules from the Slang standard library) don't affect the hash
+		return;
+	}
+	std::stringstream buffer;
+	buffer << file.rdbuf();
+	const std::string source = buffer.str();
+	hashBytes(hash, filename.data(), filename.size());
+	hashBytes(hash, source.data(), source.size());
+
+	const std::filesystem::path directory = std::filesystem::path(filename).parent_path();
+	std::istringstream lines(source);
+	std::string line;
+	while (std::getline(lines, line)) {
+		const size_t start = line.find_first_not_of(" \t");
+		if (start == std::string::npos) {
+			continue;
+		}
+		line = line.substr(start);
+		// #include "file.slang"
+		if (line.rfind("#include", 0) == 0) {
+			const size_t first = line.find('"');
+			const size_t last = line.find('"', first + 1);
+			if (first != std::string::npos && last != std::string::npos) {
+				hashSourceFile((directory / line.substr(first + 1, last - first - 1)).string(), hash, visited);
+			}
+		}
+		// import module; (module names map to file names, with underscores for dashes)
+		if (line.rfind("import ", 0) == 0) {
+			std::string module = line.substr(7, line.find(';') - 7);
+			module.erase(module.find_last_not_of(" \t\r") + 1);
+			std::replace(module.begin(), module.end(), '.', '/');
+			std::replace(module.begin(), module.end(), '_', '-');
+			hashSourceFile((directory / (module + ".slang")).string(), hash, visited);
+		}
+	}
+}
+
+std::vector<uint32_t> SlangCompiler::compile(const std::string& name, const std::string& filename)
+{
+	std::string cacheFile{ "" };
+	if (!cacheDirectory.empty()) {
+		uint64_t hash{ 14695981039346656037ull };
+		hashBytes(hash, optionsKey.data(), optionsKey.size());
+		std::set<std::string> visited;
+		hashSourceFile(filename, hash, visited);
+		std::stringstream fileName;
+		fileName << std::hex << std::setw(16) << std::setfill('0') << hash << ".spv";
+		cacheFile = (std::filesystem::path(cacheDirectory) / fileName.str()).string();
+
+		std::ifstream file(cacheFile, std::ios::binary | std::ios::ate);
+		if (file.is_open()) {
+			const size_t size = static_cast<size_t>(file.tellg());
+			if ((size > 0) && (size % sizeof(uint32_t) == 0)) {
+				std::vector<uint32_t> spirv(size / sizeof(uint32_t));
+				file.seekg(0);
+				file.read(reinterpret_cast<char*>(spirv.data()), size);
+				if (file) {
+					cacheHits++;
+					return spirv;
+				}
+			}
+		}
+	}
+
+	cacheMisses++;
+	std::vector<uint32_t> spirv;
+	std::string errorMessage{ "" };
+	Slang::ComPtr<slang::IGlobalSession> compileGlobalSession = acquireGlobalSession();
+	{
+		Slang::ComPtr<slang::ISession> session = createSession(compileGlobalSession);
+		Slang::ComPtr<slang::IBlob> diagnostics;
+		Slang::ComPtr<slang::IModule> slangModule{ session->loadModuleFromSource(name.c_str(), filename.c_str(), nullptr, diagnostics.writeRef()) };
+		Slang::ComPtr<ISlangBlob> code;
+		if (!slangModule) {
+			const std::string message = diagnostics ? static_cast<const char*>(diagnostics->getBufferPointer()) : "";
+			std::cerr << "Could not compile " << filename << "\n" << message << "\n";
+			errorMessage = "Could not compile shader " + filename;
+		} else if (SLANG_FAILED(slangModule->getTargetCode(0, code.writeRef())) || !code) {
+			errorMessage = "Could not get SPIR-V for shader " + filename;
+		} else {
+			spirv.resize(code->getBufferSize() / sizeof(uint32_t));
+			memcpy(spirv.data(), code->getBufferPointer(), spirv.size() * sizeof(uint32_t));
+		}
+	}
+	releaseGlobalSession(compileGlobalSession);
+	if (!errorMessage.empty()) {
+		throw std::runtime_error(errorMessage);
+	}
+
+	if (!cacheFile.empty()) {
+		// Written to a temporary file first, so concurrent or interrupted runs never see partial cache entries
+		std::error_code error;
+		std::filesystem::create_directories(cacheDirectory, error);
+		const std::string tempFile = cacheFile + ".tmp" + std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id()));
+		std::ofstream file(tempFile, std::ios::binary);
+		if (file.is_open()) {
+			file.write(reinterpret_cast<const char*>(spirv.data()), spirv.size() * sizeof(uint32_t));
+			file.close();
+			std::filesystem::rename(tempFile, cacheFile, error);
+			if (error) {
+				std::filesystem::remove(tempFile, error);
+			}
+		}
+	}
+
+	return spirv;
+}
+
 SlangCompiler::SlangCompiler()
 {
 	slang::createGlobalSession(globalSession.writeRef());
-}
\ No newline at end of file
+	// The main global session also is the first one in the pool, so single threaded compiles don't create additional ones
+	releaseGlobalSession(globalSession);
+	// Needs to match the settings in createSession, the build tag ensures that a different compiler version won't use stale SPIR-V
+	optionsKey = std::string("spirv_1_6;EmitSpirvDirectly=1;column_major;") + globalSession->getBuildTagString();
+}
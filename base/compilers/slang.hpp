@@ -13,16 +13,38 @@
 #include <vector>
 #include <iostream>
 #include <array>
+#include <set>
+#include <atomic>
+#include <mutex>
 #include "volk.h"
 #include "slang/slang.h"
 #include "slang/slang-com-ptr.h"
 #include "VulkanContext.h"
 
 class SlangCompiler {
+private:
+	// Compiler settings that affect the generated code, part of the cache key
+	std::string optionsKey;
+	// Global sessions must not be used by multiple threads at the same time, so concurrent compiles each get their own
+	std::vector<Slang::ComPtr<slang::IGlobalSession>> idleGlobalSessions;
+	std::mutex globalSessionMutex;
+	Slang::ComPtr<slang::IGlobalSession> acquireGlobalSession();
+	void releaseGlobalSession(Slang::ComPtr<slang::IGlobalSession> session);
+	Slang::ComPtr<slang::ISession> createSession(slang::IGlobalSession* session);
+	void hashSourceFile(const std::string& filename, uint64_t& hash, std::set<std::string>& visited);
 public:
 	Slang::ComPtr<slang::IGlobalSession> globalSession;
+	// Compiled SPIR-V is stored in this directory, keyed by a hash of the shader source, its includes and the compiler options
+	// Caching is disabled if empty
+	std::string cacheDirectory{ "" };
+	std::atomic<uint32_t> cacheHits{ 0 };
+	std::atomic<uint32_t> cacheMisses{ 0 };
+	// Uses the main global session, must not be called while other threads are compiling
 	Slang::ComPtr<slang::ISession> createSession();
+	// Returns the SPIR-V for all entry points in the given file, from the cache if possible
+	// Can be called from multiple threads
+	std::vector<uint32_t> compile(const std::string& name, const std::string& filename);
 	SlangCompiler();
 };
 
-extern SlangCompiler* slangCompiler;
\ No newline at end of file
+extern SlangCompiler* slangCompiler;
@@ -0,0 +1,278 @@
+/*
+* Packed asset archive
+*
+* A single file containing all game assets in the form they're used at runtime (decoded or block compressed images, the parsed monster table, encoded audio)
+* The file starts with a fixed size header followed by the payloads and an index of fixed size entries at the end
+* At runtime the archive is memory mapped, so payloads can be copied straight from the page cache (e.g. into staging buffers) without reading them into heap memory first
+* Archives are written by the asset packer (tools/assetpacker)
+*
+* Copyright (C) 2026 by Sascha Willems - www.saschawillems.de
+*
+* This code is licensed under the MIT license (MIT) (http://opensource.org/licenses/MIT)
+*/
+
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <cstring>
+#include <algorithm>
+#include <stdint.h>
+#if defined(_WIN32)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace vks
+{
+	enum class AssetArchiveEntryType : uint32_t
+	{
+		// Image in the given format with mipLevels levels stored back to back, starting with the largest
+		Image = 1,
+		// Monster types, serialized by Game::ObjectTypes::MonsterTypes
+		MonsterTable = 2,
+		// Audio files are stored as is, they're decoded (or streamed) by the audio library
+		Sound = 3,
+		Music = 4,
+	};
+
+	enum class AssetArchiveImageFormat : uint32_t
+	{
+		None = 0,
+		RGBA8 = 1,
+		// 4 x 4 texel blocks of 16 bytes each
+		BC3 = 2,
+	};
+
+	struct AssetArchiveHeader
+	{
+		char magic[4]{ 'V', 'T', 'A', 'R' };
+		uint32_t version{ 2 };
+		uint32_t entryCount{ 0 };
+		uint32_t entrySize{ 0 };
+		uint64_t indexOffset{ 0 };
+	};
+
+	struct AssetArchiveEntry
+	{
+		// Path relative to the asset directory with forward slashes, e.g. "game/numbers/num_0.png"
+		char name[88]{};
+		AssetArchiveEntryType type{ AssetArchiveEntryType::Image };
+		AssetArchiveImageFormat format{ AssetArchiveImageFormat::None };
+		uint32_t width{ 0 };
+		uint32_t height{ 0 };
+		uint32_t mipLevels{ 1 };
+		uint32_t reserved{ 0 };
+		uint64_t offset{ 0 };
+		uint64_t size{ 0 };
+	};
+
+	static_assert(sizeof(AssetArchiveHeader) == 24);
+	static_assert(sizeof(AssetArchiveEntry) == 128);
+
+	// Payloads start at multiples of this, so they can be copied to staging buffers with aligned offsets
+	constexpr uint64_t assetArchiveAlignment = 16;
+
+	// Expected payload size of an image entry (all mip levels), returns 0 for images that can't be valid (e.g. unknown formats or more mip levels than the image has)
+	// Image data is copied to the GPU based on the dimensions, so entries whose size doesn't match this must not be used
+	inline uint64_t getAssetArchiveImageSize(AssetArchiveImageFormat format, uint32_t width, uint32_t height, uint32_t mipLevels)
+	{
+		// Also keeps the calculation from overflowing for corrupted entries
+		constexpr uint32_t maxDimension = 1u << 16;
+		if ((width == 0) || (height == 0) || (width > maxDimension) || (height > maxDimension) || (mipLevels == 0) || (mipLevels > 32) || ((std::max(width, height) >> (mipLevels - 1)) == 0))
+		{
+			return 0;
+		}
+		uint64_t size{ 0 };
+		for (uint32_t level = 0; level < mipLevels; level++)
+		{
+			const uint64_t levelWidth = std::max(width >> level, 1u);
+			const uint64_t levelHeight = std::max(height >> level, 1u);
+			switch (format)
+			{
+			case AssetArchiveImageFormat::RGBA8:
+				size += levelWidth * levelHeight * 4;
+				break;
+			case AssetArchiveImageFormat::BC3:
+				size += ((levelWidth + 3) / 4) * ((levelHeight + 3) / 4) * 16;
+				break;
+			default:
+				return 0;
+			}
+		}
+		return size;
+	}
+
+	class AssetArchive
+	{
+	private:
+		const uint8_t* data{ nullptr };
+		uint64_t size{ 0 };
+		std::unordered_map<std::string_view, const AssetArchiveEntry*> entries{};
+#if defined(_WIN32)
+		HANDLE file{ INVALID_HANDLE_VALUE };
+		HANDLE mapping{ nullptr };
+#endif
+
+		void unmap()
+		{
+#if defined(_WIN32)
+			if (data)
+			{
+				UnmapViewOfFile(data);
+			}
+			if (mapping)
+			{
+				CloseHandle(mapping);
+			}
+			if (file != INVALID_HANDLE_VALUE)
+			{
+				CloseHandle(file);
+			}
+			file = INVALID_HANDLE_VALUE;
+			mapping = nullptr;
+#else
+			if (data)
+			{
+				munmap(const_cast<uint8_t*>(data), size);
+			}
+#endif
+			data = nullptr;
+			size = 0;
+			entries.clear();
+		}
+
+		bool map(const std::string& filename)
+		{
+#if defined(_WIN32)
+			file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+			if (file == INVALID_HANDLE_VALUE)
+			{
+				return false;
+			}
+			LARGE_INTEGER fileSize{};
+			if (!GetFileSizeEx(file, &fileSize) || (fileSize.QuadPart == 0))
+			{
+				return false;
+			}
+			mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+			if (!mapping)
+			{
+				return false;
+			}
+			data = static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+			size = static_cast<uint64_t>(fileSize.QuadPart);
+			return data != nullptr;
+#else
+			const int fd = ::open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+			if (fd < 0)
+			{
+				return false;
+			}
+			struct stat info{};
+			if ((fstat(fd, &info) != 0) || (info.st_size == 0))
+			{
+				::close(fd);
+				return false;
+			}
+			void* mapped = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+			// The mapping stays valid after closing the file
+			::close(fd);
+			if (mapped == MAP_FAILED)
+			{
+				return false;
+			}
+			data = static_cast<const uint8_t*>(mapped);
+			size = static_cast<uint64_t>(info.st_size);
+			return true;
+#endif
+		}
+
+	public:
+		AssetArchive() = default;
+		AssetArchive(const AssetArchive&) = delete;
+		AssetArchive& operator=(const AssetArchive&) = delete;
+
+		~AssetArchive()
+		{
+			unmap();
+		}
+
+		// Maps the archive and reads its index, returns false if the file doesn't exist or isn't a valid archive
+		bool open(const std::string& filename)
+		{
+			unmap();
+			if (!map(filename))
+			{
+				unmap();
+				return false;
+			}
+			const AssetArchiveHeader expected{};
+			AssetArchiveHeader header{};
+			if (size < sizeof(AssetArchiveHeader))
+			{
+				unmap();
+				return false;
+			}
+			memcpy(&header, data, sizeof(AssetArchiveHeader));
+			if ((memcmp(header.magic, expected.magic, sizeof(header.magic)) != 0) || (header.version != expected.version) || (header.entrySize != sizeof(AssetArchiveEntry)))
+			{
+				unmap();
+				return false;
+			}
+			if ((header.indexOffset % alignof(AssetArchiveEntry) != 0) || (header.indexOffset > size) || (static_cast<uint64_t>(header.entryCount) * sizeof(AssetArchiveEntry) > size - header.indexOffset))
+			{
+				unmap();
+				return false;
+			}
+			const AssetArchiveEntry* index = reinterpret_cast<const AssetArchiveEntry*>(data + header.indexOffset);
+			for (uint32_t i = 0; i < header.entryCount; i++)
+			{
+				const AssetArchiveEntry& entry = index[i];
+				if ((entry.offset > size) || (entry.size > size - entry.offset) || (entry.name[sizeof(entry.name) - 1] != '\0'))
+				{
+					unmap();
+					return false;
+				}
+				entries[std::string_view(entry.name)] = &entry;
+			}
+			return true;
+		}
+
+		bool isOpen() const
+		{
+			return data != nullptr;
+		}
+
+		// Returns nullptr if the archive doesn't contain the asset
+		const AssetArchiveEntry* find(std::string_view name) const
+		{
+			auto it = entries.find(name);
+			return (it != entries.end()) ? it->second : nullptr;
+		}
+
+		// Pointer into the mapped archive, valid as long as the archive is open
+		const void* getData(const AssetArchiveEntry& entry) const
+		{
+			return data + entry.offset;
+		}
+
+		uint32_t getEntryCount() const
+		{
+			return static_cast<uint32_t>(entries.size());
+		}
+
+		uint64_t getSize() const
+		{
+			return size;
+		}
+	};
+}
@@ -19,6 +19,17 @@ void AudioManager::addSoundFile(const std::string name, const std::string filena
 	}
 }
 
+void AudioManager::addSoundFromMemory(const std::string name, const void* data, size_t size)
+{
+	auto soundBuffer = new sf::SoundBuffer;
+	if (soundBuffer->loadFromMemory(data, size)) {
+		soundBuffers[name] = soundBuffer;
+	} else {
+		std::cout << "Error: Could not load sound " << name << " from memory\n";
+		delete soundBuffer;
+	}
+}
+
 void AudioManager::playSnd(const std::string name)
 {
 	sound.setBuffer(*soundBuffers[name]);
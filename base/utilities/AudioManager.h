@@ -23,6 +23,8 @@ public:
 	uint32_t musicVolume{ 100 };
 	std::unordered_map<std::string, sf::SoundBuffer*> soundBuffers;
 	void addSoundFile(const std::string name, const std::string filename);
+	// Data needs to contain a complete sound file (e.g. from an asset archive)
+	void addSoundFromMemory(const std::string name, const void* data, size_t size);
 	// Named like this to avoid a WinApi macro (PlaySoundA)
 	void playSnd(const std::string name);
 };
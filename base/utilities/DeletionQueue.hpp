@@ -0,0 +1,88 @@
+/*
+* Deferred deletion of GPU resources
+*
+* Resources that may still be used by frames in flight are retired with the number of the frame that's currently being recorded
+* and only destroyed once the GPU has finished that frame, so replacing resources at runtime doesn't need to wait for the device to become idle
+*
+* Copyright (C) 2026 by Sascha Willems - www.saschawillems.de
+*
+* This code is licensed under the MIT license (MIT) (http://opensource.org/licenses/MIT)
+*/
+
+#pragma once
+
+#include <deque>
+#include <mutex>
+#include <functional>
+#include <stdint.h>
+
+namespace vks
+{
+	class DeletionQueue
+	{
+	private:
+		struct Entry
+		{
+			uint64_t frameNumber{ 0 };
+			std::function<void()> deleter;
+		};
+		// Frame numbers only increase, so entries are sorted by frame number
+		std::deque<Entry> entries;
+		uint64_t frameNumber{ 0 };
+		std::mutex mutex;
+	public:
+		// Sets the number of the frame that's currently being recorded, resources retired from now on are destroyed after it has finished
+		void setFrameNumber(uint64_t frameNumber)
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			this->frameNumber = frameNumber;
+		}
+
+		// Calls the deleter once all frames that may use the resource have finished
+		void push(std::function<void()> deleter)
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			entries.push_back({ .frameNumber = frameNumber, .deleter = std::move(deleter) });
+		}
+
+		// Deletes an object of one of the resource wrapper classes (e.g. Buffer, Pipeline, DescriptorSet, Texture) once it's no longer in use
+		template<typename T>
+		void retire(T* resource)
+		{
+			if (resource)
+			{
+				push([resource]() { delete resource; });
+			}
+		}
+
+		// Destroys all resources retired in frames up to and including the given (completed) frame number
+		void flush(uint64_t completedFrameNumber)
+		{
+			std::deque<Entry> completed;
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				while (!entries.empty() && entries.front().frameNumber <= completedFrameNumber)
+				{
+					completed.push_back(std::move(entries.front()));
+					entries.pop_front();
+				}
+			}
+			for (auto& entry : completed)
+			{
+				entry.deleter();
+			}
+		}
+
+		// Destroys all retired resources, the device must be idle
+		void flushAll()
+		{
+			flush(UINT64_MAX);
+		}
+
+		size_t size()
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			return entries.size();
+		}
+	};
+}
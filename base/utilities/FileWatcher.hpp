@@ -1,7 +1,9 @@
 /*
  * File change watcher class
  *
- * Copyright (C) 2023-2025 by Sascha Willems - www.saschawillems.de
+ * On Linux changes are reported by inotify, other platforms (or systems where inotify can't be initialized) poll the file modification times
+ *
+ * Copyright (C) 2023-2026 by Sascha Willems - www.saschawillems.de
  *
  * This code is licensed under the MIT license (MIT) (http://opensource.org/licenses/MIT)
  */
@@ -12,11 +14,21 @@
 #include <string>
 #include <chrono>
 #include <thread>
+#include <mutex>
+#include <atomic>
 #include <unordered_map>
 #include <filesystem>
 #include <iostream>
 #include <functional>
+#include <algorithm>
 #include "Pipeline.hpp"
+#if defined(__linux__) && !defined(__ANDROID__)
+#include <sys/inotify.h>
+#include <sys/eventfd.h>
+#include <poll.h>
+#include <unistd.h>
+#define FILEWATCHER_INOTIFY
+#endif
 
 struct FileWatchInfo {
     std::filesystem::file_time_type filetime;
@@ -27,33 +39,169 @@ class FileWatcher {
 private:
     std::thread thread;
     std::unordered_map<std::string, FileWatchInfo> files{};
+	std::mutex filesMutex;
 	std::chrono::duration<int, std::milli> interval{ 1000 };
-	bool active = true;
+	// Editors often write a file several times in a row when saving, changes are only reported once no further events arrived for this long
+	std::chrono::duration<int, std::milli> debounce{ 100 };
+	std::atomic<bool> active = true;
+
+	static std::filesystem::file_time_type getFileTime(const std::string& filename) {
+		// Files may briefly not exist while an editor replaces them
+		std::error_code error;
+		return std::filesystem::last_write_time(filename, error);
+	}
+
+	void notify(const std::vector<std::string>& changedFiles) {
+		for (auto& filename : changedFiles) {
+			std::vector<void*> owners;
+			{
+				std::lock_guard<std::mutex> lock(filesMutex);
+				owners = files[filename].owners;
+			}
+			onFileChanged(filename, owners);
+		}
+	}
 
+	// Fallback if there is no event based backend
     void watch() {
         while (active) {
             std::this_thread::sleep_for(interval);
 
             // Check if files have been modified
-            for (auto& file : files) {
-                auto current_file_last_write_time = std::filesystem::last_write_time(file.first);
-                if (file.second.filetime != current_file_last_write_time) {
-                    files[file.first].filetime = current_file_last_write_time;
-                    onFileChanged(file.first, file.second.owners);
-                }
-            }
+			std::vector<std::string> changedFiles;
+			{
+				std::lock_guard<std::mutex> lock(filesMutex);
+				for (auto& file : files) {
+					auto current_file_last_write_time = getFileTime(file.first);
+					if (file.second.filetime != current_file_last_write_time) {
+						file.second.filetime = current_file_last_write_time;
+						changedFiles.push_back(file.first);
+					}
+				}
+			}
+			notify(changedFiles);
         }
     }
 
+#if defined(FILEWATCHER_INOTIFY)
+	int inotifyFd{ -1 };
+	// Used to wake up the watcher thread when stopping
+	int stopFd{ -1 };
+	// Directories are watched instead of files, as saving via a temporary file and a rename replaces the watched file
+	std::unordered_map<int, std::filesystem::path> watchedDirectories{};
+	// Maps the normalized path of a watched file to the name it was added with
+	std::unordered_map<std::string, std::string> normalizedFileNames{};
+
+	static std::string normalizePath(const std::filesystem::path& path) {
+		std::error_code error;
+		std::filesystem::path normalized = std::filesystem::weakly_canonical(path, error);
+		return (error ? path.lexically_normal() : normalized).string();
+	}
+
+	void addWatch(const std::string& filename) {
+		if (inotifyFd < 0) {
+			return;
+		}
+		const std::filesystem::path directory = std::filesystem::path(normalizePath(filename)).parent_path();
+		normalizedFileNames[normalizePath(filename)] = filename;
+		const int wd = inotify_add_watch(inotifyFd, directory.string().c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+		if (wd < 0) {
+			std::cerr << "Could not watch " << directory << " for changes\n";
+			return;
+		}
+		// Adding an existing directory returns its watch descriptor again
+		watchedDirectories[wd] = directory;
+	}
+
+	void watchEvents() {
+		std::vector<std::string> pendingFiles;
+		auto lastEvent = std::chrono::steady_clock::now();
+		alignas(inotify_event) char buffer[4096];
+		while (active) {
+			pollfd fds[2] = {
+				{ .fd = inotifyFd, .events = POLLIN },
+				{ .fd = stopFd, .events = POLLIN },
+			};
+			// Sleep until something happens, or until the debounce time for pending changes has passed
+			int timeout = -1;
+			if (!pendingFiles.empty()) {
+				const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - lastEvent);
+				timeout = static_cast<int>(std::max<int64_t>(0, (debounce - elapsed).count()));
+			}
+			const int result = poll(fds, 2, timeout);
+			if (!active) {
+				break;
+			}
+			if (result < 0) {
+				continue;
+			}
+			if (fds[0].revents & POLLIN) {
+				const ssize_t length = read(inotifyFd, buffer, sizeof(buffer));
+				std::lock_guard<std::mutex> lock(filesMutex);
+				for (ssize_t offset = 0; offset < length; ) {
+					const inotify_event* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+					offset += sizeof(inotify_event) + event->len;
+					if (event->len == 0 || watchedDirectories.find(event->wd) == watchedDirectories.end()) {
+						continue;
+					}
+					auto file = normalizedFileNames.find((watchedDirectories[event->wd] / event->name).string());
+					if (file == normalizedFileNames.end()) {
+						continue;
+					}
+					if (std::find(pendingFiles.begin(), pendingFiles.end(), file->second) == pendingFiles.end()) {
+						pendingFiles.push_back(file->second);
+					}
+					lastEvent = std::chrono::steady_clock::now();
+				}
+			}
+			if (!pendingFiles.empty() && (std::chrono::steady_clock::now() - lastEvent >= debounce)) {
+				notify(pendingFiles);
+				pendingFiles.clear();
+			}
+		}
+	}
+#endif
+
 public:
     std::function<void(const std::string, const std::vector<void*> owners)> onFileChanged;
 
+	FileWatcher() {
+#if defined(FILEWATCHER_INOTIFY)
+		inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+		stopFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+		if (inotifyFd < 0 || stopFd < 0) {
+			std::cerr << "Could not initialize inotify, falling back to polling for file changes\n";
+			if (inotifyFd >= 0) {
+				close(inotifyFd);
+			}
+			if (stopFd >= 0) {
+				close(stopFd);
+			}
+			inotifyFd = -1;
+			stopFd = -1;
+		}
+#endif
+	}
+
+	~FileWatcher() {
+#if defined(FILEWATCHER_INOTIFY)
+		if (inotifyFd >= 0) {
+			close(inotifyFd);
+			close(stopFd);
+		}
+#endif
+	}
+
 	void addFile(const std::string filename, void* owner) {
+		std::lock_guard<std::mutex> lock(filesMutex);
         if (files.find(filename) == files.end()) {
             files[filename] = FileWatchInfo{
-                .filetime = std::filesystem::last_write_time(filename),
+                .filetime = getFileTime(filename),
                 .owners = { owner }
             };
+#if defined(FILEWATCHER_INOTIFY)
+			addWatch(filename);
+#endif
         } else {
             // If the file is already present, only attach userData to the list, so the owning object gets properly notified
             files[filename].owners.push_back(owner);
@@ -66,12 +214,24 @@ public:
 
 	void start() {
         active = true;
+#if defined(FILEWATCHER_INOTIFY)
+		if (inotifyFd >= 0) {
+			thread = std::thread(&FileWatcher::watchEvents, this);
+			return;
+		}
+#endif
         thread = std::thread(&FileWatcher::watch, this);
 	}
 
     void stop() {
         active = false;
+#if defined(FILEWATCHER_INOTIFY)
+		if (stopFd >= 0) {
+			const uint64_t value = 1;
+			[[maybe_unused]] ssize_t written = write(stopFd, &value, sizeof(value));
+		}
+#endif
         thread.join();
     }
 
-};
\ No newline at end of file
+};
@@ -0,0 +1,340 @@
+/*
+* Work-stealing job system
+*
+* Each worker owns a lock-free Chase-Lev deque (see "Dynamic Circular Work-Stealing Deque" by Chase and Lev,
+* and "Correct and Efficient Work-Stealing for Weak Memory Models" by Lê et al.)
+* Workers push and pop jobs at the bottom of their own deque, idle workers steal from the top of other workers' deques
+* The thread that creates the job system is registered as worker 0 and takes part in running jobs while waiting
+*
+* Copyright (C) 2026 by Sascha Willems - www.saschawillems.de
+*
+* This code is licensed under the MIT license (MIT) (http://opensource.org/licenses/MIT)
+*/
+
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <array>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <algorithm>
+#include <stdint.h>
+
+namespace vks
+{
+	// Tracks completion of a group of jobs, each job decrements the counter once it has finished
+	class JobCounter
+	{
+	private:
+		std::atomic<uint32_t> value{ 0 };
+		friend class JobSystem;
+	public:
+		bool done() const
+		{
+			return value.load(std::memory_order_acquire) == 0;
+		}
+	};
+
+	struct Job
+	{
+		std::function<void()> function;
+		JobCounter* counter{ nullptr };
+	};
+
+	// Fixed-size lock-free work-stealing deque
+	// push and pop may only be called by the owning worker, steal may be called from any thread
+	class JobDeque
+	{
+	private:
+		static constexpr int64_t capacity = 4096;
+		static constexpr int64_t mask = capacity - 1;
+		alignas(64) std::atomic<int64_t> top{ 0 };
+		alignas(64) std::atomic<int64_t> bottom{ 0 };
+		std::array<std::atomic<Job*>, capacity> buffer{};
+	public:
+		// Returns false if the deque is full
+		bool push(Job* job)
+		{
+			const int64_t b = bottom.load(std::memory_order_relaxed);
+			const int64_t t = top.load(std::memory_order_acquire);
+			if (b - t >= capacity)
+			{
+				return false;
+			}
+			buffer[b & mask].store(job, std::memory_order_relaxed);
+			// Publishes the job to thieves
+			bottom.store(b + 1, std::memory_order_release);
+			return true;
+		}
+
+		Job* pop()
+		{
+			const int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+			bottom.store(b, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			int64_t t = top.load(std::memory_order_relaxed);
+			if (t > b)
+			{
+				// Empty
+				bottom.store(b + 1, std::memory_order_relaxed);
+				return nullptr;
+			}
+			Job* job = buffer[b & mask].load(std::memory_order_relaxed);
+			if (t == b)
+			{
+				// Last job, race against thieves
+				if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+				{
+					job = nullptr;
+				}
+				bottom.store(b + 1, std::memory_order_relaxed);
+			}
+			return job;
+		}
+
+		Job* steal()
+		{
+			int64_t t = top.load(std::memory_order_acquire);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			const int64_t b = bottom.load(std::memory_order_acquire);
+			if (t >= b)
+			{
+				return nullptr;
+			}
+			Job* job = buffer[t & mask].load(std::memory_order_relaxed);
+			if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+			{
+				// Lost the race against another thief or the owner
+				return nullptr;
+			}
+			return job;
+		}
+	};
+
+	class JobSystem
+	{
+	private:
+		// Identifies the job system and worker index of the current thread
+		struct WorkerInfo
+		{
+			JobSystem* owner{ nullptr };
+			uint32_t index{ 0 };
+		};
+		static WorkerInfo& currentWorker()
+		{
+			static thread_local WorkerInfo info{};
+			return info;
+		}
+
+		std::vector<std::unique_ptr<JobDeque>> deques;
+		std::vector<std::thread> workers;
+		std::atomic<bool> stopping{ false };
+		std::atomic<uint32_t> pendingJobs{ 0 };
+		std::atomic<uint32_t> sleepingWorkers{ 0 };
+		std::mutex sleepMutex;
+		std::condition_variable sleepCondition;
+		// Jobs submitted from threads that are not part of this job system, or that didn't fit into a full deque
+		std::deque<Job*> sharedQueue;
+		std::mutex sharedQueueMutex;
+
+		void notify()
+		{
+			{
+				std::lock_guard<std::mutex> lock(sleepMutex);
+			}
+			sleepCondition.notify_one();
+		}
+
+		void submit(Job* job)
+		{
+			if (job->counter)
+			{
+				job->counter->value.fetch_add(1, std::memory_order_relaxed);
+			}
+			const bool isWorker = (currentWorker().owner == this);
+			if (!isWorker || !deques[currentWorker().index]->push(job))
+			{
+				std::lock_guard<std::mutex> lock(sharedQueueMutex);
+				sharedQueue.push_back(job);
+			}
+			// Both counters are sequentially consistent, so either this sees a sleeping worker or that worker sees the new job
+			pendingJobs.fetch_add(1, std::memory_order_seq_cst);
+			if (sleepingWorkers.load(std::memory_order_seq_cst) > 0)
+			{
+				notify();
+			}
+		}
+
+		Job* takeSharedJob()
+		{
+			std::lock_guard<std::mutex> lock(sharedQueueMutex);
+			if (sharedQueue.empty())
+			{
+				return nullptr;
+			}
+			Job* job = sharedQueue.front();
+			sharedQueue.pop_front();
+			return job;
+		}
+
+		// Own deque first (most recent job, likely still in cache), then the shared queue, then steal from other workers
+		Job* findJob(uint32_t workerIndex)
+		{
+			Job* job = deques[workerIndex]->pop();
+			if (!job)
+			{
+				job = takeSharedJob();
+			}
+			const uint32_t count = static_cast<uint32_t>(deques.size());
+			for (uint32_t i = 1; !job && i < count; i++)
+			{
+				job = deques[(workerIndex + i) % count]->steal();
+			}
+			if (job)
+			{
+				pendingJobs.fetch_sub(1, std::memory_order_acq_rel);
+			}
+			return job;
+		}
+
+		void execute(Job* job)
+		{
+			job->function();
+			if (job->counter)
+			{
+				job->counter->value.fetch_sub(1, std::memory_order_release);
+			}
+			delete job;
+		}
+
+		void workerLoop(uint32_t workerIndex)
+		{
+			currentWorker() = { .owner = this, .index = workerIndex };
+			while (true)
+			{
+				if (Job* job = findJob(workerIndex))
+				{
+					execute(job);
+					continue;
+				}
+				std::unique_lock<std::mutex> lock(sleepMutex);
+				sleepingWorkers.fetch_add(1, std::memory_order_seq_cst);
+				sleepCondition.wait(lock, [this] { return pendingJobs.load(std::memory_order_seq_cst) > 0 || stopping; });
+				sleepingWorkers.fetch_sub(1, std::memory_order_relaxed);
+				if (stopping)
+				{
+					break;
+				}
+			}
+		}
+
+	public:
+		// Starts workerCount background workers, defaults to one less than the no. of hardware threads as the creating thread also runs jobs
+		JobSystem(uint32_t workerCount = 0)
+		{
+			if (workerCount == 0)
+			{
+				workerCount = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+			}
+			// Index 0 is the creating thread
+			for (uint32_t i = 0; i < workerCount + 1; i++)
+			{
+				deques.push_back(std::make_unique<JobDeque>());
+			}
+			currentWorker() = { .owner = this, .index = 0 };
+			for (uint32_t i = 1; i < workerCount + 1; i++)
+			{
+				workers.emplace_back(&JobSystem::workerLoop, this, i);
+			}
+		}
+
+		~JobSystem()
+		{
+			{
+				std::lock_guard<std::mutex> lock(sleepMutex);
+				stopping = true;
+			}
+			sleepCondition.notify_all();
+			for (auto& worker : workers)
+			{
+				worker.join();
+			}
+			// Jobs that were never run
+			while (Job* job = takeSharedJob())
+			{
+				delete job;
+			}
+			for (auto& deque : deques)
+			{
+				while (Job* job = deque->steal())
+				{
+					delete job;
+				}
+			}
+			if (currentWorker().owner == this)
+			{
+				currentWorker() = {};
+			}
+		}
+
+		JobSystem(const JobSystem&) = delete;
+		JobSystem& operator=(const JobSystem&) = delete;
+
+		// No. of threads running jobs, including the creating thread
+		uint32_t getThreadCount() const
+		{
+			return static_cast<uint32_t>(deques.size());
+		}
+
+		// Adds a job, if a counter is passed it's incremented now and decremented once the job has finished
+		void run(std::function<void()> function, JobCounter* counter = nullptr)
+		{
+			submit(new Job{ .function = std::move(function), .counter = counter });
+		}
+
+		// Splits [begin, end) into ranges of at most grainSize elements and runs function(rangeBegin, rangeEnd) for each of them as a separate job
+		// Larger grain sizes lower scheduling overhead, smaller ones allow better balancing across workers
+		void parallelFor(size_t begin, size_t end, size_t grainSize, std::function<void(size_t, size_t)> function, JobCounter& counter)
+		{
+			grainSize = std::max(grainSize, size_t(1));
+			for (size_t rangeBegin = begin; rangeBegin < end; rangeBegin += grainSize)
+			{
+				const size_t rangeEnd = std::min(rangeBegin + grainSize, end);
+				run([function, rangeBegin, rangeEnd] { function(rangeBegin, rangeEnd); }, &counter);
+			}
+		}
+
+		// Blocking version of the above
+		void parallelFor(size_t begin, size_t end, size_t grainSize, std::function<void(size_t, size_t)> function)
+		{
+			JobCounter counter;
+			parallelFor(begin, end, grainSize, std::move(function), counter);
+			wait(counter);
+		}
+
+		// Waits until all jobs tracked by the counter have finished
+		// If called from a thread of this job system, that thread runs pending jobs instead of blocking
+		void wait(JobCounter& counter)
+		{
+			const bool isWorker = (currentWorker().owner == this);
+			while (!counter.done())
+			{
+				Job* job = isWorker ? findJob(currentWorker().index) : nullptr;
+				if (job)
+				{
+					execute(job);
+				}
+				else
+				{
+					std::this_thread::yield();
+				}
+			}
+		}
+	};
+
+}
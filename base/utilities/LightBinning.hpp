@@ -0,0 +1,75 @@
+/*
+* CPU reference for the tiled lighting
+*
+* Lights are binned into screen tiles by a compute shader (lightcull.slang), the functions in here do the same on the host
+* They don't depend on Vulkan, so they can be tested without a device and used to validate the tiles read back from the GPU
+*
+* Copyright (C) 2026 by Sascha Willems - www.saschawillems.de
+*
+* This code is licensed under the MIT license (MIT) (http://opensource.org/licenses/MIT)
+*/
+
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <stdint.h>
+#include "glm/glm.hpp"
+
+// Matches the layout of the light buffer read by the shaders
+struct LightSource {
+	alignas(16) glm::vec2 pos{ 0.0f };
+	alignas(16) glm::vec3 color{ 1.0f };
+	float radius;
+};
+
+// Lights are binned into screen tiles of this size (in pixels) by a compute shader, so the post process only iterates the lights of a pixel's tile
+// Needs to match lightTileSize in lightcull.slang and postprocess.slang
+constexpr uint32_t lightTileSize = 16;
+// Tiles with more lights fall back to iterating all lights
+constexpr uint32_t maxLightsPerTile = 128;
+
+// CPU reference for the light binning done in lightcull.slang, returns the indices of the lights affecting each tile
+// Light positions are in uv space, the horizontal distance is scaled by viewportAR like in the shaders
+// The light radii are scaled by radiusScale, which lets callers account for floating point differences between host and device
+inline std::vector<std::vector<uint32_t>> binLights(const LightSource* lights, uint32_t lightCount, glm::uvec2 tileCount, glm::vec2 screenRes, float viewportAR, float radiusScale = 1.0f)
+{
+	std::vector<std::vector<uint32_t>> tiles(static_cast<size_t>(tileCount.x) * tileCount.y);
+	for (uint32_t y = 0; y < tileCount.y; y++) {
+		for (uint32_t x = 0; x < tileCount.x; x++) {
+			const glm::vec2 tileMin = glm::vec2(x, y) * static_cast<float>(lightTileSize) / screenRes;
+			const glm::vec2 tileMax = glm::vec2(x + 1, y + 1) * static_cast<float>(lightTileSize) / screenRes;
+			for (uint32_t i = 0; i < lightCount; i++) {
+				glm::vec2 d = glm::clamp(lights[i].pos, tileMin, tileMax) - lights[i].pos;
+				d.x *= viewportAR;
+				const float radius = lights[i].radius * radiusScale;
+				if (glm::dot(d, d) < radius * radius) {
+					tiles[y * tileCount.x + x].push_back(i);
+				}
+			}
+		}
+	}
+	return tiles;
+}
+
+// Compares binned light tiles in the layout written by lightcull.slang (a count per tile and maxLightsPerTile indices per tile) against the CPU reference, returns the no. of tiles that don't match
+// Lights within a tiny margin around the tile may be binned either way due to floating point differences, so a tile has to contain all lights that definitely affect it and none that definitely don't
+inline uint32_t countLightTileMismatches(const uint32_t* counts, const uint32_t* indices, const LightSource* lights, uint32_t lightCount, glm::uvec2 tileCount, glm::vec2 screenRes, float viewportAR)
+{
+	const auto inner = binLights(lights, lightCount, tileCount, screenRes, viewportAR, 0.9999f);
+	const auto outer = binLights(lights, lightCount, tileCount, screenRes, viewportAR, 1.0001f);
+	uint32_t mismatches{ 0 };
+	for (size_t tile = 0; tile < inner.size(); tile++) {
+		if (counts[tile] > maxLightsPerTile) {
+			// Overflowing tiles iterate all lights, which is only valid if the tile actually overflows
+			mismatches += (outer[tile].size() > maxLightsPerTile) ? 0 : 1;
+			continue;
+		}
+		std::vector<uint32_t> tileLights(indices + tile * maxLightsPerTile, indices + tile * maxLightsPerTile + counts[tile]);
+		std::sort(tileLights.begin(), tileLights.end());
+		const bool containsInner = std::includes(tileLights.begin(), tileLights.end(), inner[tile].begin(), inner[tile].end());
+		const bool withinOuter = std::includes(outer[tile].begin(), outer[tile].end(), tileLights.begin(), tileLights.end());
+		mismatches += (containsInner && withinOuter) ? 0 : 1;
+	}
+	return mismatches;
+}
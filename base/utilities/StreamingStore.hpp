@@ -0,0 +1,51 @@
+/*
+* Non-temporal (streaming) stores for filling write-combined memory like mapped ReBAR buffers
+*
+* Data written this way bypasses the caches, so it doesn't evict data the CPU still needs and isn't read back from device memory
+* Falls back to regular stores on platforms without SSE2
+*
+* Copyright (C) 2026 by Sascha Willems - www.saschawillems.de
+*
+* This code is licensed under the MIT license (MIT) (http://opensource.org/licenses/MIT)
+*/
+
+#pragma once
+
+#include <cstring>
+#include <stdint.h>
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define VKS_STREAMING_STORES
+#endif
+
+namespace vks
+{
+	namespace streaming
+	{
+		// Copies a single value to the (4 byte aligned) destination
+		template<typename T>
+		inline void store(T* dst, const T& src)
+		{
+			static_assert(sizeof(T) % 4 == 0, "Streaming stores require the size of the type to be a multiple of 4 bytes");
+#if defined(VKS_STREAMING_STORES)
+			int32_t* d = reinterpret_cast<int32_t*>(dst);
+			int32_t values[sizeof(T) / 4];
+			memcpy(values, &src, sizeof(T));
+			for (size_t i = 0; i < sizeof(T) / 4; i++)
+			{
+				_mm_stream_si32(d + i, values[i]);
+			}
+#else
+			memcpy(dst, &src, sizeof(T));
+#endif
+		}
+
+		// Streaming stores are weakly ordered, this needs to be called by every thread that did streaming stores before the data is consumed (e.g. submitted to the GPU)
+		inline void fence()
+		{
+#if defined(VKS_STREAMING_STORES)
+			_mm_sfence();
+#endif
+		}
+	}
+}
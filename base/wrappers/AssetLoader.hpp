@@ -0,0 +1,343 @@
+/*
+* Asynchronous image loader
+*
+* Images are decoded in parallel on the worker threads of a job system while the application continues with its setup
+* Images found in an asset archive are already decoded and are copied from the mapped archive into the staging buffer without any decoding
+* Block compressed images from the archive are used if the device supports them, the sprite atlas is only compressed if all of its images are
+* Their indices (into the sprite atlas or the application's texture list) are known as soon as they're requested, so they can be handed to
+* the game right away. Once all images have been decoded, the texture uploads are recorded into a single command buffer and submitted at once
+*
+* Copyright(C) 2026 by Sascha Willems - www.saschawillems.de
+*
+* This code is licensed under the MIT license(MIT) (http://opensource.org/licenses/MIT)
+*/
+
+#pragma once
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <iostream>
+#include <stdexcept>
+#include "volk.h"
+#include "stb_image.h"
+#include "JobSystem.hpp"
+#include "Texture.hpp"
+#include "TextureAtlas.hpp"
+#include "AssetArchive.hpp"
+
+namespace vks
+{
+	struct AssetLoaderCreateInfo {
+		JobSystem* jobSystem{ nullptr };
+		// Image names are relative to this path
+		std::string assetPath{ "" };
+		// Optional, images not contained in the archive are loaded from the asset path
+		const AssetArchive* archive{ nullptr };
+		// Sprites are packed into this atlas
+		TextureAtlas* atlas{ nullptr };
+		// Textures are appended to this list
+		std::vector<Texture2D*>* textures{ nullptr };
+	};
+
+	class AssetLoader {
+	private:
+		enum class Target { Atlas, Texture };
+		struct Request {
+			std::string filename{ "" };
+			Target target{ Target::Texture };
+			VkFormat format{ VK_FORMAT_R8G8B8A8_SRGB };
+			// Decoded from a loose file
+			unsigned char* pixels{ nullptr };
+			// Points into the mapped archive
+			const uint8_t* archivePixels{ nullptr };
+			// Created by the application instead of being loaded
+			std::vector<uint8_t> generatedPixels{};
+			int width{ 0 };
+			int height{ 0 };
+			// BC3 blocks with mipLevels levels (from the archive)
+			bool compressed{ false };
+			uint32_t mipLevels{ 1 };
+			VkDeviceSize compressedSize{ 0 };
+
+			const void* getPixels() const
+			{
+				if (!generatedPixels.empty()) {
+					return generatedPixels.data();
+				}
+				return archivePixels ? static_cast<const void*>(archivePixels) : static_cast<const void*>(pixels);
+			}
+
+			// Compressed images are uploaded including their mip chain
+			VkDeviceSize getUploadSize() const
+			{
+				return compressed ? compressedSize : static_cast<VkDeviceSize>(width) * height * 4;
+			}
+
+			// Falls back to decoding the loose file
+			void discardArchiveData()
+			{
+				archivePixels = nullptr;
+				compressed = false;
+				mipLevels = 1;
+				width = 0;
+				height = 0;
+			}
+		};
+		JobSystem* jobSystem{ nullptr };
+		std::string assetPath{ "" };
+		const AssetArchive* archive{ nullptr };
+		TextureAtlas* atlas{ nullptr };
+		std::vector<Texture2D*>* textures{ nullptr };
+		// Requests are never moved once added, as decode jobs write into them
+		std::vector<std::unique_ptr<Request>> requests{};
+		uint32_t atlasIndex{ 0 };
+		uint32_t textureIndex{ 0 };
+		JobCounter counter;
+		std::atomic<uint32_t> decodedCount{ 0 };
+		uint32_t archivedCount{ 0 };
+		std::chrono::high_resolution_clock::time_point tStart;
+		bool started{ false };
+
+		Request* add(const std::string& filename, Target target, VkFormat format = VK_FORMAT_R8G8B8A8_SRGB)
+		{
+			assert(!started);
+			requests.push_back(std::make_unique<Request>(Request{ .filename = filename, .target = target, .format = format }));
+			Request* request = requests.back().get();
+			const AssetArchiveEntry* entry = archive ? archive->find(filename) : nullptr;
+			if (!entry || (entry->type != AssetArchiveEntryType::Image)) {
+				return request;
+			}
+			// The image data (and for compressed images the copy region of each mip level) is derived from the dimensions, a truncated or stale entry would read past its data
+			if (entry->size != getAssetArchiveImageSize(entry->format, entry->width, entry->height, entry->mipLevels)) {
+				std::cerr << "Image " << filename << " in the asset archive is invalid, loading the file instead\n";
+				return request;
+			}
+			const bool compressed = (entry->format == AssetArchiveImageFormat::BC3);
+			if ((entry->format == AssetArchiveImageFormat::RGBA8) || (compressed && Device::enabledFeatures.textureCompressionBC)) {
+				request->archivePixels = static_cast<const uint8_t*>(archive->getData(*entry));
+				request->width = static_cast<int>(entry->width);
+				request->height = static_cast<int>(entry->height);
+				request->compressed = compressed;
+				request->mipLevels = compressed ? entry->mipLevels : 1;
+				request->compressedSize = compressed ? entry->size : 0;
+			}
+			return request;
+		}
+
+		static VkFormat getCompressedFormat(VkFormat format)
+		{
+			return (format == VK_FORMAT_R8G8B8A8_UNORM) ? VK_FORMAT_BC3_UNORM_BLOCK : VK_FORMAT_BC3_SRGB_BLOCK;
+		}
+
+		// The atlas can only use a compressed format if all of its images are compressed
+		void selectAtlasFormat()
+		{
+			if (!atlas) {
+				return;
+			}
+			bool compressed{ false };
+			bool uncompressed{ false };
+			for (auto& request : requests) {
+				if (request->target == Target::Atlas) {
+					compressed |= request->compressed;
+					uncompressed |= !request->compressed;
+				}
+			}
+			if (compressed && !uncompressed) {
+				atlas->setFormat(getCompressedFormat(atlas->getFormat()));
+				return;
+			}
+			for (auto& request : requests) {
+				if ((request->target == Target::Atlas) && request->compressed) {
+					request->discardArchiveData();
+				}
+			}
+		}
+
+		// Uploads all textures with a single submission
+		void uploadTextures()
+		{
+			// Buffer to image copies need offsets that are a multiple of the texel (or block) size
+			const auto align = [](VkDeviceSize offset) { return (offset + 15) & ~VkDeviceSize(15); };
+			VkDeviceSize stagingSize{ 0 };
+			for (auto& request : requests) {
+				if (request->target == Target::Texture) {
+					stagingSize = align(stagingSize) + request->getUploadSize();
+				}
+			}
+			if (stagingSize == 0) {
+				return;
+			}
+			Buffer* stagingBuffer = new Buffer({
+				.name = "Asset loader staging buffer",
+				.usageFlags = VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+				.size = stagingSize,
+				.map = true
+			});
+			// @todo: transfer queue (mip generation uses blits, which need a graphics queue)
+			VkCommandBuffer copyCmd = VulkanContext::device->createCommandBuffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY, true);
+			VkDeviceSize offset{ 0 };
+			for (auto& request : requests) {
+				if (request->target != Target::Texture) {
+					continue;
+				}
+				offset = align(offset);
+				const VkDeviceSize size = request->getUploadSize();
+				memcpy(static_cast<uint8_t*>(stagingBuffer->mapped) + offset, request->getPixels(), size);
+				textures->push_back(new Texture2D({
+					.buffer = static_cast<uint8_t*>(stagingBuffer->mapped) + offset,
+					.bufferSize = size,
+					.texWidth = static_cast<uint32_t>(request->width),
+					.texHeight = static_cast<uint32_t>(request->height),
+					.mipLevels = request->mipLevels,
+					.format = request->compressed ? getCompressedFormat(request->format) : request->format,
+					.createSampler = false,
+				}, copyCmd, stagingBuffer->buffer, offset));
+				offset += size;
+			}
+			stagingBuffer->flush();
+			VulkanContext::device->flushCommandBuffer(copyCmd, VulkanContext::graphicsQueue, true);
+			delete stagingBuffer;
+		}
+
+	public:
+		AssetLoader(AssetLoaderCreateInfo createInfo)
+		{
+			jobSystem = createInfo.jobSystem;
+			assetPath = createInfo.assetPath;
+			archive = createInfo.archive;
+			atlas = createInfo.atlas;
+			textures = createInfo.textures;
+			atlasIndex = atlas ? atlas->getImageCount() : 0;
+			textureIndex = textures ? static_cast<uint32_t>(textures->size()) : 0;
+		}
+
+		~AssetLoader()
+		{
+			// Decode jobs write into the requests
+			if (started) {
+				jobSystem->wait(counter);
+			}
+			for (auto& request : requests) {
+				if (request->pixels) {
+					stbi_image_free(request->pixels);
+				}
+			}
+		}
+
+		// Returns the index the image will have in the atlas, the filename is relative to the asset path
+		uint32_t addSprite(const std::string& filename)
+		{
+			assert(atlas);
+			add(filename, Target::Atlas);
+			return atlasIndex++;
+		}
+
+		// Returns the index the texture will have in the texture list, the filename is relative to the asset path
+		uint32_t addTexture(const std::string& filename, VkFormat format = VK_FORMAT_R8G8B8A8_SRGB)
+		{
+			assert(textures);
+			add(filename, Target::Texture, format);
+			return textureIndex++;
+		}
+
+		// Adds a texture from RGBA8 pixels in memory (e.g. a placeholder for a missing image), the name is only used for error messages
+		uint32_t addTexture(const std::string& name, std::vector<uint8_t> pixels, uint32_t width, uint32_t height, VkFormat format = VK_FORMAT_R8G8B8A8_SRGB)
+		{
+			assert(textures);
+			assert(pixels.size() == static_cast<size_t>(width) * height * 4);
+			assert(!started);
+			requests.push_back(std::make_unique<Request>(Request{ .filename = name, .target = Target::Texture, .format = format, .generatedPixels = std::move(pixels), .width = static_cast<int>(width), .height = static_cast<int>(height) }));
+			return textureIndex++;
+		}
+
+		// Starts decoding all requested images in the background
+		void start()
+		{
+			assert(!started);
+			started = true;
+			tStart = std::chrono::high_resolution_clock::now();
+			selectAtlasFormat();
+			for (auto& request : requests) {
+				if (!request->generatedPixels.empty()) {
+					decodedCount++;
+					continue;
+				}
+				if (request->archivePixels) {
+					archivedCount++;
+					decodedCount++;
+					continue;
+				}
+				Request* job = request.get();
+				jobSystem->run([this, job]() {
+					int channels;
+					job->pixels = stbi_load((assetPath + job->filename).c_str(), &job->width, &job->height, &channels, 4);
+					decodedCount++;
+				}, &counter);
+			}
+		}
+
+		uint32_t getRequestCount() const
+		{
+			return static_cast<uint32_t>(requests.size());
+		}
+
+		uint32_t getDecodedCount() const
+		{
+			return decodedCount.load();
+		}
+
+		// Fraction of images that have been decoded
+		float getProgress() const
+		{
+			return requests.empty() ? 1.0f : static_cast<float>(getDecodedCount()) / static_cast<float>(requests.size());
+		}
+
+		bool isDecoded() const
+		{
+			return counter.done();
+		}
+
+		// Waits for all images to be decoded, then adds the sprites to the atlas (in request order, so indices match) and uploads the textures
+		void finish()
+		{
+			assert(started);
+			uint32_t lastReported{ 0 };
+			while (!counter.done()) {
+				const uint32_t decoded = getDecodedCount();
+				if (decoded - lastReported >= 256) {
+					std::cout << "Loading images: " << decoded << " / " << requests.size() << "\n";
+					lastReported = decoded;
+				}
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			}
+			const auto tDecoded = std::chrono::high_resolution_clock::now();
+
+			for (auto& request : requests) {
+				if (!request->getPixels()) {
+					throw std::runtime_error("Could not load image " + assetPath + request->filename);
+				}
+				if (request->target == Target::Atlas) {
+					atlas->add(request->getPixels(), static_cast<uint32_t>(request->width), static_cast<uint32_t>(request->height));
+				}
+			}
+			if (atlas && (atlas->getImageCount() > 0)) {
+				atlas->build();
+			}
+			uploadTextures();
+
+			for (auto& request : requests) {
+				if (request->pixels) {
+					stbi_image_free(request->pixels);
+					request->pixels = nullptr;
+				}
+			}
+			const auto tEnd = std::chrono::high_resolution_clock::now();
+			std::cout << "Loaded " << requests.size() << " images, " << archivedCount << " from the asset archive (decoding: " << std::chrono::duration<double, std::milli>(tDecoded - tStart).count() << " ms, upload: " << std::chrono::duration<double, std::milli>(tEnd - tDecoded).count() << " ms)\n";
+		}
+	};
+}
@@ -58,12 +58,12 @@ public:
 		VkRect2D scissor = { offsetx, offsety, width, height };
 		vkCmdSetScissor(handle, 0, 1, &scissor);
 	}
-	void bindDescriptorSets(PipelineLayout* layout, std::vector<DescriptorSet*> sets, uint32_t firstSet = 0) {
+	void bindDescriptorSets(PipelineLayout* layout, std::vector<DescriptorSet*> sets, uint32_t firstSet = 0, VkPipelineBindPoint bindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS) {
 		std::vector<VkDescriptorSet> descSets;
 		for (auto set : sets) {
 			descSets.push_back(set->handle);
 		}
-		vkCmdBindDescriptorSets(handle, VK_PIPELINE_BIND_POINT_GRAPHICS, layout->handle, firstSet, static_cast<uint32_t>(descSets.size()), descSets.data(), 0, nullptr);
+		vkCmdBindDescriptorSets(handle, bindPoint, layout->handle, firstSet, static_cast<uint32_t>(descSets.size()), descSets.data(), 0, nullptr);
 	}
 	void bindPipeline(Pipeline* pipeline) {
 		vkCmdBindPipeline(handle, pipeline->bindPoint, *pipeline);
@@ -74,6 +74,16 @@ public:
 	void drawIndexed(uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex, int32_t vertexOffset, uint32_t firstInstance) {
 		vkCmdDrawIndexed(handle, indexCount, instanceCount, firstIndex, vertexOffset, firstInstance);
 	}
+	void drawIndirect(VkBuffer buffer, VkDeviceSize offset, uint32_t drawCount, uint32_t stride) {
+		vkCmdDrawIndirect(handle, buffer, offset, drawCount, stride);
+	}
+	void dispatch(uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ) {
+		vkCmdDispatch(handle, groupCountX, groupCountY, groupCountZ);
+	}
+	// Only meant for small updates (max. 65536 bytes), must be called outside of rendering
+	void updateBuffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size, const void* data) {
+		vkCmdUpdateBuffer(handle, buffer, offset, size, data);
+	}
 	void updatePushConstant(PipelineLayout *layout, uint32_t index, const void* values) {
 		VkPushConstantRange pushConstantRange = layout->getPushConstantRange(index);
 		vkCmdPushConstants(handle, layout->handle, pushConstantRange.stageFlags, pushConstantRange.offset, pushConstantRange.size, values);
@@ -89,6 +99,25 @@ public:
 		imageMemoryBarrier.subresourceRange = subresourceRange;
 		vkCmdPipelineBarrier(this->handle, srcStageMask, dstStageMask, 0, 0, nullptr, 0, nullptr, 1, &imageMemoryBarrier);
 	}
+	void insertMemoryBarrier(VkAccessFlags srcAccessMask, VkAccessFlags dstAccessMask, VkPipelineStageFlags srcStageMask, VkPipelineStageFlags dstStageMask)
+	{
+		VkMemoryBarrier memoryBarrier = vks::initializers::memoryBarrier();
+		memoryBarrier.srcAccessMask = srcAccessMask;
+		memoryBarrier.dstAccessMask = dstAccessMask;
+		vkCmdPipelineBarrier(this->handle, srcStageMask, dstStageMask, 0, 1, &memoryBarrier, 0, nullptr, 0, nullptr);
+	}
+	void insertBufferMemoryBarrier(VkBuffer buffer, VkAccessFlags srcAccessMask, VkAccessFlags dstAccessMask, VkPipelineStageFlags srcStageMask, VkPipelineStageFlags dstStageMask, VkDeviceSize offset = 0, VkDeviceSize size = VK_WHOLE_SIZE)
+	{
+		VkBufferMemoryBarrier bufferMemoryBarrier = vks::initializers::bufferMemoryBarrier();
+		bufferMemoryBarrier.srcAccessMask = srcAccessMask;
+		bufferMemoryBarrier.dstAccessMask = dstAccessMask;
+		bufferMemoryBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		bufferMemoryBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		bufferMemoryBarrier.buffer = buffer;
+		bufferMemoryBarrier.offset = offset;
+		bufferMemoryBarrier.size = size;
+		vkCmdPipelineBarrier(this->handle, srcStageMask, dstStageMask, 0, 0, nullptr, 1, &bufferMemoryBarrier, 0, nullptr);
+	}
 	void insertImageMemoryBarrier(VkImageMemoryBarrier barrier, VkPipelineStageFlags srcStageMask, VkPipelineStageFlags dstStageMask)
 	{
 		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
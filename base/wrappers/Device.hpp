@@ -153,6 +153,11 @@ struct Device
 			deviceExtensions.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
 		}
 
+		// Optional features are only enabled if the device supports them
+		if (!features.textureCompressionBC) {
+			Device::enabledFeatures.textureCompressionBC = VK_FALSE;
+		}
+
 		VkDeviceCreateInfo deviceCreateInfo = {};
 		deviceCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
 		deviceCreateInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());;
@@ -9,6 +9,9 @@
 #pragma once
 
 #include <vector>
+#include <chrono>
+#include <atomic>
+#include <future>
 #include "volk.h"
 #include <stdexcept>
 #if defined(__ANDROID__)
@@ -53,39 +56,55 @@ struct PipelineCreateInfo {
 	bool enableHotReload{ false };
 };
 
+struct PipelineCreationTimings {
+	double shaderCompilation{ 0.0 };
+	double pipelineCreation{ 0.0 };
+};
+
 class Pipeline : public DeviceResource {
 private:
+	friend class PipelineBatch;
 	VkPipeline handle{ VK_NULL_HANDLE };
 	
-	void createPipelineObject(PipelineCreateInfo createInfo) {
+	// Doesn't modify the pipeline, so it can be used to create a new pipeline object on another thread while the current one is still in use
+	VkPipeline createPipelineObject(PipelineCreateInfo createInfo, PipelineCreationTimings& timings) const {
+		VkPipeline pipeline{ VK_NULL_HANDLE };
 		std::vector<VkPipelineShaderStageCreateInfo> shaderStages{};
-		Slang::ComPtr<slang::ISession> session = slangCompiler->createSession();
+		const auto tStart = std::chrono::high_resolution_clock::now();
 
 		// Slang allows for all shader stages to be stored in a single file
+		// SPIR-V is taken from the shader cache if the source and its dependencies haven't changed
+		const std::vector<uint32_t> spirv = slangCompiler->compile(createInfo.name, createInfo.shaders.filename);
+
+		VkShaderModuleCreateInfo shaderModuleCI{};
+		shaderModuleCI.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+		shaderModuleCI.codeSize = spirv.size() * sizeof(uint32_t);
+		shaderModuleCI.pCode = spirv.data();
 		VkShaderModule shaderModule{ VK_NULL_HANDLE };
-		try {
-			Slang::ComPtr<slang::IModule> slangModule{ session->loadModuleFromSource(createInfo.name.c_str(), createInfo.shaders.filename.c_str(), nullptr, nullptr) };
-			Slang::ComPtr<ISlangBlob> spirv;
-			slangModule->getTargetCode(0, spirv.writeRef());
-
-			VkShaderModuleCreateInfo shaderModuleCI{};
-			shaderModuleCI.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-			shaderModuleCI.codeSize = spirv->getBufferSize();
-			shaderModuleCI.pCode = (uint32_t*)spirv->getBufferPointer();
-			VkShaderModule shaderModule;
-			vkCreateShaderModule(VulkanContext::device->logicalDevice, &shaderModuleCI, nullptr, &shaderModule);
-
-			VkPipelineShaderStageCreateInfo shaderStageCI{};
-			shaderStageCI.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-			shaderStageCI.module = shaderModule;
-			shaderStageCI.pName = "main";
-			for (auto& stage : createInfo.shaders.stages) {
-				shaderStageCI.stage = stage;
-				shaderStages.push_back(shaderStageCI);
-			}
+		VK_CHECK_RESULT(vkCreateShaderModule(VulkanContext::device->logicalDevice, &shaderModuleCI, nullptr, &shaderModule));
+
+		VkPipelineShaderStageCreateInfo shaderStageCI{};
+		shaderStageCI.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+		shaderStageCI.module = shaderModule;
+		shaderStageCI.pName = "main";
+		for (auto& stage : createInfo.shaders.stages) {
+			shaderStageCI.stage = stage;
+			shaderStages.push_back(shaderStageCI);
 		}
-		catch (...) {
-			throw;
+		const auto tShadersCompiled = std::chrono::high_resolution_clock::now();
+		timings.shaderCompilation = std::chrono::duration<double, std::milli>(tShadersCompiled - tStart).count();
+
+		// Compute pipelines only use a single stage and none of the fixed function state
+		if (createInfo.bindPoint == VK_PIPELINE_BIND_POINT_COMPUTE) {
+			assert(shaderStages.size() == 1);
+			VkComputePipelineCreateInfo pipelineCI{};
+			pipelineCI.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+			pipelineCI.stage = shaderStages[0];
+			pipelineCI.layout = createInfo.layout;
+			VK_CHECK_RESULT(vkCreateComputePipelines(VulkanContext::device->logicalDevice, createInfo.cache, 1, &pipelineCI, nullptr, &pipeline));
+			vkDestroyShaderModule(VulkanContext::device->logicalDevice, shaderModule, nullptr);
+			timings.pipelineCreation = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - tShadersCompiled).count();
+			return pipeline;
 		}
 
 		createInfo.inputAssemblyState.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
@@ -139,21 +158,39 @@ private:
 		pipelineCI.pDynamicState = &dynamicState;
 		pipelineCI.pNext = &createInfo.pipelineRenderingInfo; // createInfo.pNext;
 
-		VK_CHECK_RESULT(vkCreateGraphicsPipelines(VulkanContext::device->logicalDevice, createInfo.cache, 1, &pipelineCI, nullptr, &handle));
+		VK_CHECK_RESULT(vkCreateGraphicsPipelines(VulkanContext::device->logicalDevice, createInfo.cache, 1, &pipelineCI, nullptr, &pipeline));
 	
 		vkDestroyShaderModule(VulkanContext::device->logicalDevice, shaderModule, nullptr);
+		timings.pipelineCreation = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - tShadersCompiled).count();
 
+		return pipeline;
+	}
+
+	// Pipelines added to a batch are created later on by PipelineBatch::build
+	struct Deferred {};
+	Pipeline(const PipelineCreateInfo& createInfo, Deferred) : DeviceResource(createInfo.name) {
 		bindPoint = createInfo.bindPoint;
+		if (createInfo.enableHotReload) {
+			initialCreateInfo = new PipelineCreateInfo(createInfo);
+		}
 	}
 
+	// Asynchronous hot reload, the new pipeline object is created on a background thread and swapped in on the render thread
+	// This deliberately doesn't use the job system: The render thread is one of its workers and runs pending jobs while waiting (e.g. for the game update), so the shader compilation could end up stalling a frame
+	std::future<VkPipeline> reloadedHandle;
+
 public:
 	// Store the createInfo for hot reload
 	PipelineCreateInfo* initialCreateInfo{ nullptr };
 	VkPipelineBindPoint bindPoint{ VK_PIPELINE_BIND_POINT_GRAPHICS };
-	bool wantsReload = false;
+	// Set by the file watcher thread
+	std::atomic<bool> wantsReload{ false };
+	// Time spent on the last (re)creation of the pipeline object
+	PipelineCreationTimings creationTimings{};
 
 	Pipeline(PipelineCreateInfo createInfo) : DeviceResource(createInfo.name) {
-		createPipelineObject(createInfo);
+		handle = createPipelineObject(createInfo, creationTimings);
+		bindPoint = createInfo.bindPoint;
 
 		// Store a copy of the createInfo for hot reload		
 		if (createInfo.enableHotReload) {
@@ -164,24 +201,74 @@ public:
 	};
 
 	~Pipeline() {
+		// The reload thread accesses this object
+		if (reloadedHandle.valid()) {
+			VkPipeline pendingHandle = reloadedHandle.get();
+			if (pendingHandle != VK_NULL_HANDLE) {
+				vkDestroyPipeline(VulkanContext::device->logicalDevice, pendingHandle, nullptr);
+			}
+		}
 		vkDestroyPipeline(VulkanContext::device->logicalDevice, handle, nullptr);
 	}
 
+	// Synchronous reload, blocks until the shaders have been compiled and the pipeline object has been created
 	void reload() {
 		wantsReload = false;
 		assert(initialCreateInfo);
-		// @todo: move to calling function to avoid multiple wait idles
-		VulkanContext::device->waitIdle();
 		// For hot reloads create a temp handle, so if pipeline creation fails the application will continue with the old pipeline
 		VkPipeline oldHandle = handle;
 		try {
-			createPipelineObject(*initialCreateInfo);
-			vkDestroyPipeline(VulkanContext::device->logicalDevice, oldHandle, nullptr);
+			handle = createPipelineObject(*initialCreateInfo, creationTimings);
+			// Frames in flight may still use the old pipeline
+			VulkanContext::deletionQueue.push([oldHandle]() {
+				vkDestroyPipeline(VulkanContext::device->logicalDevice, oldHandle, nullptr);
+			});
 			std::cout << "Pipeline recreated\n";
 		} catch (...) {
 			std::cerr << "Could not recreate pipeline, using last version\n";
 		}
 	}
 
+	// Starts recreating the pipeline object on a background thread, the current pipeline stays valid until applyReload swaps them
+	// If a reload is already running, the request is kept and started once that one has been applied
+	void reloadAsync() {
+		assert(initialCreateInfo);
+		if (reloadedHandle.valid()) {
+			return;
+		}
+		wantsReload = false;
+		reloadedHandle = std::async(std::launch::async, [this]() {
+			VkPipeline newHandle{ VK_NULL_HANDLE };
+			try {
+				PipelineCreationTimings timings{};
+				newHandle = createPipelineObject(*initialCreateInfo, timings);
+				std::cout << "Pipeline recreated in " << timings.shaderCompilation + timings.pipelineCreation << " ms\n";
+			} catch (...) {
+				std::cerr << "Could not recreate pipeline, using last version\n";
+			}
+			return newHandle;
+		});
+	}
+
+	// Swaps in the pipeline object of a finished asynchronous reload, needs to be called between frames (i.e. not while recording command buffers)
+	// Returns true if the pipeline was replaced
+	bool applyReload() {
+		if (!reloadedHandle.valid() || (reloadedHandle.wait_for(std::chrono::seconds(0)) != std::future_status::ready)) {
+			return false;
+		}
+		VkPipeline newHandle = reloadedHandle.get();
+		if (newHandle == VK_NULL_HANDLE) {
+			return false;
+		}
+		VkPipeline oldHandle = handle;
+		handle = newHandle;
+		setDebugName((uint64_t)handle, VK_OBJECT_TYPE_PIPELINE);
+		// Frames in flight may still use the old pipeline
+		VulkanContext::deletionQueue.push([oldHandle]() {
+			vkDestroyPipeline(VulkanContext::device->logicalDevice, oldHandle, nullptr);
+		});
+		return true;
+	}
+
 	operator VkPipeline() { return handle; };
 };
@@ -0,0 +1,130 @@
+/*
+ * Batched pipeline creation
+ *
+ * Pipelines added to a batch are created concurrently on the worker threads of a job system, including their shader compilation
+ * Each pipeline is created with its own pipeline cache that's seeded from the target cache, the results are merged back into the target cache
+ * once all pipelines have been created, so workers never contend on (or need to lock) a shared cache
+ *
+ * Copyright (C) 2026 by Sascha Willems - www.saschawillems.de
+ *
+ * This code is licensed under the MIT license (MIT) (http://opensource.org/licenses/MIT)
+ */
+
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <exception>
+#include <chrono>
+#include <iostream>
+#include "volk.h"
+#include "Pipeline.hpp"
+#include "JobSystem.hpp"
+
+struct PipelineBatchCreateInfo {
+	// Cache that all pipelines of this batch are merged into
+	VkPipelineCache cache{ VK_NULL_HANDLE };
+};
+
+struct PipelineBatchTimings {
+	// Wall clock time of the whole batch
+	double total{ 0.0 };
+	// Summed up over all pipelines, so these can be larger than the total if pipelines were created in parallel
+	double shaderCompilation{ 0.0 };
+	double pipelineCreation{ 0.0 };
+	double cacheMerge{ 0.0 };
+};
+
+class PipelineBatch {
+private:
+	struct Entry {
+		Pipeline* pipeline{ nullptr };
+		std::unique_ptr<PipelineCreateInfo> createInfo{};
+		VkPipelineCache cache{ VK_NULL_HANDLE };
+		std::exception_ptr exception{ nullptr };
+	};
+	VkPipelineCache cache{ VK_NULL_HANDLE };
+	std::vector<Entry> entries{};
+
+public:
+	PipelineBatchTimings timings{};
+
+	PipelineBatch(PipelineBatchCreateInfo createInfo) {
+		cache = createInfo.cache;
+	}
+
+	// Returns the pipeline right away, but its handle is only valid after build has been called
+	Pipeline* add(PipelineCreateInfo createInfo) {
+		Pipeline* pipeline = new Pipeline(createInfo, Pipeline::Deferred{});
+		entries.push_back({ .pipeline = pipeline, .createInfo = std::make_unique<PipelineCreateInfo>(createInfo) });
+		return pipeline;
+	}
+
+	// Creates all pipelines added since the last build, throws the first error that occurred after all jobs have finished
+	void build(vks::JobSystem& jobSystem) {
+		const auto tStart = std::chrono::high_resolution_clock::now();
+		VkDevice device = VulkanContext::device->logicalDevice;
+
+		std::vector<uint8_t> initialData{};
+		if (cache != VK_NULL_HANDLE) {
+			size_t dataSize{ 0 };
+			vkGetPipelineCacheData(device, cache, &dataSize, nullptr);
+			initialData.resize(dataSize);
+			vkGetPipelineCacheData(device, cache, &dataSize, initialData.data());
+			initialData.resize(dataSize);
+		}
+
+		vks::JobCounter counter;
+		for (auto& entry : entries) {
+			Entry* job = &entry;
+			jobSystem.run([job, device, &initialData]() {
+				try {
+					VkPipelineCacheCreateInfo pipelineCacheCreateInfo{};
+					pipelineCacheCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+					pipelineCacheCreateInfo.initialDataSize = initialData.size();
+					pipelineCacheCreateInfo.pInitialData = initialData.empty() ? nullptr : initialData.data();
+					VK_CHECK_RESULT(vkCreatePipelineCache(device, &pipelineCacheCreateInfo, nullptr, &job->cache));
+					// The copy stored for hot reloads keeps referencing the target cache
+					PipelineCreateInfo createInfo = *job->createInfo;
+					createInfo.cache = job->cache;
+					job->pipeline->handle = job->pipeline->createPipelineObject(createInfo, job->pipeline->creationTimings);
+				} catch (...) {
+					job->exception = std::current_exception();
+				}
+			}, &counter);
+		}
+		jobSystem.wait(counter);
+
+		const auto tMergeStart = std::chrono::high_resolution_clock::now();
+		std::vector<VkPipelineCache> caches{};
+		for (auto& entry : entries) {
+			if (entry.cache != VK_NULL_HANDLE) {
+				caches.push_back(entry.cache);
+			}
+		}
+		if ((cache != VK_NULL_HANDLE) && !caches.empty()) {
+			VK_CHECK_RESULT(vkMergePipelineCaches(device, cache, static_cast<uint32_t>(caches.size()), caches.data()));
+		}
+		for (auto& pipelineCache : caches) {
+			vkDestroyPipelineCache(device, pipelineCache, nullptr);
+		}
+		timings.cacheMerge = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - tMergeStart).count();
+
+		std::exception_ptr exception{ nullptr };
+		for (auto& entry : entries) {
+			if (entry.exception) {
+				exception = exception ? exception : entry.exception;
+				continue;
+			}
+			entry.pipeline->setDebugName((uint64_t)entry.pipeline->handle, VK_OBJECT_TYPE_PIPELINE);
+			timings.shaderCompilation += entry.pipeline->creationTimings.shaderCompilation;
+			timings.pipelineCreation += entry.pipeline->creationTimings.pipelineCreation;
+		}
+		entries.clear();
+		timings.total = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - tStart).count();
+
+		if (exception) {
+			std::rethrow_exception(exception);
+		}
+	}
+};
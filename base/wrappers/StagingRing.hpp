@@ -0,0 +1,131 @@
+/*
+ * Per-frame staging ring for streaming dynamic buffer data to device local memory without resizable BAR
+ *
+ * Each frame in flight owns one host visible staging buffer that is linearly sub-allocated during the frame
+ * Copies to the destination buffers are recorded into the frame's command buffer instead of being submitted separately,
+ * so uploads are synchronized by the existing frame pacing and never stall the CPU
+ *
+ * Copyright (C) 2026 by Sascha Willems - www.saschawillems.de
+ *
+ * This code is licensed under the MIT license (MIT) (http://opensource.org/licenses/MIT)
+ */
+
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include "volk.h"
+#include "Buffer.hpp"
+#include "CommandBuffer.hpp"
+
+struct StagingRingCreateInfo {
+	const std::string name{ "" };
+	uint32_t frameCount{ 0 };
+	// Initial size of each frame's staging buffer, grows if a frame needs more
+	VkDeviceSize size{ 0 };
+};
+
+struct StagingAllocation {
+	void* data{ nullptr };
+	VkDeviceSize offset{ 0 };
+	VkDeviceSize size{ 0 };
+};
+
+class StagingRing {
+private:
+	struct PendingCopy {
+		VkBuffer dstBuffer{ VK_NULL_HANDLE };
+		VkBufferCopy region{};
+	};
+	// Offsets are aligned so that all data types used in buffers (e.g. with alignas(16) members) can be written in place
+	static constexpr VkDeviceSize alignment = 16;
+	std::string name;
+	std::vector<Buffer*> buffers{};
+	uint32_t frameIndex{ 0 };
+	VkDeviceSize offset{ 0 };
+	std::vector<PendingCopy> pendingCopies{};
+
+	Buffer* createBuffer(VkDeviceSize size) {
+		return new Buffer({
+			.name = name,
+			.usageFlags = VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+			.size = size,
+			.map = true
+		});
+	}
+
+	// Only ever called for the current frame's buffer, which is no longer used by the GPU, so it can be replaced right away
+	void grow(VkDeviceSize requiredSize) {
+		Buffer* oldBuffer = buffers[frameIndex];
+		const VkDeviceSize newSize = std::max(oldBuffer->size * 2, requiredSize);
+		std::cout << "Resizing staging buffer for frame " << frameIndex << " to " << newSize << " bytes\n";
+		Buffer* newBuffer = createBuffer(newSize);
+		// Keep data that has already been staged during this frame
+		memcpy(newBuffer->mapped, oldBuffer->mapped, offset);
+		delete oldBuffer;
+		buffers[frameIndex] = newBuffer;
+	}
+
+public:
+	StagingRing(StagingRingCreateInfo createInfo) {
+		name = createInfo.name;
+		for (uint32_t i = 0; i < createInfo.frameCount; i++) {
+			buffers.push_back(createBuffer(createInfo.size));
+		}
+	}
+
+	~StagingRing() {
+		for (auto& buffer : buffers) {
+			delete buffer;
+		}
+	}
+
+	// Must be called once the frame that last used this frame's resources has finished, as its staging buffer is reused
+	void beginFrame(uint32_t frameIndex) {
+		assert(frameIndex < buffers.size());
+		this->frameIndex = frameIndex;
+		offset = 0;
+		pendingCopies.clear();
+	}
+
+	// Returns host visible memory to write the data into, only valid until the next call to allocate
+	StagingAllocation allocate(VkDeviceSize size) {
+		const VkDeviceSize alignedOffset = (offset + alignment - 1) & ~(alignment - 1);
+		if (alignedOffset + size > buffers[frameIndex]->size) {
+			grow(alignedOffset + size);
+		}
+		offset = alignedOffset + size;
+		return { .data = static_cast<uint8_t*>(buffers[frameIndex]->mapped) + alignedOffset, .offset = alignedOffset, .size = size };
+	}
+
+	// Copies size bytes of the allocation to the destination buffer when recording the copies
+	void copy(const StagingAllocation& allocation, VkBuffer dstBuffer, VkDeviceSize size, VkDeviceSize dstOffset = 0) {
+		assert(size <= allocation.size);
+		if (size == 0) {
+			return;
+		}
+		pendingCopies.push_back({ .dstBuffer = dstBuffer, .region = {.srcOffset = allocation.offset, .dstOffset = dstOffset, .size = size } });
+	}
+
+	// Convenience function for data that's already available on the host
+	void upload(const void* data, VkBuffer dstBuffer, VkDeviceSize size, VkDeviceSize dstOffset = 0) {
+		StagingAllocation allocation = allocate(size);
+		memcpy(allocation.data, data, size);
+		copy(allocation, dstBuffer, size, dstOffset);
+	}
+
+	bool hasPendingCopies() const {
+		return !pendingCopies.empty();
+	}
+
+	// Records all copies staged during this frame, needs to be called outside of rendering and followed by a barrier for the destination usage
+	void recordCopies(CommandBuffer* cb) {
+		VkBuffer srcBuffer = buffers[frameIndex]->buffer;
+		for (auto& pendingCopy : pendingCopies) {
+			vkCmdCopyBuffer(cb->handle, srcBuffer, pendingCopy.dstBuffer, 1, &pendingCopy.region);
+		}
+		pendingCopies.clear();
+	}
+};
@@ -49,6 +49,11 @@ namespace vks
 		VkDeviceSize bufferSize;
 		uint32_t texWidth;
 		uint32_t texHeight;
+		// Buffer contains layerCount images of texWidth * texHeight
+		uint32_t layerCount = 1;
+		// No. of mip levels contained in the buffer, stored back to back (each with all layers) starting with the largest
+		// Block compressed formats can't generate their mips with blits and need to pass them in
+		uint32_t mipLevels = 1;
 		VkFormat format;
 		VkImageUsageFlags imageUsageFlags = VK_IMAGE_USAGE_SAMPLED_BIT;
 		VkImageLayout imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
@@ -59,6 +64,9 @@ namespace vks
 		VkSamplerAddressMode addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
 		VkSamplerAddressMode addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
 		VkSamplerAddressMode addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+		VkImageViewType viewType = VK_IMAGE_VIEW_TYPE_2D;
+		// Atlases need to disable mip mapping, as lower mips would blend neighbouring images
+		bool generateMipmaps = true;
 	};
 
 	/** @brief Vulkan texture base class */
@@ -274,14 +282,11 @@ namespace vks
 			updateDescriptor();
 		}
 
+		// Uploads the data in its own submission and waits for it to finish
 		Texture2D(TextureFromBufferCreateInfo createInfo)
 		{
 			assert(createInfo.buffer);
 
-			width = createInfo.texWidth;
-			height = createInfo.texHeight;
-			mipLevels = static_cast<uint32_t>(floor(log2(std::max(width, height))) + 1.0);
-
 			VkMemoryAllocateInfo memAllocInfo = vks::initializers::memoryAllocateInfo();
 			VkMemoryRequirements memReqs;
 
@@ -316,22 +321,70 @@ namespace vks
 			memcpy(data, createInfo.buffer, createInfo.bufferSize);
 			vkUnmapMemory(VulkanContext::device->logicalDevice, stagingMemory);
 
-			VkBufferImageCopy bufferCopyRegion = {};
-			bufferCopyRegion.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-			bufferCopyRegion.imageSubresource.mipLevel = 0;
-			bufferCopyRegion.imageSubresource.baseArrayLayer = 0;
-			bufferCopyRegion.imageSubresource.layerCount = 1;
-			bufferCopyRegion.imageExtent.width = width;
-			bufferCopyRegion.imageExtent.height = height;
-			bufferCopyRegion.imageExtent.depth = 1;
-			bufferCopyRegion.bufferOffset = 0;
+			createImage(createInfo);
+			recordUpload(createInfo, copyCmd, stagingBuffer, 0);
+
+			// @todo: transfer queue (mip generation uses blits, which need a graphics queue)
+			VulkanContext::device->flushCommandBuffer(copyCmd, VulkanContext::graphicsQueue, true);
+
+			vkFreeMemory(VulkanContext::device->logicalDevice, stagingMemory, nullptr);
+			vkDestroyBuffer(VulkanContext::device->logicalDevice, stagingBuffer, nullptr);
+
+			createView(createInfo);
+		}
+
+		// Only records the upload from an already filled staging buffer into the command buffer, so uploads of many textures can be batched into a single submission
+		// The texture must not be used before that command buffer has finished execution
+		Texture2D(TextureFromBufferCreateInfo createInfo, VkCommandBuffer copyCmd, VkBuffer stagingBuffer, VkDeviceSize stagingOffset)
+		{
+			createImage(createInfo);
+			recordUpload(createInfo, copyCmd, stagingBuffer, stagingOffset);
+			createView(createInfo);
+		}
+
+		// Records copies of the given regions from the buffer into the image (e.g. to update parts of an image that's in use)
+		// Transitions the image to transfer and back to shader read, reads by commands submitted earlier are finished before the copies start
+		void recordRegionUpdate(VkCommandBuffer cmd, VkBuffer srcBuffer, const std::vector<VkBufferImageCopy>& regions)
+		{
+			if (regions.empty()) {
+				return;
+			}
+			const VkImageSubresourceRange subresourceRange{ VK_IMAGE_ASPECT_COLOR_BIT, 0, mipLevels, 0, layerCount };
+			VkImageMemoryBarrier imageMemoryBarrier{
+				.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+				.srcAccessMask = 0,
+				.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+				.oldLayout = imageLayout,
+				.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+				.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+				.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+				.image = image,
+				.subresourceRange = subresourceRange
+			};
+			vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &imageMemoryBarrier);
+			vkCmdCopyBufferToImage(cmd, srcBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, static_cast<uint32_t>(regions.size()), regions.data());
+			imageMemoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			imageMemoryBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+			imageMemoryBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+			imageMemoryBarrier.newLayout = imageLayout;
+			vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &imageMemoryBarrier);
+		}
+
+	private:
+		void createImage(const TextureFromBufferCreateInfo& createInfo)
+		{
+			width = createInfo.texWidth;
+			height = createInfo.texHeight;
+			layerCount = createInfo.layerCount;
+			const bool generateMipmaps = createInfo.generateMipmaps && (createInfo.mipLevels == 1) && !vks::tools::isBlockCompressed(createInfo.format);
+			mipLevels = generateMipmaps ? static_cast<uint32_t>(floor(log2(std::max(width, height))) + 1.0) : createInfo.mipLevels;
 
 			// Create optimal tiled target image
 			VkImageCreateInfo imageCreateInfo = vks::initializers::imageCreateInfo();
 			imageCreateInfo.imageType = VK_IMAGE_TYPE_2D;
 			imageCreateInfo.format = createInfo.format;
 			imageCreateInfo.mipLevels = mipLevels;
-			imageCreateInfo.arrayLayers = 1;
+			imageCreateInfo.arrayLayers = layerCount;
 			imageCreateInfo.samples = VK_SAMPLE_COUNT_1_BIT;
 			imageCreateInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
 			imageCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
@@ -341,19 +394,40 @@ namespace vks
 			imageCreateInfo.usage |= createInfo.imageUsageFlags;
 			VK_CHECK_RESULT(vkCreateImage(VulkanContext::device->logicalDevice, &imageCreateInfo, nullptr, &image));
 
+			VkMemoryRequirements memReqs;
 			vkGetImageMemoryRequirements(VulkanContext::device->logicalDevice, image, &memReqs);
 
+			VkMemoryAllocateInfo memAllocInfo = vks::initializers::memoryAllocateInfo();
 			memAllocInfo.allocationSize = memReqs.size;
-
 			memAllocInfo.memoryTypeIndex = VulkanContext::device->getMemoryType(memReqs.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
 			VK_CHECK_RESULT(vkAllocateMemory(VulkanContext::device->logicalDevice, &memAllocInfo, nullptr, &deviceMemory));
 			VK_CHECK_RESULT(vkBindImageMemory(VulkanContext::device->logicalDevice, image, deviceMemory, 0));
+		}
+
+		// Copies the levels passed in the staging buffer, generates the rest of the mip chain and transitions the image to shader read
+		void recordUpload(const TextureFromBufferCreateInfo& createInfo, VkCommandBuffer copyCmd, VkBuffer stagingBuffer, VkDeviceSize stagingOffset)
+		{
+			std::vector<VkBufferImageCopy> bufferCopyRegions{};
+			VkDeviceSize offset = stagingOffset;
+			for (uint32_t i = 0; i < createInfo.mipLevels; i++) {
+				VkBufferImageCopy bufferCopyRegion = {};
+				bufferCopyRegion.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+				bufferCopyRegion.imageSubresource.mipLevel = i;
+				bufferCopyRegion.imageSubresource.baseArrayLayer = 0;
+				bufferCopyRegion.imageSubresource.layerCount = layerCount;
+				bufferCopyRegion.imageExtent.width = std::max(width >> i, 1u);
+				bufferCopyRegion.imageExtent.height = std::max(height >> i, 1u);
+				bufferCopyRegion.imageExtent.depth = 1;
+				bufferCopyRegion.bufferOffset = offset;
+				bufferCopyRegions.push_back(bufferCopyRegion);
+				offset += vks::tools::getImageSize(createInfo.format, bufferCopyRegion.imageExtent.width, bufferCopyRegion.imageExtent.height) * layerCount;
+			}
 
 			VkImageSubresourceRange subresourceRange = {};
 			subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
 			subresourceRange.baseMipLevel = 0;
 			subresourceRange.levelCount = mipLevels;
-			subresourceRange.layerCount = 1;
+			subresourceRange.layerCount = layerCount;
 
 			// Image barrier for optimal image (target)
 			// Optimal image will be used as destination for the copy
@@ -370,8 +444,8 @@ namespace vks
 				stagingBuffer,
 				image,
 				VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-				1,
-				&bufferCopyRegion
+				static_cast<uint32_t>(bufferCopyRegions.size()),
+				bufferCopyRegions.data()
 			);
 
 			{
@@ -386,28 +460,19 @@ namespace vks
 				vkCmdPipelineBarrier(copyCmd, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, nullptr, 0, nullptr, 1, &imageMemoryBarrier);
 			}
 
-			// @todo
-			VkQueue copyQueue = VulkanContext::graphicsQueue;
-
-			VulkanContext::device->flushCommandBuffer(copyCmd, copyQueue, true);
-
-			vkFreeMemory(VulkanContext::device->logicalDevice, stagingMemory, nullptr);
-			vkDestroyBuffer(VulkanContext::device->logicalDevice, stagingBuffer, nullptr);
-
-			// Generate the mip chain
-			VkCommandBuffer blitCmd = VulkanContext::device->createCommandBuffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY, true);
-			for (uint32_t i = 1; i < mipLevels; i++) {
+			// Generate the mip levels that weren't passed in
+			for (uint32_t i = createInfo.mipLevels; i < mipLevels; i++) {
 				VkImageBlit imageBlit{};
 
 				imageBlit.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-				imageBlit.srcSubresource.layerCount = 1;
+				imageBlit.srcSubresource.layerCount = layerCount;
 				imageBlit.srcSubresource.mipLevel = i - 1;
 				imageBlit.srcOffsets[1].x = int32_t(width >> (i - 1));
 				imageBlit.srcOffsets[1].y = int32_t(height >> (i - 1));
 				imageBlit.srcOffsets[1].z = 1;
 
 				imageBlit.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-				imageBlit.dstSubresource.layerCount = 1;
+				imageBlit.dstSubresource.layerCount = layerCount;
 				imageBlit.dstSubresource.mipLevel = i;
 				imageBlit.dstOffsets[1].x = int32_t(width >> i);
 				imageBlit.dstOffsets[1].y = int32_t(height >> i);
@@ -417,7 +482,7 @@ namespace vks
 				mipSubRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
 				mipSubRange.baseMipLevel = i;
 				mipSubRange.levelCount = 1;
-				mipSubRange.layerCount = 1;
+				mipSubRange.layerCount = layerCount;
 
 				{
 					VkImageMemoryBarrier imageMemoryBarrier{};
@@ -428,10 +493,10 @@ namespace vks
 					imageMemoryBarrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
 					imageMemoryBarrier.image = image;
 					imageMemoryBarrier.subresourceRange = mipSubRange;
-					vkCmdPipelineBarrier(blitCmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &imageMemoryBarrier);
+					vkCmdPipelineBarrier(copyCmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &imageMemoryBarrier);
 				}
 
-				vkCmdBlitImage(blitCmd, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &imageBlit, createInfo.minFilter);
+				vkCmdBlitImage(copyCmd, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &imageBlit, createInfo.minFilter);
 
 				{
 					VkImageMemoryBarrier imageMemoryBarrier{};
@@ -442,11 +507,10 @@ namespace vks
 					imageMemoryBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
 					imageMemoryBarrier.image = image;
 					imageMemoryBarrier.subresourceRange = mipSubRange;
-					vkCmdPipelineBarrier(blitCmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &imageMemoryBarrier);
+					vkCmdPipelineBarrier(copyCmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &imageMemoryBarrier);
 				}
 			}
 
-			subresourceRange.levelCount = mipLevels;
 			imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
 
 			{
@@ -458,36 +522,24 @@ namespace vks
 				imageMemoryBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
 				imageMemoryBarrier.image = image;
 				imageMemoryBarrier.subresourceRange = subresourceRange;
-				vkCmdPipelineBarrier(blitCmd, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, nullptr, 0, nullptr, 1, &imageMemoryBarrier);
+				vkCmdPipelineBarrier(copyCmd, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, nullptr, 0, nullptr, 1, &imageMemoryBarrier);
 			}
+		}
 
-			VulkanContext::device->flushCommandBuffer(blitCmd, copyQueue, true);
-
-			// Change texture image layout to shader read after all mip levels have been copied
-			//this->imageLayout = createInfo.imageLayout;
-			//vks::tools::setImageLayout(
-			//	copyCmd,
-			//	image,
-			//	VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-			//	imageLayout,
-			//	subresourceRange);
-
-			// @todo: create full mip chain
-
-			// @todo: transfer queu
-			//VulkanContext::device->flushCommandBuffer(copyCmd, VulkanContext::graphicsQueue);
-
+		void createView(const TextureFromBufferCreateInfo& createInfo)
+		{
 			// Create image view
 			VkImageViewCreateInfo viewCreateInfo = {};
 			viewCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
 			viewCreateInfo.pNext = NULL;
-			viewCreateInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+			viewCreateInfo.viewType = createInfo.viewType;
 			viewCreateInfo.format = createInfo.format;
-			viewCreateInfo.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+			viewCreateInfo.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, layerCount };
 			viewCreateInfo.subresourceRange.levelCount = mipLevels;
 			viewCreateInfo.image = image;
 			VK_CHECK_RESULT(vkCreateImageView(VulkanContext::device->logicalDevice, &viewCreateInfo, nullptr, &view));
 
+			sampler = VK_NULL_HANDLE;
 			if (createInfo.createSampler) {
 				VkSamplerCreateInfo samplerCreateInfo = vks::initializers::samplerCreateInfo();
 				samplerCreateInfo.magFilter = createInfo.magFilter;
@@ -0,0 +1,263 @@
+/*
+* Texture atlas builder
+*
+* Packs many small images (e.g. sprites) into the layers of a single array texture at startup
+* Images are addressed by their index into a table of uv rectangles and layers, which is uploaded to a storage buffer
+* Compared to one texture per image this needs a single image allocation and descriptor, and neighbouring images share texture cache lines
+* BC3 compressed atlases place images at block boundaries, their padding is made of blocks that repeat the indices of the image's edge texels
+*
+* Copyright(C) 2026 by Sascha Willems - www.saschawillems.de
+*
+* This code is licensed under the MIT license(MIT) (http://opensource.org/licenses/MIT)
+*/
+
+#pragma once
+
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <glm/glm.hpp>
+#include "volk.h"
+#include "Texture.hpp"
+#include "Buffer.hpp"
+
+namespace vks
+{
+	struct TextureAtlasCreateInfo {
+		// Width and height of each layer, clamped to the device limit
+		uint32_t layerSize = 1024;
+		// Border around each image filled with its edge pixels, so sampling at the edge of an image never picks up its neighbours
+		// Rounded up to whole blocks for compressed formats
+		uint32_t padding = 1;
+		// RGBA8 or BC3
+		VkFormat format = VK_FORMAT_R8G8B8A8_SRGB;
+	};
+
+	// Needs to match the rect table definition in the shaders (std430)
+	struct TextureAtlasRect {
+		// Min and max uv
+		glm::vec4 uv{ 0.0f };
+		uint32_t layer{ 0 };
+		uint32_t padding[3]{};
+	};
+
+	class TextureAtlas {
+	private:
+		struct Image {
+			// Owned by the caller of add
+			const uint8_t* pixels{ nullptr };
+			uint32_t width{ 0 };
+			uint32_t height{ 0 };
+		};
+		std::vector<Image> images{};
+		uint32_t layerSize{ 0 };
+		uint32_t requestedPadding{ 0 };
+		VkFormat format{ VK_FORMAT_UNDEFINED };
+		// Packing and copying works on units of single texels for uncompressed and 4 x 4 texel blocks for compressed formats
+		uint32_t unitSize{ 1 };
+		uint32_t unitBytes{ 4 };
+		// In units
+		uint32_t padding{ 0 };
+
+		// Writes a BC3 block that repeats the edge texels of the given side(s) of the source block, so padding blocks extrude the image like uncompressed padding does
+		static void extrudeBlock(const uint8_t* src, uint8_t* dst, int32_t sideX, int32_t sideY)
+		{
+			memcpy(dst, src, 16);
+			uint64_t srcAlphaIndices{ 0 }, dstAlphaIndices{ 0 };
+			uint32_t srcColorIndices{ 0 }, dstColorIndices{ 0 };
+			memcpy(&srcAlphaIndices, &src[2], 6);
+			memcpy(&srcColorIndices, &src[12], 4);
+			for (uint32_t y = 0; y < 4; y++) {
+				const uint32_t srcY = (sideY < 0) ? 0 : (sideY > 0) ? 3 : y;
+				for (uint32_t x = 0; x < 4; x++) {
+					const uint32_t srcX = (sideX < 0) ? 0 : (sideX > 0) ? 3 : x;
+					const uint32_t srcTexel = srcY * 4 + srcX;
+					const uint32_t dstTexel = y * 4 + x;
+					dstAlphaIndices |= ((srcAlphaIndices >> (srcTexel * 3)) & 7) << (dstTexel * 3);
+					dstColorIndices |= ((srcColorIndices >> (srcTexel * 2)) & 3) << (dstTexel * 2);
+				}
+			}
+			memcpy(&dst[2], &dstAlphaIndices, 6);
+			memcpy(&dst[12], &dstColorIndices, 4);
+		}
+
+		// Copies the image into the layer including its padding, which repeats the image's edge pixels (all values in units)
+		void blit(uint8_t* layer, const Image& image, uint32_t x, uint32_t y)
+		{
+			const uint32_t layerUnits = layerSize / unitSize;
+			const int32_t imageWidth = static_cast<int32_t>(image.width / unitSize);
+			const int32_t imageHeight = static_cast<int32_t>(image.height / unitSize);
+			const int32_t border = static_cast<int32_t>(padding);
+			for (int32_t dy = -border; dy < imageHeight + border; dy++) {
+				const uint32_t srcY = static_cast<uint32_t>(std::clamp(dy, 0, imageHeight - 1));
+				for (int32_t dx = -border; dx < imageWidth + border; dx++) {
+					const uint32_t srcX = static_cast<uint32_t>(std::clamp(dx, 0, imageWidth - 1));
+					uint8_t* dst = &layer[((static_cast<size_t>(y + dy) * layerUnits) + (x + dx)) * unitBytes];
+					const uint8_t* src = &image.pixels[(static_cast<size_t>(srcY) * imageWidth + srcX) * unitBytes];
+					const int32_t sideX = (dx < 0) ? -1 : (dx >= imageWidth) ? 1 : 0;
+					const int32_t sideY = (dy < 0) ? -1 : (dy >= imageHeight) ? 1 : 0;
+					if ((unitSize > 1) && ((sideX != 0) || (sideY != 0))) {
+						extrudeBlock(src, dst, sideX, sideY);
+					} else {
+						memcpy(dst, src, unitBytes);
+					}
+				}
+			}
+		}
+
+	public:
+		Texture2D* texture{ nullptr };
+		// Table of uv rectangles and layers, indexed by the values returned from add
+		Buffer* rectBuffer{ nullptr };
+		std::vector<TextureAtlasRect> rects{};
+
+		TextureAtlas(TextureAtlasCreateInfo createInfo)
+		{
+			// Multiple of the block size, so compressed layers are made of whole blocks
+			layerSize = std::min(createInfo.layerSize, VulkanContext::device->properties.limits.maxImageDimension2D) & ~3u;
+			requestedPadding = createInfo.padding;
+			setFormat(createInfo.format);
+		}
+
+		~TextureAtlas()
+		{
+			delete texture;
+			delete rectBuffer;
+		}
+
+		// Can only be changed before images are added
+		void setFormat(VkFormat format)
+		{
+			assert(images.empty());
+			assert((format == VK_FORMAT_R8G8B8A8_SRGB) || (format == VK_FORMAT_R8G8B8A8_UNORM) || (format == VK_FORMAT_BC3_SRGB_BLOCK) || (format == VK_FORMAT_BC3_UNORM_BLOCK));
+			this->format = format;
+			const bool compressed = vks::tools::isBlockCompressed(format);
+			unitSize = compressed ? 4 : 1;
+			unitBytes = compressed ? 16 : 4;
+			padding = (requestedPadding + unitSize - 1) / unitSize;
+		}
+
+		VkFormat getFormat() const
+		{
+			return format;
+		}
+
+		// Adds an image in the atlas' format (RGBA8 texels or BC3 blocks) and returns its index into the rect table, the atlas is only created once build is called
+		// The pixels aren't copied and need to stay valid until then
+		uint32_t add(const void* pixels, uint32_t width, uint32_t height)
+		{
+			assert(texture == nullptr);
+			if ((width % unitSize != 0) || (height % unitSize != 0)) {
+				throw std::runtime_error("Image of " + std::to_string(width) + " x " + std::to_string(height) + " pixels isn't made of whole blocks and can't be added to a compressed texture atlas");
+			}
+			if ((width + padding * unitSize * 2 > layerSize) || (height + padding * unitSize * 2 > layerSize)) {
+				throw std::runtime_error("Image of " + std::to_string(width) + " x " + std::to_string(height) + " pixels doesn't fit into the texture atlas");
+			}
+			images.push_back({ .pixels = static_cast<const uint8_t*>(pixels), .width = width, .height = height });
+			return static_cast<uint32_t>(images.size() - 1);
+		}
+
+		uint32_t getImageCount() const
+		{
+			return static_cast<uint32_t>(images.size());
+		}
+
+		uint32_t getLayerCount() const
+		{
+			return texture ? texture->layerCount : 0;
+		}
+
+		// Packs all images into as few layers as possible using rows ("shelves") of images sorted by height, then creates the array texture and rect table
+		void build()
+		{
+			assert(texture == nullptr);
+			assert(!images.empty());
+
+			std::vector<uint32_t> order(images.size());
+			for (uint32_t i = 0; i < order.size(); i++) {
+				order[i] = i;
+			}
+			std::stable_sort(order.begin(), order.end(), [this](uint32_t a, uint32_t b) { return images[a].height > images[b].height; });
+
+			// Images are packed in units
+			const uint32_t layerUnits = layerSize / unitSize;
+
+			struct Placement {
+				uint32_t x{ 0 };
+				uint32_t y{ 0 };
+				uint32_t layer{ 0 };
+			};
+			std::vector<Placement> placements(images.size());
+			uint32_t layer{ 0 }, x{ 0 }, y{ 0 }, shelfHeight{ 0 };
+			for (uint32_t index : order) {
+				const uint32_t width = images[index].width / unitSize + padding * 2;
+				const uint32_t height = images[index].height / unitSize + padding * 2;
+				if (x + width > layerUnits) {
+					x = 0;
+					y += shelfHeight;
+					shelfHeight = 0;
+				}
+				if (y + height > layerUnits) {
+					layer++;
+					x = 0;
+					y = 0;
+					shelfHeight = 0;
+				}
+				placements[index] = { .x = x + padding, .y = y + padding, .layer = layer };
+				x += width;
+				shelfHeight = std::max(shelfHeight, height);
+			}
+			const uint32_t layerCount = layer + 1;
+
+			// The layers are composed directly in the staging buffer
+			const size_t layerBytes = static_cast<size_t>(layerUnits) * layerUnits * unitBytes;
+			Buffer* stagingBuffer = new Buffer({
+				.name = "Texture atlas staging buffer",
+				.usageFlags = VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+				.size = layerBytes * layerCount,
+				.map = true
+			});
+			uint8_t* pixels = static_cast<uint8_t*>(stagingBuffer->mapped);
+			// All zero is transparent black for both RGBA8 and BC3
+			memset(pixels, 0, layerBytes * layerCount);
+			rects.resize(images.size());
+			for (size_t i = 0; i < images.size(); i++) {
+				const Placement& placement = placements[i];
+				blit(&pixels[layerBytes * placement.layer], images[i], placement.x, placement.y);
+				rects[i] = {
+					.uv = glm::vec4(placement.x * unitSize, placement.y * unitSize, placement.x * unitSize + images[i].width, placement.y * unitSize + images[i].height) / static_cast<float>(layerSize),
+					.layer = placement.layer
+				};
+			}
+
+			stagingBuffer->flush();
+			VkCommandBuffer copyCmd = VulkanContext::device->createCommandBuffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY, true);
+			texture = new Texture2D({
+				.buffer = pixels,
+				.bufferSize = layerBytes * layerCount,
+				.texWidth = layerSize,
+				.texHeight = layerSize,
+				.layerCount = layerCount,
+				.format = format,
+				.createSampler = false,
+				.viewType = VK_IMAGE_VIEW_TYPE_2D_ARRAY,
+				.generateMipmaps = false
+			}, copyCmd, stagingBuffer->buffer, 0);
+			VulkanContext::device->flushCommandBuffer(copyCmd, VulkanContext::graphicsQueue, true);
+			delete stagingBuffer;
+
+			rectBuffer = new Buffer({
+				.name = "Texture atlas rects",
+				.usageFlags = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+				.size = rects.size() * sizeof(TextureAtlasRect),
+				.data = rects.data()
+			});
+
+			std::cout << "Packed " << images.size() << " images into a " << (unitSize > 1 ? "BC3 compressed " : "") << "texture atlas with " << layerCount << " layers of " << layerSize << " x " << layerSize << " pixels\n";
+			images.clear();
+		}
+	};
+}
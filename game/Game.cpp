@@ -6,19 +6,18 @@
 
 #include "Game.hpp"
 
-void Game::Game::monsterSpawnPosition(Entities::Monster& monster)
+glm::vec2 Game::Game::monsterSpawnPosition()
 {
 	std::uniform_real_distribution<float> uniformDist(0.0, 1.0);
 	glm::vec2 ring{ playFieldSize.x * 1.5f, playFieldSize.x * 1.75f };
 	const float rho = sqrt((pow(ring[1], 2.0f) - pow(ring[0], 2.0f)) * uniformDist(randomEngine) + pow(ring[0], 2.0f));
 	const float theta = static_cast<float>(2.0f * M_PI * uniformDist(randomEngine));
-	monster.position = glm::vec2(rho * cos(theta), rho * sin(theta)) + player.position;
+	return glm::vec2(rho * cos(theta), rho * sin(theta)) + player.position;
 }
 
 Game::Game::Game()
 {
-	randomEngine.seed((unsigned)time(nullptr));
-	threadPool.setThreadCount(std::thread::hardware_concurrency());
+	setSeed(static_cast<uint32_t>(time(nullptr)));
 
 	// @todo: load from config file
 	playerWeaponTypes =
@@ -115,7 +114,7 @@ void Game::Game::spawnMonsters(uint32_t count)
 		std::uniform_int_distribution<uint32_t> rndWeapon(0, static_cast<uint32_t>(monsterWeaponTypes.size() - 1));
 
 		Entities::Monster m;
-		monsterSpawnPosition(m);
+		m.position = monsterSpawnPosition();
 		m.imageIndex = monster.imageIndex;
 		m.speed = speedDist(randomEngine);
 		m.scale = scaleDist(randomEngine);
@@ -133,20 +132,15 @@ void Game::Game::spawnMonsters(uint32_t count)
 			}
 		}
 
+		maxMonsterScale = std::max(maxMonsterScale, m.scale);
+
 		// @todo: testing only
 		//if (rndChance(randomEngine) < 25) {
 		//	m.weapons = { monsterWeaponTypes[rndWeapon(randomEngine)] };
 		//}
 	
-		// Replace dead monsters first
-		for (auto& mon : monsters) {
-			if (mon.state == Entities::State::Dead) {
-				mon = m;
-				continue;
-			}
-		}
-
-		monsters.push_back(m);
+		// Reuses the slot of a dead monster if available
+		monsters.add(m);
 	}
 }
 
@@ -166,14 +160,9 @@ void Game::Game::spawnProjectile(Entities::Source source, uint32_t imageIndex, g
 	projectile.state = Entities::State::Alive;
 	projectile.type = type;
 	projectile.target = target;
-	// Replace dead projectiles first
-	for (auto& proj : projectiles) {
-		if (proj.state == Entities::State::Dead) {
-			proj = projectile;
-			return;
-		}
-	}
-	projectiles.push_back(projectile);
+	projectile.previousPosition = projectile.position;
+	// Reuses the slot of a dead projectile if available
+	projectiles.add(projectile);
 }
 
 void Game::Game::spawnProjectile(Entities::Source source, uint32_t imageIndex, glm::vec2 position, glm::vec2 direction, Weapon weapon, std::optional<Entities::Entity> target)
@@ -204,26 +193,16 @@ void Game::Game::spawnProjectile(Entities::Source source, uint32_t imageIndex, g
 	if (source == Entities::Source::Monster) {
 		projectile.lightColor = { 25.0f, 0.0f, 0.0f };
 	}
-	// Replace dead projectiles first
-	for (auto& proj : projectiles) {
-		if (proj.state == Entities::State::Dead) {
-			proj = projectile;
-			return;
-		}
-	}
-	projectiles.push_back(projectile);
+	projectile.previousPosition = projectile.position;
+	// Reuses the slot of a dead projectile if available
+	projectiles.add(projectile);
 }
 
 void Game::Game::spawnPickup(Entities::Pickup pickup)
 {
-	// Replace dead pickups first
-	for (auto& pup : pickups) {
-		if (pup.state == Entities::State::Dead) {
-			pup = pickup;
-			return;
-		}
-	}
-	pickups.push_back(pickup);
+	pickup.previousPosition = pickup.position;
+	// Reuses the slot of a dead pickup if available
+	pickups.add(pickup);
 }
 
 void Game::Game::spawnNumber(uint32_t value, glm::vec2 position, Entities::Effect effect)
@@ -238,23 +217,16 @@ void Game::Game::spawnNumber(uint32_t value, glm::vec2 position, Entities::Effec
 		number.setEffect(effect);
 		number.scale *= 1.5f;
 	}
-	// Replace unused numbers first
-	for (auto& num : numbers) {
-		if (num.state == Entities::State::Dead) {
-			num = number;
-			return;
-		}
-	}
-	numbers.push_back(number);
+	number.previousPosition = number.position;
+	// Reuses the slot of a dead number if available
+	numbers.add(number);
 }
 
-void Game::Game::weaponTrigger(Entities::Entity& source, Weapon& weapon)
+void Game::Game::weaponTrigger(Entities::Source sourceType, glm::vec2 position, glm::vec2 direction, Weapon& weapon)
 {
 	// @todo
 	uint32_t imageIndex = projectileImageIndex;
-	Entities::Source sourceType = Entities::Source::Player;
-	if (dynamic_cast<Entities::Monster*>(&source)) {
-		sourceType = Entities::Source::Monster;
+	if (sourceType == Entities::Source::Monster) {
 		imageIndex = projectileImageIndexMonster;
 	}
 	bool playSound = false;
@@ -266,15 +238,15 @@ void Game::Game::weaponTrigger(Entities::Entity& source, Weapon& weapon)
 			{
 				// Single bullet in a random direction
 				std::uniform_real_distribution<float> dirDist(-1.0f, 1.0f);
-				spawnProjectile(sourceType, imageIndex, source.position, glm::vec2(dirDist(randomEngine), dirDist(randomEngine)), weapon);
+				spawnProjectile(sourceType, imageIndex, position, glm::vec2(dirDist(randomEngine), dirDist(randomEngine)), weapon);
 				playSound = true;
 				break;
 			}
 			case 1:
 			{
 				// Single bullet in entity direction
-				if (glm::length(source.direction) != 0.0f) {
-					spawnProjectile(sourceType, imageIndex, source.position, source.direction, weapon);
+				if (glm::length(direction) != 0.0f) {
+					spawnProjectile(sourceType, imageIndex, position, direction, weapon);
 					playSound = true;
 				}
 				break;
@@ -287,7 +259,7 @@ void Game::Game::weaponTrigger(Entities::Entity& source, Weapon& weapon)
 				for (auto i = 0; i < count; i++) {
 					const float angle{ (float)i * dist };
 					const glm::vec2 direction = normalize(glm::vec2(sin(angle * M_PI / 180.0f), cos(angle * M_PI / 180.0f)));
-					spawnProjectile(sourceType, imageIndex, source.position, direction, weapon);
+					spawnProjectile(sourceType, imageIndex, position, direction, weapon);
 				}
 				playSound = true;
 				break;
@@ -302,7 +274,7 @@ void Game::Game::weaponTrigger(Entities::Entity& source, Weapon& weapon)
 				for (auto i = 0; i < count; i++) {
 					const float angle{ (float)i * dist + rotOffset };
 					const glm::vec2 direction = normalize(glm::vec2(sin(angle * M_PI / 180.0f), cos(angle * M_PI / 180.0f)));
-					spawnProjectile(sourceType, imageIndex, source.position, direction, weapon);
+					spawnProjectile(sourceType, imageIndex, position, direction, weapon);
 				}
 				playSound = true;
 				break;
@@ -315,10 +287,10 @@ void Game::Game::weaponTrigger(Entities::Entity& source, Weapon& weapon)
 				target = findClosestEnemy();
 			};
 			if (sourceType == Entities::Source::Monster) {
-				target = player;
+				target = static_cast<Entities::Entity>(player);
 			}
 			if (target.has_value()) {
-				spawnProjectile(sourceType, imageIndex, source.position, glm::vec2(0.0f), weapon, target);
+				spawnProjectile(sourceType, imageIndex, position, glm::vec2(0.0f), weapon, target);
 				playSound = true;
 			}
 			// @todo
@@ -331,13 +303,14 @@ void Game::Game::weaponTrigger(Entities::Entity& source, Weapon& weapon)
 }
 
 // @todo: rework
-void Game::Game::monsterWeaponTrigger(Entities::Monster& monster)
+void Game::Game::monsterWeaponTrigger(uint32_t index, float delta)
 {
-	for (auto& weapon : monster.weapons) {
-		if (!monster.visible) {
+	for (auto& weapon : monsters.weapons[index]) {
+		weapon.update(delta);
+		if (!monsters.visible[index]) {
 			continue;
 		}
-		weaponTrigger(monster, weapon);
+		weaponTrigger(Entities::Source::Monster, monsters.position[index], monsters.direction[index], weapon);
 	}
 }
 
@@ -348,107 +321,344 @@ void Game::Game::playerWeaponTrigger()
 		// @todo: Multiple weapons, each with their own cooldown
 		// @todo: Idea: Just drop in place of player (e.g. a bomb)
 		// @todo: Idea: Rotating patterns (e.g. cross and then rotate that slowly)
-		weaponTrigger(player, weapon);
+		weaponTrigger(Entities::Source::Player, player.position, player.direction, weapon);
 	}
 }
 
-void Game::Game::monsterProjectileCollisionCheck(Entities::Monster& monster)
+void Game::Game::updateProjectileGrids()
 {
-	std::uniform_real_distribution<float> critDist(0.0, 100.0f);
-	for (auto& projectile : projectiles) {
+	// Cell size needs to cover the largest collision radius, so a query only has to visit neighbouring cells
+	playerProjectileGrid.setCellSize(maxMonsterScale);
+	monsterProjectileGrid.setCellSize(std::max(player.scale, 1.0f));
+	playerProjectileGrid.clear();
+	monsterProjectileGrid.clear();
+	for (uint32_t i = 0; i < projectiles.size(); i++) {
+		const Entities::Projectile& projectile = projectiles[i];
 		if (projectile.state == Entities::State::Dead) {
 			continue;
 		}
 		if (projectile.source == Entities::Source::Player) {
-			// @todo: Proper collision check
-			if (abs(glm::distance(monster.position, projectile.position)) < monster.scale) {
-				// @todo: Projectiles that can hit multiple enemies before "dying"
-				projectile.state = Entities::State::Dead;
-				// @todo: Move logic to entity
-				float damage = projectile.damage;
-				// @todo: Move elsewhere
-				if (critDist(randomEngine) <= player.criticalChance) {
-					damage *= player.criticalDamageMultiplier;
-					projectile.effect = Entities::Effect::Critical;
-				}
-				// @todo: Get from weapon for different effects (e.g. for damage types without a moving direction)
-				monster.velocity += projectile.direction * 5.0f;
-				monster.health -= damage;
-				monster.setEffect(Entities::Effect::Hit);
-				spawnNumber(damage, monster.position, projectile.effect);
-				// @todo: Use instance color and timer to highlight hit monsters for a short duration
-				if (monster.health <= 0.0f) {
-					monster.state = Entities::State::Dead;
-					// @todo
-					Entities::Pickup xpPickup{};
-					xpPickup.type = Entities::Pickup::Type::Experience;
-					xpPickup.position = monster.position;
-					xpPickup.value = 10;
-					xpPickup.imageIndex = experienceImageIndex;
-					xpPickup.scale = 0.5f;
-					xpPickup.speed = player.speed * 2.0f;
-					if (monster.isBoss) {
-						xpPickup.value = 100;
-						xpPickup.scale = 1.5f;
-					}
-					spawnPickup(xpPickup);
-					audioManager->playSnd("enemydeath");
-					currentRun.monstersKilled++;
-				}
-				else {
-					audioManager->playSnd("enemyhit");
-				}
+			playerProjectileGrid.insert(i, projectile.position);
+		} else {
+			monsterProjectileGrid.insert(i, projectile.position);
+		}
+	}
+	playerProjectileGrid.build();
+	monsterProjectileGrid.build();
+}
+
+void Game::Game::updateMonsters(size_t start, size_t end, float delta, MonsterEventBuffer& eventBuffer)
+{
+	// Hot monster data is stored as separate arrays, so this loop only touches what it needs
+	// Only data of monsters in the given range is written, everything else is recorded as an event
+	for (auto i = start; i < end; i++) {
+		const uint32_t index = static_cast<uint32_t>(i);
+		if (monsters.state[i] == Entities::State::Dead) {
+			monsters.visible[i] = false;
+			continue;
+		}
+		// @todo: simple "logic" for testing
+		monsters.updateEffect(index, delta);
+		// Monsters far away respawn outside of the view
+		// Spawn positions use the shared random engine, so this is deferred, the monster is moved once it has been respawned
+		if (glm::length(player.position - monsters.position[i]) > playFieldSize.x * 3.0f) {
+			monsters.visible[i] = false;
+			eventBuffer.add(MonsterEventType::Respawn, index);
+			continue;
+		};
+		moveMonster(index, delta, eventBuffer);
+	}
+}
+
+void Game::Game::moveMonster(uint32_t index, float delta, MonsterEventBuffer& eventBuffer)
+{
+	glm::vec2& position = monsters.position[index];
+	glm::vec2& velocity = monsters.velocity[index];
+	glm::vec2& direction = monsters.direction[index];
+	monsters.visible[index] = glm::length(player.position - position) < std::max(playFieldSize.x, playFieldSize.y) * 1.5f;
+
+	direction = glm::normalize(player.position - position);
+	velocity += direction * monsters.speed[index] * 0.01f;
+	if (glm::length(direction) > 0.0f) {
+		if (glm::length(velocity) > 0.1f) {
+			position += velocity * delta * 100.0f;
+			velocity *= 0.01f * delta;
+		}
+	}
+	monsterProjectileCollisionCheck(index, eventBuffer);
+	// Hits may kill the monster, which is checked when the event is applied
+	if (glm::distance(player.position, position) < monsters.scale[index]) {
+		eventBuffer.add(MonsterEventType::PlayerContact, index);
+	}
+}
+
+void Game::Game::applyMonsterEvents(const MonsterEventBuffer& eventBuffer, float delta)
+{
+	for (const MonsterEvent& event : eventBuffer.events) {
+		const uint32_t index = event.monsterIndex;
+		switch (event.type) {
+		case MonsterEventType::ProjectileHit:
+			monsterProjectileHit(index, event.projectileIndex);
+			break;
+		case MonsterEventType::PlayerContact:
+			if (monsters.state[index] == Entities::State::Dead) {
+				break;
+			}
+			// @todo: put into function
+			if (player.invincibilityTimer <= 0.0f) {
+				// @todo: damage from monster
+				player.health -= 1.0f;
+				player.invincibilityTimer = 1.0f;
 			}
-			//if (projectile.state == Entities::State::Dead) {
-			//	break;
-			//}
+			break;
+		case MonsterEventType::Respawn: {
+			monsters.position[index] = monsterSpawnPosition();
+			monsters.previousPosition[index] = monsters.position[index];
+			// Respawned monsters still move and collide in this tick like all others, spawn positions are close enough to never trigger another respawn
+			MonsterEventBuffer respawnEvents;
+			moveMonster(index, delta, respawnEvents);
+			applyMonsterEvents(respawnEvents, delta);
+			break;
+		}
 		}
 	}
 }
 
-void Game::Game::playerProjectileCollisionCheck()
+void Game::Game::monsterProjectileCollisionCheck(uint32_t index, MonsterEventBuffer& eventBuffer)
+{
+	const glm::vec2 position = monsters.position[index];
+	const float scale = monsters.scale[index];
+	// Only player projectiles in cells close to the monster need to be checked
+	playerProjectileGrid.query(position, scale, [&](uint32_t projectileIndex) {
+		const Entities::Projectile& projectile = projectiles[projectileIndex];
+		if (projectile.state == Entities::State::Dead) {
+			return;
+		}
+		// @todo: Proper collision check
+		if (abs(glm::distance(position, projectile.position)) < scale) {
+			eventBuffer.add(MonsterEventType::ProjectileHit, index, projectileIndex);
+		}
+	});
+}
+
+void Game::Game::monsterProjectileHit(uint32_t index, uint32_t projectileIndex)
 {
+	Entities::Projectile& projectile = projectiles[projectileIndex];
+	// Projectile may already have hit a monster recorded earlier
+	if ((projectile.state == Entities::State::Dead) || (monsters.state[index] == Entities::State::Dead)) {
+		return;
+	}
 	std::uniform_real_distribution<float> critDist(0.0, 100.0f);
-	for (auto& projectile : projectiles) {
+	const glm::vec2 position = monsters.position[index];
+	// @todo: Projectiles that can hit multiple enemies before "dying"
+	projectile.state = Entities::State::Dead;
+	projectiles.release(projectileIndex);
+	// @todo: Move logic to entity
+	float damage = projectile.damage;
+	// @todo: Move elsewhere
+	if (critDist(randomEngine) <= player.criticalChance) {
+		damage *= player.criticalDamageMultiplier;
+		projectile.effect = Entities::Effect::Critical;
+	}
+	// @todo: Get from weapon for different effects (e.g. for damage types without a moving direction)
+	monsters.velocity[index] += projectile.direction * 5.0f;
+	monsters.health[index] -= damage;
+	monsters.setEffect(index, Entities::Effect::Hit);
+	spawnNumber(damage, position, projectile.effect);
+	// @todo: Use instance color and timer to highlight hit monsters for a short duration
+	if (monsters.health[index] <= 0.0f) {
+		// @todo
+		Entities::Pickup xpPickup{};
+		xpPickup.type = Entities::Pickup::Type::Experience;
+		xpPickup.position = position;
+		xpPickup.value = 10;
+		xpPickup.imageIndex = experienceImageIndex;
+		xpPickup.scale = 0.5f;
+		xpPickup.speed = player.speed * 2.0f;
+		if (monsters.isBoss(index)) {
+			const Entities::BossData& boss = monsters.bosses[index];
+			xpPickup.value = boss.experience;
+			xpPickup.scale = boss.pickupScale;
+		}
+		spawnPickup(xpPickup);
+		monsters.release(index);
+		playSound("enemydeath");
+		currentRun.monstersKilled++;
+	}
+	else {
+		playSound("enemyhit");
+	}
+}
+
+void Game::Game::updateTiles()
+{
+	// Walls stop all projectiles, player projectiles crack walls and break cracked ones
+	for (uint32_t i = 0; i < projectiles.size(); i++) {
+		Entities::Projectile& projectile = projectiles[i];
 		if (projectile.state == Entities::State::Dead) {
 			continue;
 		}
-		if (projectile.source == Entities::Source::Monster) {
-			// @todo: Proper collision check
-			if (abs(glm::distance(player.position, projectile.position)) < player.scale) {
-				// @todo: Projectiles that can hit multiple enemies before "dying"
-				projectile.state = Entities::State::Dead;
-				// @todo: Move logic to entity
-				float damage = projectile.damage;
-				// @todo: Move elsewhere
-				//if (critDist(randomEngine) <= player.criticalChance) {
-				//	damage *= player.criticalDamageMultiplier;
-				//	projectile.effect = Entities::Effect::Critical;
-				//}
-				// @todo: Get from weapon for different effects (e.g. for damage types without a moving direction)
-				//player.velocity += projectile.direction * 5.0f;
-				if (player.invincibilityTimer <= 0.0f) {
-					// @todo: damage from monster
-					player.health -= damage;
-					player.invincibilityTimer = 1.0f;
-				}
-				player.setEffect(Entities::Effect::Hit);
-				//spawnNumber(damage, monster.position, projectile.effect);
-				if (player.health <= 0.0f) {
-					// @todo
-				} else {
-					//audioManager->playSnd("enemyhit");
-				}
+		const glm::ivec2 tilePos = Tilemap::tilePosFromWorldPos(projectile.position);
+		if (tilemap.getTile(tilePos.x, tilePos.y, TilemapLayer::Decoration) != Tiles::Wall) {
+			continue;
+		}
+		projectile.state = Entities::State::Dead;
+		projectiles.release(i);
+		if (projectile.source == Entities::Source::Player) {
+			if (tilemap.getTile(tilePos.x, tilePos.y, TilemapLayer::Overlay) == Tiles::Crack) {
+				tilemap.setTile(tilePos.x, tilePos.y, TilemapLayer::Decoration, Tiles::Empty);
+				tilemap.setTile(tilePos.x, tilePos.y, TilemapLayer::Overlay, Tiles::Empty);
+			} else {
+				tilemap.setTile(tilePos.x, tilePos.y, TilemapLayer::Overlay, Tiles::Crack);
+			}
+		}
+	}
+
+	// Water tiles around the player flood one of their neighbours, which is picked by hashing so it doesn't use up values of the random engine
+	if ((waterSpreadInterval == 0) || (tickCount % waterSpreadInterval != 0)) {
+		return;
+	}
+	const glm::ivec2 offsets[4] = { { -1, 0 }, { 1, 0 }, { 0, -1 }, { 0, 1 } };
+	const glm::ivec2 playerTilePos = Tilemap::tilePosFromWorldPos(player.position);
+	const int32_t radius = static_cast<int32_t>(TILEMAP_CHUNK_DIM);
+	// Collected first, so water only spreads by one tile per step
+	std::vector<glm::ivec2> flooded;
+	for (int32_t y = playerTilePos.y - radius; y <= playerTilePos.y + radius; y++) {
+		for (int32_t x = playerTilePos.x - radius; x <= playerTilePos.x + radius; x++) {
+			// Border water doesn't spread
+			if (!tilemap.canFlood(x, y) || (tilemap.getTile(x, y) != Tiles::Water)) {
+				continue;
+			}
+			const uint32_t hash = (static_cast<uint32_t>(x) * 73856093u) ^ (static_cast<uint32_t>(y) * 19349663u) ^ (static_cast<uint32_t>(tickCount) * 83492791u);
+			const glm::ivec2 target = glm::ivec2(x, y) + offsets[(hash >> 4) % 4];
+			if (!tilemap.canFlood(target.x, target.y)) {
+				continue;
+			}
+			const uint16_t ground = tilemap.getTile(target.x, target.y);
+			if ((ground != Tiles::Water) && (tilemap.getTile(target.x, target.y, TilemapLayer::Decoration) == Tiles::Empty)) {
+				flooded.push_back(target);
 			}
-			//if (projectile.state == Entities::State::Dead) {
-			//	break;
-			//}
 		}
 	}
+	for (auto& tilePos : flooded) {
+		tilemap.setTile(tilePos.x, tilePos.y, TilemapLayer::Ground, Tiles::Water);
+	}
+}
+
+void Game::Game::playerProjectileCollisionCheck()
+{
+	// Only monster projectiles in cells close to the player need to be checked
+	monsterProjectileGrid.query(player.position, player.scale, [&](uint32_t index) {
+		Entities::Projectile& projectile = projectiles[index];
+		if (projectile.state == Entities::State::Dead) {
+			return;
+		}
+		// @todo: Proper collision check
+		if (abs(glm::distance(player.position, projectile.position)) < player.scale) {
+			// @todo: Projectiles that can hit multiple enemies before "dying"
+			projectile.state = Entities::State::Dead;
+			projectiles.release(index);
+			// @todo: Move logic to entity
+			float damage = projectile.damage;
+			// @todo: Get from weapon for different effects (e.g. for damage types without a moving direction)
+			//player.velocity += projectile.direction * 5.0f;
+			if (player.invincibilityTimer <= 0.0f) {
+				// @todo: damage from monster
+				player.health -= damage;
+				player.invincibilityTimer = 1.0f;
+			}
+			player.setEffect(Entities::Effect::Hit);
+			//spawnNumber(damage, monster.position, projectile.effect);
+			if (player.health <= 0.0f) {
+				// @todo
+			} else {
+				//audioManager->playSnd("enemyhit");
+			}
+		}
+	});
+}
+
+void Game::Game::storePreviousPositions()
+{
+	player.previousPosition = player.position;
+	std::copy(monsters.position.begin(), monsters.position.end(), monsters.previousPosition.begin());
+	for (auto& projectile : projectiles) {
+		projectile.previousPosition = projectile.position;
+	}
+	for (auto& pickup : pickups) {
+		pickup.previousPosition = pickup.position;
+	}
+	for (auto& number : numbers) {
+		number.previousPosition = number.position;
+	}
+}
+
+void Game::Game::setSeed(uint32_t seed)
+{
+	this->seed = seed;
+	randomEngine.seed(seed);
+}
+
+uint32_t Game::Game::getSeed() const
+{
+	return seed;
+}
+
+void Game::Game::start(uint32_t initialMonsterCount)
+{
+	// Everything the simulation depends on starts from a known state, so runs with the same seed and input are identical
+	randomEngine.seed(seed);
+	tilemap.setSeed(seed);
+	tickCount = 0;
+	tickAccumulator = 0.0f;
+
+	player.speed = 5.0f;
+	player.scale = 1.0f;
+	player.position = glm::vec2((float)tilemap.width / 2.0f, (float)tilemap.height / 2.0f);
+	player.previousPosition = player.position;
+	player.experience = 0.0f;
+	player.level = 0;
+	// @todo: Proper weapon setup/selection
+	player.weapons.resize(1);
+	player.weapons[0] = playerWeaponTypes[1];
+
+	spawnMonsters(initialMonsterCount);
+}
+
+uint32_t Game::Game::advanceTime(float frameTime)
+{
+	// Limit the no. of ticks after long stalls (e.g. when debugging), so the simulation doesn't fall further behind
+	const float maxFrameTime = 0.25f;
+	tickAccumulator += std::min(frameTime, maxFrameTime);
+	const uint32_t ticks = static_cast<uint32_t>(tickAccumulator / tickDuration);
+	tickAccumulator -= static_cast<float>(ticks) * tickDuration;
+	return ticks;
+}
+
+void Game::Game::tick(const InputState& input)
+{
+	storePreviousPositions();
+	update(tickDuration);
+	updateInput(input, tickDuration);
+	tickCount++;
+}
+
+float Game::Game::getInterpolationFactor() const
+{
+	return std::clamp(tickAccumulator / tickDuration, 0.0f, 1.0f);
+}
+
+void Game::Game::playSound(const std::string& name)
+{
+	if (onPlaySound) {
+		onPlaySound(name);
+	}
 }
 
 void Game::Game::update(float delta)
 {
+	ScopedTimer totalTimer(updateTimings.total);
+
 	// @todo: totally work in progress
 	// @todo: use multi threading
 
@@ -525,11 +735,15 @@ void Game::Game::update(float delta)
 
 	{
 		ZoneScopedN("Entity updates");
+		ScopedTimer timer(updateTimings.entityUpdates);
 
 		player.update(delta);
 
-		threadPool.threads[0]->addJob([=] {
-			for (auto& pickup : pickups) {
+		// Each job only releases slots of its own pool, so free lists are never modified by multiple threads at once
+		vks::JobCounter entityJobs;
+		jobSystem.run([=, this] {
+			for (uint32_t i = 0; i < pickups.size(); i++) {
+				Entities::Pickup& pickup = pickups[i];
 				if (pickup.state == Entities::State::Dead) {
 					continue;
 				}
@@ -543,8 +757,9 @@ void Game::Game::update(float delta)
 						// @todo: Proper collision check
 						if (glm::distance(player.position, pickup.position) < 1.0f) {
 							pickup.state = Entities::State::Dead;
+							pickups.release(i);
 							player.addExperience(pickup.value);
-							audioManager->playSnd("pickupxp");
+							playSound("pickupxp");
 							// @todo: move to somewhere else
 							if (player.experience >= getNextLevelExp(player.level + 1)) {
 								player.level++;
@@ -555,11 +770,14 @@ void Game::Game::update(float delta)
 					}
 				}
 			}
-		});
+		}, &entityJobs);
 
-		threadPool.threads[1]->addJob([=] { 
-			for (auto i = 0; i < projectiles.size(); i++) {
+		jobSystem.run([=, this] {
+			for (uint32_t i = 0; i < projectiles.size(); i++) {
 				Entities::Projectile& projectile = projectiles[i];
+				if (projectile.state == Entities::State::Dead) {
+					continue;
+				}
 				// @todo: update function
 				if (projectile.type == Entities::ProjectileType::Homing && projectile.target.has_value()) {
 					// @todo: what to do if target has died?
@@ -569,103 +787,105 @@ void Game::Game::update(float delta)
 				projectile.life -= delta * 50.0f;
 				if (projectile.life <= 0.0f) {
 					projectile.state = Entities::State::Dead;
+					projectiles.release(i);
 				}
 			}
-		});
+		}, &entityJobs);
 
-		threadPool.threads[2]->addJob([=] {
-			for (auto i = 0; i < numbers.size(); i++) {
+		jobSystem.run([=, this] {
+			for (uint32_t i = 0; i < numbers.size(); i++) {
 				Entities::Number& number = numbers[i];
+				if (number.state == Entities::State::Dead) {
+					continue;
+				}
 				number.position += number.direction * number.speed * delta;
 				number.life -= delta * 50.0f;
 				if (number.life <= 0.0f) {
 					number.state = Entities::State::Dead;
+					numbers.release(i);
 				}
 			}
-		});
+		}, &entityJobs);
 
-		threadPool.threads[2]->addJob([=] {
-			playerProjectileCollisionCheck();
-		});
-
-		// @todo: set min. no of monsters per thread for lower monster counts
-		// @todo: vectors are not thread safe, this is bound to randomly crash
-		const int32_t maxHardwareThreads = static_cast<int32_t>(std::thread::hardware_concurrency());
-		//const auto maxMonsterThreads = std::max(maxHardwareThreads - 3, 1);
-		auto maxMonsterThreads = 1;
-
-		const auto mtSize = monsters.size() / maxMonsterThreads;
-		for (auto t = 0; t < maxMonsterThreads; t++) {
-			threadPool.threads[3 + t]->addJob([=] {
-				const auto start = t * mtSize;
-				auto end = start + mtSize;
-				if (end > monsters.size()) {
-					end = monsters.size();
-				}
-				for (auto i = start; i < end; i++) {
-					Entities::Monster& monster = monsters[i];
-					if (monster.state == Entities::State::Dead) {
-						monster.visible = false;
-						continue;
-					}
-					// @todo: simple "logic" for testing
-					monster.update(delta);
-					// Monsters far away respawn outside of the view
-					if (glm::length(player.position - monster.position) > playFieldSize.x * 3.0f) {
-						monsterSpawnPosition(monster);
-					};
-					monster.visible = glm::length(player.position - monster.position) < std::max(playFieldSize.x, playFieldSize.y) * 1.5f;
-
-					monster.direction = glm::normalize(player.position - monster.position);
-					monster.velocity += monster.direction * monster.speed * 0.01f;
-					if (glm::length(monster.direction) > 0.0f) {
-						//monster.position += monster.direction * monster.speed * delta;
-						if (glm::length(monster.velocity) > 0.1f) {
-							monster.position += monster.velocity * delta * 100.0f;
-							monster.velocity *= 0.01f * delta;
-						}
-					}
-					monsterProjectileCollisionCheck(monster);
-					// @todo: thread saftey
-					if (monster.state != Entities::State::Dead) {
-						if (glm::distance(player.position, monster.position) < monster.scale) {
-							// @todo: put into function
-							if (player.invincibilityTimer <= 0.0f) {
-								// @todo: damage from monster
-								player.health -= 1.0f;
-								player.invincibilityTimer = 1.0f;
-							}
-						}
-					}
-				}
+		// Collision checks need up-to-date projectile positions
+		jobSystem.wait(entityJobs);
+
+		// Before the collision grids are built, so projectiles stopped by walls can't hit monsters
+		{
+			ZoneScopedN("Tile updates");
+			ScopedTimer timer(updateTimings.tiles);
+			updateTiles();
+		}
+
+		{
+			ZoneScopedN("Collision grid update");
+			ScopedTimer timer(updateTimings.collisionGrid);
+			updateProjectileGrids();
+		}
+
+		// Monsters are updated in parallel ranges, each range records events into its own buffer
+		// These are then applied in range order on this thread, so the outcome is deterministic
+		const size_t grainSize = std::max(monsterUpdateGrainSize, size_t(1));
+		const size_t rangeCount = (monsters.size() + grainSize - 1) / grainSize;
+		if (monsterEventBuffers.size() < rangeCount) {
+			monsterEventBuffers.resize(rangeCount);
+		}
+		{
+			ZoneScopedN("Monster updates");
+			ScopedTimer timer(updateTimings.monsters);
+			jobSystem.parallelFor(0, monsters.size(), grainSize, [=, this](size_t start, size_t end) {
+				MonsterEventBuffer& eventBuffer = monsterEventBuffers[start / grainSize];
+				eventBuffer.clear();
+				updateMonsters(start, end, delta, eventBuffer);
 			});
 		}
 
-		threadPool.wait();
+		{
+			ZoneScopedN("Monster events");
+			ScopedTimer timer(updateTimings.monsterEvents);
+			for (size_t i = 0; i < rangeCount; i++) {
+				applyMonsterEvents(monsterEventBuffers[i], delta);
+			}
+		}
+
+		// Done after monster events have been applied, as both release projectiles
+		{
+			ZoneScopedN("Player collision");
+			ScopedTimer timer(updateTimings.playerCollision);
+			playerProjectileCollisionCheck();
+		}
 	}
 
 	// Monster projectiles
 	// @todo: thread?
-	for (auto& monster : monsters) {
-		if ((monster.state == Entities::State::Dead) || (monster.weapons.empty())) {
-			continue;
+	{
+		ZoneScopedN("Monster weapons");
+		ScopedTimer timer(updateTimings.monsterWeapons);
+		// Only armed monsters are stored in the weapon table, so there is no need to visit all monsters
+		for (auto& [index, weapons] : monsters.weapons) {
+			if (monsters.state[index] == Entities::State::Dead) {
+				continue;
+			}
+			monsterWeaponTrigger(index, delta);
 		}
-		monsterWeaponTrigger(monster);
 	}
 
-
 	// Monster spawn
-	spawnTriggerTimer += delta * 25.0f;
-	if (spawnTriggerTimer > spawnTriggerDuration) {
-		spawnTriggerTimer = 0.0f;
-		spawnMonsters(spawnTriggerMonsterCount);
+	{
+		ZoneScopedN("Monster spawn");
+		ScopedTimer timer(updateTimings.spawn);
+		spawnTriggerTimer += delta * 25.0f;
+		if (spawnTriggerTimer > spawnTriggerDuration) {
+			spawnTriggerTimer = 0.0f;
+			spawnMonsters(spawnTriggerMonsterCount);
+		}
 	}
 }
 
-void Game::Game::updateInput(float delta)
+void Game::Game::updateInput(const InputState& input, float delta)
 {
 	float playerSpeed = player.speed;
-	if (sf::Keyboard::isKeyPressed(sf::Keyboard::LShift)) {
+	if (input.sprint) {
 		if (player.stamina > 0.0f) {
 			playerSpeed *= 2.0f;
 		}
@@ -683,16 +903,16 @@ void Game::Game::updateInput(float delta)
 	}
 	player.direction = glm::vec2(.0f, .0f);
 	glm::ivec2 playerTilePos = tilemap.tilePosFromVisualPos(player.position);
-	if (sf::Keyboard::isKeyPressed(sf::Keyboard::A)) {
+	if (input.moveLeft) {
 		player.direction.x = -1.0f;
 	}
-	if (sf::Keyboard::isKeyPressed(sf::Keyboard::D)) {
+	if (input.moveRight) {
 		player.direction.x = 1.0f;
 	}
-	if (sf::Keyboard::isKeyPressed(sf::Keyboard::W)) {
+	if (input.moveUp) {
 		player.direction.y = -1.0f;
 	}
-	if (sf::Keyboard::isKeyPressed(sf::Keyboard::S)) {
+	if (input.moveDown) {
 		player.direction.y = 1.0f;
 	}
 	// @todo: proper collision check and use velocity
@@ -706,35 +926,43 @@ void Game::Game::updateInput(float delta)
 		if ((newPlayerPos.y > (tilemap.height - 1) / tilemap.screenFactor.y) || (newPlayerPos.x > (tilemap.width - 1) / tilemap.screenFactor.x)) {
 			move = false;
 		}
+		// Walls block the player, unless the player already stands inside of one (e.g. after spawning there)
+		const glm::ivec2 newTilePos = Tilemap::tilePosFromWorldPos(newPlayerPos);
+		if ((newTilePos != Tilemap::tilePosFromWorldPos(player.position)) && (tilemap.getTile(newTilePos.x, newTilePos.y, TilemapLayer::Decoration) == Tiles::Wall)) {
+			move = false;
+		}
 		if (move) {
 			player.position = newPlayerPos;
 		}
 	}
 
-	if (sf::Keyboard::isKeyPressed(sf::Keyboard::Space)) {
+	if (input.push) {
 		// Testing
-		for (auto& monster : monsters) {
-			if (monster.state == Entities::State::Dead) {
+		for (uint32_t i = 0; i < monsters.size(); i++) {
+			if (monsters.state[i] == Entities::State::Dead) {
 				continue;
 			}
-			glm::vec2 dir = glm::normalize(monster.position - player.position);
-			monster.velocity += dir * 0.5f;
+			glm::vec2 dir = glm::normalize(monsters.position[i] - player.position);
+			monsters.velocity[i] += dir * 0.5f;
 		}
 	}
 
 }
 
-std::optional<Game::Entities::Monster> Game::Game::findClosestEnemy()
+std::optional<Game::Entities::Entity> Game::Game::findClosestEnemy()
 {
-	std::optional<Entities::Monster> result = std::nullopt;
+	std::optional<Entities::Entity> result = std::nullopt;
 	float distance = std::numeric_limits<float>::max();
-	for (auto& monster : monsters) {
-		if (monster.state == Entities::State::Dead) {
+	for (uint32_t i = 0; i < monsters.size(); i++) {
+		if (monsters.state[i] == Entities::State::Dead) {
 			continue;
 		}
-		if (glm::distance(player.position, monster.position) < distance) {
-			distance = glm::distance(player.position, monster.position);
-			result = monster;
+		if (glm::distance(player.position, monsters.position[i]) < distance) {
+			distance = glm::distance(player.position, monsters.position[i]);
+			Entities::Entity target{};
+			target.position = monsters.position[i];
+			target.scale = monsters.scale[i];
+			result = target;
 		}
 	}
 	return result;
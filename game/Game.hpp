@@ -9,39 +9,83 @@
 #include <vector>
 #include <random>
 #include <optional>
+#include <algorithm>
+#include <functional>
+#include <string>
 #include "time.h"
-#include <SFML/Window.hpp>
 #include <tracy/Tracy.hpp>
-#include <Threadpool.hpp>
+#include <JobSystem.hpp>
 
 #include "Run.hpp"
 #include "object_types/Monsters.hpp"
 #include "entities/Entity.hpp"
 #include "entities/Monster.hpp"
+#include "entities/MonsterStore.hpp"
 #include "entities/Player.hpp"
 #include "entities/Projectile.hpp"
 #include "entities/Pickup.hpp"
 #include "entities/Number.hpp"
 #include "Tilemap.hpp"
-
-#include "AudioManager.h"
+#include "SpatialGrid.hpp"
+#include "Pool.hpp"
+#include "MonsterEvents.hpp"
+#include "Input.hpp"
+#include "ScopedTimer.hpp"
 
 namespace Game {
 
+	enum class GameState {
+		Playing = 0,
+		LevelUp = 1
+	};
+
+	// CPU time spent in the different parts of the last update (in milliseconds)
+	struct UpdateTimings {
+		double total{ 0.0 };
+		// Includes all entity, collision, tile and monster updates below
+		double entityUpdates{ 0.0 };
+		double collisionGrid{ 0.0 };
+		double monsters{ 0.0 };
+		double monsterEvents{ 0.0 };
+		double playerCollision{ 0.0 };
+		double monsterWeapons{ 0.0 };
+		double spawn{ 0.0 };
+		double tiles{ 0.0 };
+	};
 
 	class Game {
 	private:
-		vks::ThreadPool threadPool;
-		void monsterSpawnPosition(Entities::Monster& monster);
+		GameState state{ GameState::Playing };
+		uint32_t seed{ 0 };
+		// Frame time that hasn't been simulated yet
+		float tickAccumulator{ 0.0f };
+		// Projectiles are bucketed by their source, so collision checks only need to query the relevant grid
+		SpatialGrid playerProjectileGrid;
+		SpatialGrid monsterProjectileGrid;
+		// One event buffer per parallel monster update range, kept across frames to reuse allocations
+		std::vector<MonsterEventBuffer> monsterEventBuffers;
+		glm::vec2 monsterSpawnPosition();
+		void updateProjectileGrids();
+		void updateMonsters(size_t start, size_t end, float delta, MonsterEventBuffer& eventBuffer);
+		// Movement, visibility and collision checks of a living monster that's not respawned
+		void moveMonster(uint32_t index, float delta, MonsterEventBuffer& eventBuffer);
+		void applyMonsterEvents(const MonsterEventBuffer& eventBuffer, float delta);
+		void monsterProjectileHit(uint32_t index, uint32_t projectileIndex);
+		void playSound(const std::string& name);
+		void storePreviousPositions();
+		// Tiles changed by gameplay (walls hit by projectiles and spreading water)
+		void updateTiles();
 	public:
+		// Also used by the application for parallel buffer updates, so there's only one set of worker threads
+		vks::JobSystem jobSystem;
 		std::default_random_engine randomEngine;
 
 		ObjectTypes::MonsterTypes monsterTypes{};
 		// @todo: Entity manager
-		std::vector<Entities::Monster> monsters;
-		std::vector<Entities::Projectile> projectiles;
-		std::vector<Entities::Pickup> pickups;
-		std::vector<Entities::Number> numbers;
+		Entities::MonsterStore monsters;
+		Pool<Entities::Projectile> projectiles;
+		Pool<Entities::Pickup> pickups;
+		Pool<Entities::Number> numbers;
 		Entities::Player player;
 		Tilemap tilemap;
 
@@ -65,13 +109,41 @@ namespace Game {
 
 		float dayNightCycle{ 0.75f };
 
+		// No. of monsters updated per job
+		size_t monsterUpdateGrainSize{ 256 };
+
+		// Largest monster scale spawned so far, used as the cell size for the collision grids
+		float maxMonsterScale{ 1.0f };
+
 		// @todo: load from config file
 		std::vector<Weapon> playerWeaponTypes{};
 		std::vector<Weapon> monsterWeaponTypes{};
 
 		Run currentRun;
 
+		// The simulation advances in ticks of fixed duration independent of the frame rate
+		// This keeps runs with the same seed and input reproducible
+		float tickDuration{ 1.0f / 60.0f };
+		uint64_t tickCount{ 0 };
+		// Water spreads by one tile around the player every this many ticks
+		uint32_t waterSpreadInterval{ TILEMAP_DEFAULT_WATER_SPREAD_INTERVAL };
+		UpdateTimings updateTimings{};
+
+		// Called whenever the game wants to play a sound, so the game itself doesn't depend on an audio backend
+		std::function<void(const std::string& name)> onPlaySound;
+
 		Game();
+		// Seeds the random engine (the seed is also reapplied when starting a run)
+		void setSeed(uint32_t seed);
+		uint32_t getSeed() const;
+		// Sets up the player and spawns the initial monsters, to be called once all assets are loaded
+		void start(uint32_t initialMonsterCount);
+		// Adds the frame time and returns the no. of ticks that need to be simulated for it
+		uint32_t advanceTime(float frameTime);
+		// Simulates one tick with the given input
+		void tick(const InputState& input);
+		// Where rendering is between the last two ticks (0..1), used to interpolate positions
+		float getInterpolationFactor() const;
 		void spawnMonsters(uint32_t count);
 		// @todo: use create info struct
 		void spawnProjectile(Entities::Source source, uint32_t imageIndex, glm::vec2 position, glm::vec2 direction, float speed = 15.0f, Entities::ProjectileType type = Entities::ProjectileType::Directional, std::optional<Entities::Entity> target = std::nullopt);
@@ -79,16 +151,20 @@ namespace Game {
 		void spawnPickup(Entities::Pickup pickup);
 		void spawnNumber(uint32_t value, glm::vec2 position, Entities::Effect effect = Entities::Effect::None);
 
-		void weaponTrigger(Entities::Entity& source, Weapon& weapon);
-		void monsterWeaponTrigger(Entities::Monster& monster);
+		void weaponTrigger(Entities::Source sourceType, glm::vec2 position, glm::vec2 direction, Weapon& weapon);
+		void monsterWeaponTrigger(uint32_t index, float delta);
 		void playerWeaponTrigger();
 
-		void monsterProjectileCollisionCheck(Entities::Monster& monster);
+		// Only records hits, as this is called from parallel monster updates
+		void monsterProjectileCollisionCheck(uint32_t index, MonsterEventBuffer& eventBuffer);
 		void playerProjectileCollisionCheck();
 		void update(float delta);
-		void updateInput(float delta);
+		void updateInput(const InputState& input, float delta);
+
+		void setState(GameState newState);
+		GameState getState() const;
 
-		std::optional<Entities::Monster> findClosestEnemy();
+		std::optional<Entities::Entity> findClosestEnemy();
 		int32_t getNextLevelExp(int32_t level);
 	};
 }
\ No newline at end of file
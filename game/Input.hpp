@@ -0,0 +1,23 @@
+/*
+* Copyright(C) 2026 by Sascha Willems - www.saschawillems.de
+*
+* This code is licensed under the MIT license(MIT) (http://opensource.org/licenses/MIT)
+*/
+
+#pragma once
+
+namespace Game {
+
+	// Platform independent input state
+	// Filled by the application from the keyboard, or scripted when running without a window
+	struct InputState {
+		bool moveLeft{ false };
+		bool moveRight{ false };
+		bool moveUp{ false };
+		bool moveDown{ false };
+		bool sprint{ false };
+		// Pushes all monsters away from the player (testing)
+		bool push{ false };
+	};
+
+}
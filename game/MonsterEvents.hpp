@@ -0,0 +1,46 @@
+/*
+* Copyright(C) 2026 by Sascha Willems - www.saschawillems.de
+*
+* This code is licensed under the MIT license(MIT) (http://opensource.org/licenses/MIT)
+*/
+
+#pragma once
+
+#include <vector>
+#include <stdint.h>
+
+namespace Game {
+
+	enum class MonsterEventType {
+		// A player projectile overlaps the monster (damage, kill, pickup and number spawns are resolved when applied)
+		ProjectileHit = 0,
+		// The monster touches the player
+		PlayerContact = 1,
+		// The monster is too far away from the player and needs to be moved back close to the play field
+		Respawn = 2
+	};
+
+	struct MonsterEvent {
+		MonsterEventType type;
+		uint32_t monsterIndex;
+		uint32_t projectileIndex{ 0 };
+	};
+
+	// Monster updates run in parallel on ranges of monsters and must not modify shared game state
+	// Instead they record events into the buffer of their range, which are then applied on a single thread
+	// Buffers are applied in range order and events are recorded in monster order, so the result doesn't depend on thread scheduling
+	struct MonsterEventBuffer {
+		std::vector<MonsterEvent> events{};
+
+		void add(MonsterEventType type, uint32_t monsterIndex, uint32_t projectileIndex = 0)
+		{
+			events.push_back({ .type = type, .monsterIndex = monsterIndex, .projectileIndex = projectileIndex });
+		}
+
+		void clear()
+		{
+			events.clear();
+		}
+	};
+
+}
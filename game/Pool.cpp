@@ -0,0 +1,72 @@
+/*
+* Copyright(C) 2026 by Sascha Willems - www.saschawillems.de
+*
+* This code is licensed under the MIT license(MIT) (http://opensource.org/licenses/MIT)
+*/
+
+#include "Pool.hpp"
+
+Game::PoolHandle Game::PoolSlots::acquire(bool& grown)
+{
+	uint32_t index;
+	if (freeHead != endOfList) {
+		index = freeHead;
+		freeHead = slots[index].nextFree;
+		grown = false;
+	} else {
+		index = static_cast<uint32_t>(slots.size());
+		slots.push_back({});
+		grown = true;
+	}
+	Slot& slot = slots[index];
+	slot.alive = true;
+	slot.nextFree = endOfList;
+	aliveCount++;
+	return { .index = index, .generation = slot.generation };
+}
+
+void Game::PoolSlots::release(uint32_t index)
+{
+	Slot& slot = slots[index];
+	if (!slot.alive) {
+		return;
+	}
+	slot.alive = false;
+	// Invalidates all handles still referring to this slot
+	slot.generation++;
+	slot.nextFree = freeHead;
+	freeHead = index;
+	aliveCount--;
+}
+
+bool Game::PoolSlots::isAlive(uint32_t index) const
+{
+	return (index < slots.size()) && slots[index].alive;
+}
+
+bool Game::PoolSlots::isValid(PoolHandle handle) const
+{
+	return isAlive(handle.index) && (slots[handle.index].generation == handle.generation);
+}
+
+Game::PoolHandle Game::PoolSlots::getHandle(uint32_t index) const
+{
+	return { .index = index, .generation = slots[index].generation };
+}
+
+size_t Game::PoolSlots::capacity() const
+{
+	return slots.size();
+}
+
+size_t Game::PoolSlots::alive() const
+{
+	return aliveCount;
+}
+
+void Game::PoolSlots::clear()
+{
+	slots.clear();
+	freeHead = endOfList;
+	aliveCount = 0;
+}
@@ -0,0 +1,116 @@
+/*
+* Copyright(C) 2026 by Sascha Willems - www.saschawillems.de
+*
+* This code is licensed under the MIT license(MIT) (http://opensource.org/licenses/MIT)
+*/
+
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <stdint.h>
+#include <limits>
+
+namespace Game {
+
+	// Refers to a pool slot, the generation is used to detect if the slot has been reused since the handle was created
+	struct PoolHandle {
+		uint32_t index{ std::numeric_limits<uint32_t>::max() };
+		uint32_t generation{ 0 };
+	};
+
+	// Slot management for pooled containers
+	// Free slots are linked through the slot metadata (intrusive free list), so acquiring and releasing a slot is O(1)
+	// Slot indices are stable, a slot is only ever reused after it has been released
+	// This is separate from the actual storage, so it can also be used for structure-of-array containers
+	class PoolSlots {
+	private:
+		static constexpr uint32_t endOfList = std::numeric_limits<uint32_t>::max();
+		struct Slot {
+			uint32_t generation{ 0 };
+			uint32_t nextFree{ endOfList };
+			bool alive{ false };
+		};
+		std::vector<Slot> slots{};
+		uint32_t freeHead{ endOfList };
+		uint32_t aliveCount{ 0 };
+	public:
+		// Returns a free slot, appends a new one if no free slot is left (grown is set to true in that case)
+		PoolHandle acquire(bool& grown);
+		// Returns the slot to the free list, releasing a slot that's not alive is ignored
+		void release(uint32_t index);
+		bool isAlive(uint32_t index) const;
+		bool isValid(PoolHandle handle) const;
+		PoolHandle getHandle(uint32_t index) const;
+		// Number of slots (alive and free)
+		size_t capacity() const;
+		size_t alive() const;
+		void clear();
+	};
+
+	// Pooled container with stable indices
+	// Storage is a plain vector, so items can be iterated linearly (including released ones, which callers need to skip)
+	template<typename T>
+	class Pool {
+	private:
+		PoolSlots slots{};
+		std::vector<T> items{};
+	public:
+		PoolHandle add(const T& item)
+		{
+			bool grown{ false };
+			PoolHandle handle = slots.acquire(grown);
+			if (grown) {
+				items.push_back(item);
+			} else {
+				items[handle.index] = item;
+			}
+			return handle;
+		}
+
+		void release(uint32_t index)
+		{
+			slots.release(index);
+		}
+
+		bool isAlive(uint32_t index) const
+		{
+			return slots.isAlive(index);
+		}
+
+		bool isValid(PoolHandle handle) const
+		{
+			return slots.isValid(handle);
+		}
+
+		PoolHandle getHandle(uint32_t index) const
+		{
+			return slots.getHandle(index);
+		}
+
+		size_t size() const
+		{
+			return items.size();
+		}
+
+		size_t alive() const
+		{
+			return slots.alive();
+		}
+
+		void clear()
+		{
+			slots.clear();
+			items.clear();
+		}
+
+		T& operator[](size_t index) { return items[index]; }
+		const T& operator[](size_t index) const { return items[index]; }
+
+		typename std::vector<T>::iterator begin() { return items.begin(); }
+		typename std::vector<T>::iterator end() { return items.end(); }
+		typename std::vector<T>::const_iterator begin() const { return items.begin(); }
+		typename std::vector<T>::const_iterator end() const { return items.end(); }
+	};
+
+}
@@ -0,0 +1,135 @@
+/*
+* Copyright(C) 2026 by Sascha Willems - www.saschawillems.de
+*
+* This code is licensed under the MIT license(MIT) (http://opensource.org/licenses/MIT)
+*/
+
+#include <fstream>
+#include <cstring>
+#include "Replay.hpp"
+
+namespace Game {
+
+	// Version 2 added the map size and the water spread interval after the version 1 header
+	struct ReplayFileHeader {
+		char magic[4]{ 'V', 'T', 'R', 'P' };
+		uint32_t version{ 2 };
+		uint32_t seed{ 0 };
+		uint32_t initialMonsterCount{ 0 };
+		float tickDuration{ 0.0f };
+		uint32_t reserved{ 0 };
+		uint64_t tickCount{ 0 };
+		uint32_t mapWidth{ 0 };
+		uint32_t mapHeight{ 0 };
+		uint32_t waterSpreadInterval{ 0 };
+		uint32_t reserved2{ 0 };
+	};
+	static_assert(sizeof(ReplayFileHeader) == 48);
+	constexpr size_t replayFileHeaderSizeV1 = 32;
+
+	enum ReplayInputBits : uint8_t {
+		MoveLeft = 1 << 0,
+		MoveRight = 1 << 1,
+		MoveUp = 1 << 2,
+		MoveDown = 1 << 3,
+		Sprint = 1 << 4,
+		Push = 1 << 5
+	};
+
+	void Replay::record(const InputState& input)
+	{
+		uint8_t bits{ 0 };
+		bits |= input.moveLeft ? MoveLeft : 0;
+		bits |= input.moveRight ? MoveRight : 0;
+		bits |= input.moveUp ? MoveUp : 0;
+		bits |= input.moveDown ? MoveDown : 0;
+		bits |= input.sprint ? Sprint : 0;
+		bits |= input.push ? Push : 0;
+		inputs.push_back(bits);
+	}
+
+	InputState Replay::getInput(uint64_t tick) const
+	{
+		// No input once the recording has ended
+		if (tick >= inputs.size()) {
+			return InputState{};
+		}
+		const uint8_t bits = inputs[tick];
+		return InputState{
+			.moveLeft = (bits & MoveLeft) != 0,
+			.moveRight = (bits & MoveRight) != 0,
+			.moveUp = (bits & MoveUp) != 0,
+			.moveDown = (bits & MoveDown) != 0,
+			.sprint = (bits & Sprint) != 0,
+			.push = (bits & Push) != 0
+		};
+	}
+
+	uint64_t Replay::getTickCount() const
+	{
+		return inputs.size();
+	}
+
+	void Replay::clear()
+	{
+		inputs.clear();
+	}
+
+	bool Replay::saveToFile(const std::string& fileName) const
+	{
+		std::ofstream stream(fileName, std::ios::binary);
+		if (!stream.good()) {
+			return false;
+		}
+		ReplayFileHeader header{};
+		header.seed = seed;
+		header.initialMonsterCount = initialMonsterCount;
+		header.tickDuration = tickDuration;
+		header.tickCount = inputs.size();
+		header.mapWidth = mapWidth;
+		header.mapHeight = mapHeight;
+		header.waterSpreadInterval = waterSpreadInterval;
+		stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		stream.write(reinterpret_cast<const char*>(inputs.data()), inputs.size());
+		return stream.good();
+	}
+
+	bool Replay::loadFromFile(const std::string& fileName)
+	{
+		std::ifstream stream(fileName, std::ios::binary);
+		if (!stream.good()) {
+			return false;
+		}
+		ReplayFileHeader header{};
+		const ReplayFileHeader expected{};
+		stream.read(reinterpret_cast<char*>(&header), replayFileHeaderSizeV1);
+		if (!stream.good() || (memcmp(header.magic, expected.magic, sizeof(header.magic)) != 0) || (header.version < 1) || (header.version > expected.version)) {
+			return false;
+		}
+		if (header.version >= 2) {
+			stream.read(reinterpret_cast<char*>(&header) + replayFileHeaderSizeV1, sizeof(header) - replayFileHeaderSizeV1);
+			if (!stream.good() || (header.mapWidth == 0) || (header.mapHeight == 0)) {
+				return false;
+			}
+		} else {
+			// Version 1 replays were recorded before the map size could be changed
+			header.mapWidth = TILEMAP_DEFAULT_DIM;
+			header.mapHeight = TILEMAP_DEFAULT_DIM;
+			header.waterSpreadInterval = TILEMAP_DEFAULT_WATER_SPREAD_INTERVAL;
+		}
+		inputs.resize(header.tickCount);
+		stream.read(reinterpret_cast<char*>(inputs.data()), header.tickCount);
+		if (static_cast<uint64_t>(stream.gcount()) != header.tickCount) {
+			inputs.clear();
+			return false;
+		}
+		seed = header.seed;
+		initialMonsterCount = header.initialMonsterCount;
+		tickDuration = header.tickDuration;
+		mapWidth = header.mapWidth;
+		mapHeight = header.mapHeight;
+		waterSpreadInterval = header.waterSpreadInterval;
+		return true;
+	}
+
+}
@@ -0,0 +1,41 @@
+/*
+* Copyright(C) 2026 by Sascha Willems - www.saschawillems.de
+*
+* This code is licensed under the MIT license(MIT) (http://opensource.org/licenses/MIT)
+*/
+
+#pragma once
+
+#include <vector>
+#include <string>
+#include <stdint.h>
+#include "Input.hpp"
+#include "Tilemap.hpp"
+
+namespace Game {
+
+	// Input recording for a simulation run
+	// Together with the seed and the run setup stored alongside, the per-tick input state is enough to reproduce a run exactly
+	// Input is stored as one byte per tick with one bit per input
+	class Replay {
+	private:
+		std::vector<uint8_t> inputs{};
+	public:
+		uint32_t seed{ 0 };
+		uint32_t initialMonsterCount{ 0 };
+		float tickDuration{ 0.0f };
+		// Settings that change the simulation, replays recorded before these were stored use the defaults
+		uint32_t mapWidth{ TILEMAP_DEFAULT_DIM };
+		uint32_t mapHeight{ TILEMAP_DEFAULT_DIM };
+		uint32_t waterSpreadInterval{ TILEMAP_DEFAULT_WATER_SPREAD_INTERVAL };
+
+		void record(const InputState& input);
+		InputState getInput(uint64_t tick) const;
+		uint64_t getTickCount() const;
+		void clear();
+
+		bool saveToFile(const std::string& fileName) const;
+		bool loadFromFile(const std::string& fileName);
+	};
+
+}
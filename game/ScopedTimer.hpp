@@ -0,0 +1,31 @@
+/*
+* Copyright(C) 2026 by Sascha Willems - www.saschawillems.de
+*
+* This code is licensed under the MIT license(MIT) (http://opensource.org/licenses/MIT)
+*/
+
+#pragma once
+
+#include <chrono>
+
+namespace Game {
+
+	// Stores the time spent in the current scope (in milliseconds) into the target once the scope is left
+	// Used next to profiler zones, so timings are also available without a profiler attached (e.g. for headless runs)
+	class ScopedTimer {
+	private:
+		std::chrono::high_resolution_clock::time_point start;
+		double& target;
+	public:
+		ScopedTimer(double& target) : target(target)
+		{
+			start = std::chrono::high_resolution_clock::now();
+		}
+
+		~ScopedTimer()
+		{
+			target = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+		}
+	};
+
+}
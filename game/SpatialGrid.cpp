@@ -0,0 +1,65 @@
+/*
+* Copyright(C) 2026 by Sascha Willems - www.saschawillems.de
+*
+* This code is licensed under the MIT license(MIT) (http://opensource.org/licenses/MIT)
+*/
+
+#include "SpatialGrid.hpp"
+
+uint32_t Game::SpatialGrid::hashCell(int32_t x, int32_t y) const
+{
+	// Large primes, see "Optimized Spatial Hashing for Collision Detection of Deformable Objects" (Teschner et al.)
+	return ((static_cast<uint32_t>(x) * 73856093u) ^ (static_cast<uint32_t>(y) * 19349663u)) & tableMask;
+}
+
+void Game::SpatialGrid::setCellSize(float size)
+{
+	cellSize = size;
+	invCellSize = 1.0f / size;
+}
+
+float Game::SpatialGrid::getCellSize() const
+{
+	return cellSize;
+}
+
+void Game::SpatialGrid::clear()
+{
+	pending.clear();
+	sortedIndices.clear();
+}
+
+void Game::SpatialGrid::insert(uint32_t index, glm::vec2 position)
+{
+	// Cells are hashed in build() once the final table size is known
+	pending.push_back({ .cell = glm::ivec2(glm::floor(position * invCellSize)), .index = index });
+}
+
+void Game::SpatialGrid::build()
+{
+	// Table size is the next power of two of twice the entry count to keep collisions low
+	uint32_t tableSize = 64;
+	while (tableSize < pending.size() * 2) {
+		tableSize <<= 1;
+	}
+	tableMask = tableSize - 1;
+
+	// Counting sort by hashed cell
+	cellStart.assign(tableSize + 1, 0);
+	for (auto& entry : pending) {
+		cellStart[hashCell(entry.cell.x, entry.cell.y) + 1]++;
+	}
+	for (uint32_t i = 0; i < tableSize; i++) {
+		cellStart[i + 1] += cellStart[i];
+	}
+	cellOffsets.assign(cellStart.begin(), cellStart.end() - 1);
+	sortedIndices.resize(pending.size());
+	for (auto& entry : pending) {
+		sortedIndices[cellOffsets[hashCell(entry.cell.x, entry.cell.y)]++] = entry.index;
+	}
+}
+
+size_t Game::SpatialGrid::size() const
+{
+	return pending.size();
+}
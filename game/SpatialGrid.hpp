@@ -0,0 +1,67 @@
+/*
+* Copyright(C) 2026 by Sascha Willems - www.saschawillems.de
+*
+* This code is licensed under the MIT license(MIT) (http://opensource.org/licenses/MIT)
+*/
+
+#pragma once
+
+#include <vector>
+#include <stdint.h>
+#include <cmath>
+#include "glm/glm.hpp"
+
+namespace Game {
+
+	// Uniform grid for fast proximity queries (e.g. collision checks) between large numbers of entities
+	// Cells are hashed into a fixed size table, so the grid is unbounded and doesn't depend on the play field size
+	// The grid is meant to be rebuilt every frame: clear, insert all entities and then call build
+	class SpatialGrid {
+	private:
+		struct Entry {
+			glm::ivec2 cell;
+			uint32_t index;
+		};
+		float cellSize{ 1.0f };
+		float invCellSize{ 1.0f };
+		uint32_t tableMask{ 0 };
+		std::vector<Entry> pending{};
+		// Start offset of each hashed cell into the sorted index list (size = table size + 1)
+		std::vector<uint32_t> cellStart{};
+		std::vector<uint32_t> cellOffsets{};
+		std::vector<uint32_t> sortedIndices{};
+		uint32_t hashCell(int32_t x, int32_t y) const;
+	public:
+		// Cell size should be at least as large as the biggest query radius, so a query only touches neighbouring cells
+		void setCellSize(float size);
+		float getCellSize() const;
+		void clear();
+		void insert(uint32_t index, glm::vec2 position);
+		// Sorts all inserted entries by cell (counting sort, O(n))
+		void build();
+		size_t size() const;
+
+		// Calls fn(index) for all entries in cells overlapping the given circle
+		// Callers still need to do an exact distance check, and due to hash collisions an index may be reported more than once
+		template<typename F>
+		void query(glm::vec2 position, float radius, F&& fn) const
+		{
+			if (sortedIndices.empty()) {
+				return;
+			}
+			const int32_t sx = static_cast<int32_t>(floor((position.x - radius) * invCellSize));
+			const int32_t ex = static_cast<int32_t>(floor((position.x + radius) * invCellSize));
+			const int32_t sy = static_cast<int32_t>(floor((position.y - radius) * invCellSize));
+			const int32_t ey = static_cast<int32_t>(floor((position.y + radius) * invCellSize));
+			for (int32_t y = sy; y <= ey; y++) {
+				for (int32_t x = sx; x <= ex; x++) {
+					const uint32_t cell = hashCell(x, y);
+					for (uint32_t i = cellStart[cell]; i < cellStart[cell + 1]; i++) {
+						fn(sortedIndices[i]);
+					}
+				}
+			}
+		}
+	};
+
+}
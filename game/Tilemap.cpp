@@ -5,24 +5,270 @@
  */
 
 #include "Tilemap.hpp"
+#include <algorithm>
 
 Game::Tilemap::~Tilemap()
 {
-	//if (data) {
-	//	delete[] data;
-	//}
+}
+
+// Walls and water springs are placed per cell of this many tiles
+constexpr int32_t featureCellDim = 16;
+// Max. distance (in tiles) water spreads from a spring
+constexpr int32_t springRadius = 3;
+// Local position of the spring in cells that have one, far enough from the walls that water never reaches them
+const glm::ivec2 springPos{ 12, 3 };
+
+uint64_t Game::Tilemap::chunkKey(glm::ivec2 position)
+{
+	return (static_cast<uint64_t>(static_cast<uint32_t>(position.x)) << 32) | static_cast<uint32_t>(position.y);
+}
+
+Game::TilemapChunk& Game::Tilemap::loadChunk(glm::ivec2 position)
+{
+	const uint64_t key = chunkKey(position);
+	auto it = chunkLookup.find(key);
+	if (it != chunkLookup.end()) {
+		// Mark as most recently used
+		chunks.splice(chunks.begin(), chunks, it->second);
+		return *it->second;
+	}
+	auto modified = modifiedChunks.find(key);
+	if (modified != modifiedChunks.end()) {
+		chunks.push_front(std::move(modified->second));
+		modifiedChunks.erase(modified);
+	} else {
+		chunks.emplace_front();
+		TilemapChunk& chunk = chunks.front();
+		chunk.position = position;
+		if (chunkGenerator) {
+			chunkGenerator(chunk);
+		} else {
+			generateChunk(chunk);
+		}
+	}
+	chunkLookup[key] = chunks.begin();
+	return chunks.front();
+}
+
+void Game::Tilemap::evictChunks(uint32_t keepCount)
+{
+	while (chunks.size() > keepCount) {
+		const uint64_t key = chunkKey(chunks.back().position);
+		chunkLookup.erase(key);
+		if (chunks.back().modified) {
+			modifiedChunks[key] = std::move(chunks.back());
+		}
+		chunks.pop_back();
+	}
+}
+
+void Game::Tilemap::clear()
+{
+	chunks.clear();
+	chunkLookup.clear();
+	modifiedChunks.clear();
+	dirtyChunks.clear();
+	revision++;
+}
+
+uint32_t Game::Tilemap::hash(int32_t x, int32_t y) const
+{
+	// Hashed instead of drawn from a random engine, so a chunk always gets the same tiles no matter when (or how often) it's generated
+	uint32_t value = seed ^ (static_cast<uint32_t>(x) * 73856093u) ^ (static_cast<uint32_t>(y) * 19349663u);
+	value ^= value >> 16;
+	value *= 0x7feb352du;
+	value ^= value >> 15;
+	value *= 0x846ca68bu;
+	value ^= value >> 16;
+	return value;
 }
 
 void Game::Tilemap::setSize(uint32_t width, uint32_t height)
 {
-	//if (data) {
-	//	delete[] data;
-	//}
-	//data = new uint32_t[width * height];
-	//this->width = width;
-	//this->height = height;
+	this->width = width;
+	this->height = height;
+	clear();
+}
+
+void Game::Tilemap::setSeed(uint32_t seed)
+{
+	if (this->seed != seed) {
+		this->seed = seed;
+		clear();
+	}
 }
 
 glm::ivec2 Game::Tilemap::tilePosFromVisualPos(glm::vec2 visualPos) const {
 	return glm::ivec2{ (int)(floor(visualPos.x * screenFactor.x )), (int)(floor(visualPos.y * screenFactor.y )) };
 }
+
+glm::ivec2 Game::Tilemap::tilePosFromWorldPos(glm::vec2 worldPos)
+{
+	return glm::ivec2(glm::floor((worldPos + 1.0f) / 2.0f));
+}
+
+bool Game::Tilemap::contains(int32_t x, int32_t y) const
+{
+	return (x >= 0) && (y >= 0) && (static_cast<uint32_t>(x) < width) && (static_cast<uint32_t>(y) < height);
+}
+
+void Game::Tilemap::streamAround(glm::ivec2 tilePos, int32_t radius)
+{
+	const glm::ivec2 center = glm::ivec2(glm::floor(glm::vec2(tilePos) / static_cast<float>(TILEMAP_CHUNK_DIM)));
+	const glm::ivec2 chunkCount = glm::ivec2((width + TILEMAP_CHUNK_DIM - 1) / TILEMAP_CHUNK_DIM, (height + TILEMAP_CHUNK_DIM - 1) / TILEMAP_CHUNK_DIM);
+	uint32_t requiredCount{ 0 };
+	for (int32_t y = center.y - radius; y <= center.y + radius; y++) {
+		for (int32_t x = center.x - radius; x <= center.x + radius; x++) {
+			if ((x < 0) || (y < 0) || (x >= chunkCount.x) || (y >= chunkCount.y)) {
+				continue;
+			}
+			loadChunk({ x, y });
+			requiredCount++;
+		}
+	}
+	// The required chunks are the most recently used ones, so they're never evicted
+	evictChunks(std::max(maxResidentChunks, requiredCount));
+}
+
+const Game::TilemapChunk* Game::Tilemap::findChunk(glm::ivec2 position) const
+{
+	auto it = chunkLookup.find(chunkKey(position));
+	return (it != chunkLookup.end()) ? &*it->second : nullptr;
+}
+
+uint16_t Game::Tilemap::getTile(int32_t x, int32_t y, TilemapLayer layer)
+{
+	if (!contains(x, y)) {
+		return Tiles::Empty;
+	}
+	const uint16_t tile = loadChunk({ x / static_cast<int32_t>(TILEMAP_CHUNK_DIM), y / static_cast<int32_t>(TILEMAP_CHUNK_DIM) }).getTile(x % TILEMAP_CHUNK_DIM, y % TILEMAP_CHUNK_DIM, layer);
+	evictChunks(std::max(maxResidentChunks, 1u));
+	return tile;
+}
+
+void Game::Tilemap::setTile(int32_t x, int32_t y, TilemapLayer layer, uint16_t tile)
+{
+	if (!contains(x, y)) {
+		return;
+	}
+	TilemapChunk& chunk = loadChunk({ x / static_cast<int32_t>(TILEMAP_CHUNK_DIM), y / static_cast<int32_t>(TILEMAP_CHUNK_DIM) });
+	const uint32_t localX = x % TILEMAP_CHUNK_DIM;
+	const uint32_t localY = y % TILEMAP_CHUNK_DIM;
+	uint16_t& current = chunk.tiles[static_cast<uint32_t>(layer)][localY * TILEMAP_CHUNK_DIM + localX];
+	if (current != tile) {
+		current = tile;
+		chunk.modified = true;
+		bool dirty{ false };
+		for (auto& rect : chunk.dirty) {
+			dirty |= !rect.empty();
+		}
+		if (!dirty) {
+			dirtyChunks.push_back(chunk.position);
+		}
+		chunk.dirty[static_cast<uint32_t>(layer)].add(localX, localY);
+	}
+	evictChunks(std::max(maxResidentChunks, 1u));
+}
+
+const std::vector<glm::ivec2>& Game::Tilemap::getDirtyChunks() const
+{
+	return dirtyChunks;
+}
+
+void Game::Tilemap::clearDirtyRegions()
+{
+	for (auto& position : dirtyChunks) {
+		const uint64_t key = chunkKey(position);
+		TilemapChunk* chunk{ nullptr };
+		if (auto it = chunkLookup.find(key); it != chunkLookup.end()) {
+			chunk = &*it->second;
+		} else if (auto modified = modifiedChunks.find(key); modified != modifiedChunks.end()) {
+			chunk = &modified->second;
+		}
+		if (chunk) {
+			for (auto& rect : chunk->dirty) {
+				rect = {};
+			}
+		}
+	}
+	dirtyChunks.clear();
+}
+
+std::vector<const Game::TilemapChunk*> Game::Tilemap::getModifiedChunks() const
+{
+	std::vector<const TilemapChunk*> modified{};
+	for (const auto& chunk : chunks) {
+		if (chunk.modified) {
+			modified.push_back(&chunk);
+		}
+	}
+	for (const auto& [key, chunk] : modifiedChunks) {
+		modified.push_back(&chunk);
+	}
+	// Sorted, so the order doesn't depend on when the chunks were used or evicted
+	std::sort(modified.begin(), modified.end(), [](const TilemapChunk* a, const TilemapChunk* b) { return chunkKey(a->position) < chunkKey(b->position); });
+	return modified;
+}
+
+uint32_t Game::Tilemap::getResidentChunkCount() const
+{
+	return static_cast<uint32_t>(chunks.size());
+}
+
+uint32_t Game::Tilemap::getRevision() const
+{
+	return revision;
+}
+
+void Game::Tilemap::generateChunk(TilemapChunk& chunk) const
+{
+	for (uint32_t y = 0; y < TILEMAP_CHUNK_DIM; y++) {
+		for (uint32_t x = 0; x < TILEMAP_CHUNK_DIM; x++) {
+			const int32_t tx = chunk.position.x * TILEMAP_CHUNK_DIM + x;
+			const int32_t ty = chunk.position.y * TILEMAP_CHUNK_DIM + y;
+			const uint32_t index = y * TILEMAP_CHUNK_DIM + x;
+			uint16_t ground{ Tiles::Empty };
+			uint16_t decoration{ Tiles::Empty };
+			if (!contains(tx, ty)) {
+				ground = Tiles::Empty;
+			} else if ((tx == 0) || (ty == 0) || (static_cast<uint32_t>(tx) == width - 1) || (static_cast<uint32_t>(ty) == height - 1)) {
+				// Border
+				ground = Tiles::Water;
+			} else {
+				ground = static_cast<uint16_t>(hash(tx, ty) % 3);
+				const glm::ivec2 cell = glm::ivec2(tx, ty) / featureCellDim;
+				const glm::ivec2 local = glm::ivec2(tx, ty) % featureCellDim;
+				// Cells are hashed with negative coordinates, so they don't share values with tiles
+				const uint32_t cellHash = hash(-1 - cell.x, -1 - cell.y);
+				if ((cellHash % 4 == 0) && (local == springPos)) {
+					ground = Tiles::Water;
+				}
+				// Two thirds of the cells have a short horizontal or vertical wall through their center
+				if ((cellHash >> 4) % 3 != 0) {
+					const bool horizontal = (cellHash >> 2) & 1;
+					const glm::ivec2 along = horizontal ? local : glm::ivec2(local.y, local.x);
+					if ((along.y == featureCellDim / 2) && (along.x >= 4) && (along.x < featureCellDim - 4)) {
+						decoration = Tiles::Wall;
+					}
+				}
+			}
+			chunk.tiles[static_cast<uint32_t>(TilemapLayer::Ground)][index] = ground;
+			chunk.tiles[static_cast<uint32_t>(TilemapLayer::Decoration)][index] = decoration;
+			chunk.tiles[static_cast<uint32_t>(TilemapLayer::Overlay)][index] = Tiles::Empty;
+		}
+	}
+}
+
+bool Game::Tilemap::canFlood(int32_t x, int32_t y) const
+{
+	if ((x <= 0) || (y <= 0) || (x >= static_cast<int32_t>(width) - 1) || (y >= static_cast<int32_t>(height) - 1)) {
+		return false;
+	}
+	const glm::ivec2 cell = glm::ivec2(x, y) / featureCellDim;
+	const glm::ivec2 local = glm::ivec2(x, y) % featureCellDim;
+	if (hash(-1 - cell.x, -1 - cell.y) % 4 != 0) {
+		return false;
+	}
+	const glm::ivec2 distance = glm::abs(local - springPos);
+	return distance.x + distance.y <= springRadius;
+}
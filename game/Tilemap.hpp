@@ -7,31 +7,142 @@
 #pragma once
 
 #include <stdint.h>
-#include "Texture.hpp"
-#include "Sampler.hpp"
-#include "DescriptorSet.hpp"
+#include <list>
+#include <unordered_map>
+#include <vector>
+#include <functional>
 #include <glm/glm.hpp>
 
-constexpr uint32_t TILEMAP_MAX_DIM = 64; // @todo: 2k or 4k
+// Rendering resources are only referenced here, so the game doesn't depend on Vulkan
+namespace vks {
+	class Texture2D;
+}
+class Sampler;
+class DescriptorSet;
+
+// Size of a chunk in tiles (in each dimension)
+constexpr uint32_t TILEMAP_CHUNK_DIM = 32;
+constexpr uint32_t TILEMAP_DEFAULT_DIM = 64;
+// Water spreads by one tile around the player every this many simulation ticks
+constexpr uint32_t TILEMAP_DEFAULT_WATER_SPREAD_INTERVAL = 45;
+constexpr uint32_t TILEMAP_LAYER_COUNT = 3;
 
 namespace Game {
+	// Layers are composited in this order
+	enum class TilemapLayer {
+		Ground = 0,
+		// e.g. walls
+		Decoration = 1,
+		// e.g. cracks in damaged walls
+		Overlay = 2
+	};
+
+	// Tile ids index the images of the tile set (in the order they're loaded), all layers use the same set
+	namespace Tiles {
+		constexpr uint16_t Floor0 = 0;
+		constexpr uint16_t Floor1 = 1;
+		constexpr uint16_t Floor2 = 2;
+		constexpr uint16_t Water = 3;
+		constexpr uint16_t Wall = 4;
+		constexpr uint16_t Crack = 5;
+		// Nothing is drawn for empty tiles, the ground is only empty outside of the map
+		constexpr uint16_t Empty = 0xFFFF;
+	}
+
+	// Local tile coordinates (inclusive), empty if min > max
+	struct TilemapRect {
+		glm::ivec2 min{ static_cast<int32_t>(TILEMAP_CHUNK_DIM) };
+		glm::ivec2 max{ -1 };
+		bool empty() const
+		{
+			return (min.x > max.x) || (min.y > max.y);
+		}
+		void add(uint32_t x, uint32_t y)
+		{
+			min = glm::min(min, glm::ivec2(x, y));
+			max = glm::max(max, glm::ivec2(x, y));
+		}
+	};
+
+	// Square block of tiles, the unit in which the tile map is generated, kept in memory and evicted
+	struct TilemapChunk {
+		// In chunks
+		glm::ivec2 position{ 0 };
+		uint16_t tiles[TILEMAP_LAYER_COUNT][TILEMAP_CHUNK_DIM * TILEMAP_CHUNK_DIM]{};
+		// Tiles of each layer changed by setTile since the dirty regions were last cleared
+		TilemapRect dirty[TILEMAP_LAYER_COUNT]{};
+		// Modified chunks can't be generated again without losing their changes, so they're set aside instead of being discarded when evicted
+		bool modified{ false };
+		// Local tile coordinates
+		uint16_t getTile(uint32_t x, uint32_t y, TilemapLayer layer = TilemapLayer::Ground) const
+		{
+			return tiles[static_cast<uint32_t>(layer)][y * TILEMAP_CHUNK_DIM + x];
+		}
+	};
+
+	// Tile map of (nearly) arbitrary size that's only kept in memory around the player
+	// Chunks are created on demand by the chunk generator, and the least recently used ones are evicted once more than maxResidentChunks are resident
+	// Generation needs to be deterministic, as evicted chunks are generated again when they're needed later on
 	class Tilemap
 	{
+	private:
+		// Most recently used first
+		std::list<TilemapChunk> chunks{};
+		std::unordered_map<uint64_t, std::list<TilemapChunk>::iterator> chunkLookup{};
+		// Evicted chunks that have been modified
+		std::unordered_map<uint64_t, TilemapChunk> modifiedChunks{};
+		std::vector<glm::ivec2> dirtyChunks{};
+		uint32_t seed{ 0 };
+		uint32_t revision{ 0 };
+		TilemapChunk& loadChunk(glm::ivec2 position);
+		void evictChunks(uint32_t keepCount);
+		void clear();
+		uint32_t hash(int32_t x, int32_t y) const;
 	public:
-		// @todo: multiple layers? (background/foreground)
-		uint32_t data[TILEMAP_MAX_DIM][TILEMAP_MAX_DIM];
 		vks::Texture2D* texture{ nullptr };
 		Sampler* sampler{ nullptr };
 		DescriptorSet* descriptorSetSampler{ nullptr };
 		uint32_t imageIndex;
 		uint32_t firstTileIndex;
 		uint32_t lastTileIndex;
-		uint32_t width{ TILEMAP_MAX_DIM };
-		uint32_t height{ TILEMAP_MAX_DIM };
+		// In tiles
+		uint32_t width{ TILEMAP_DEFAULT_DIM };
+		uint32_t height{ TILEMAP_DEFAULT_DIM };
+		// Upper bound for the no. of chunks kept in memory (unless more are needed at once), modified chunks that have been evicted don't count towards this
+		uint32_t maxResidentChunks{ 64 };
+		// Fills the tiles of a chunk when it's first needed, defaults to generateChunk
+		std::function<void(TilemapChunk& chunk)> chunkGenerator{};
 		// Used to calculate actual tile index from visual screen position
 		glm::vec2 screenFactor{ 0.0f };
 		~Tilemap();
+		static uint64_t chunkKey(glm::ivec2 position);
+		// Discards all resident chunks
 		void setSize(uint32_t width, uint32_t height);
+		void setSeed(uint32_t seed);
 		glm::ivec2 tilePosFromVisualPos(glm::vec2 visualPos) const;
+		// Tiles are drawn two units wide and centered at even positions
+		static glm::ivec2 tilePosFromWorldPos(glm::vec2 worldPos);
+		bool contains(int32_t x, int32_t y) const;
+		// Makes all chunks within radius chunks of the given tile resident, then evicts the least recently used chunks beyond the budget
+		void streamAround(glm::ivec2 tilePos, int32_t radius = 1);
+		// Returns nullptr if the chunk isn't resident, never loads it
+		const TilemapChunk* findChunk(glm::ivec2 position) const;
+		// Loads the tile's chunk if required, tiles outside the map are empty
+		uint16_t getTile(int32_t x, int32_t y, TilemapLayer layer = TilemapLayer::Ground);
+		// Loads the tile's chunk if required and adds the tile to the chunk's dirty region, tiles outside the map can't be changed
+		void setTile(int32_t x, int32_t y, TilemapLayer layer, uint16_t tile);
+		// Chunks with dirty regions, these may have been evicted since they were changed
+		const std::vector<glm::ivec2>& getDirtyChunks() const;
+		// To be called once all users of the tile data (e.g. GPU copies) have been updated for the dirty regions
+		void clearDirtyRegions();
+		// Resident and evicted chunks changed by setTile, ordered by their position
+		std::vector<const TilemapChunk*> getModifiedChunks() const;
+		uint32_t getResidentChunkCount() const;
+		// Changes whenever the whole map changes (size or seed), so data derived from its tiles (e.g. cached instances) can be discarded
+		uint32_t getRevision() const;
+		// Default generator: random floor tiles with a few water springs, a border of water around the map and short walls
+		void generateChunk(TilemapChunk& chunk) const;
+		// Water only spreads onto floor tiles close to the springs placed by generateChunk, so it never floods the whole map
+		bool canFlood(int32_t x, int32_t y) const;
 	};
-}
\ No newline at end of file
+}
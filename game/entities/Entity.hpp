@@ -31,6 +31,8 @@ namespace Game {
 		class Entity {
 		public:
 			glm::vec2 position{};
+			// Position at the start of the current simulation tick, used to interpolate between ticks for rendering
+			glm::vec2 previousPosition{};
 			glm::vec2 direction{};
 			glm::vec2 velocity{};
 			float timer{ 0.0f };
@@ -14,6 +14,7 @@ namespace Game {
 	namespace Entities {
 		class Monster : public Entity {
 		public:
+			// Used as a template for adding monsters to the MonsterStore
 			bool isBoss{ false };
 			std::vector<Weapon> weapons;
 			virtual void update(float delta) override;
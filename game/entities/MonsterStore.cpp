@@ -0,0 +1,120 @@
+/*
+* Copyright(C) 2026 by Sascha Willems - www.saschawillems.de
+*
+* This code is licensed under the MIT license(MIT) (http://opensource.org/licenses/MIT)
+*/
+
+#include "MonsterStore.hpp"
+
+uint32_t Game::Entities::MonsterStore::add(const Monster& monster)
+{
+	bool grown{ false };
+	const uint32_t index = slots.acquire(grown).index;
+	if (!grown) {
+		set(index, monster);
+		return index;
+	}
+	position.push_back({});
+	previousPosition.push_back({});
+	velocity.push_back({});
+	direction.push_back({});
+	health.push_back({});
+	speed.push_back({});
+	scale.push_back({});
+	imageIndex.push_back({});
+	state.push_back({});
+	effect.push_back({});
+	effectTimer.push_back({});
+	visible.push_back({});
+	set(index, monster);
+	return index;
+}
+
+void Game::Entities::MonsterStore::set(uint32_t index, const Monster& monster)
+{
+	position[index] = monster.position;
+	previousPosition[index] = monster.position;
+	velocity[index] = monster.velocity;
+	direction[index] = monster.direction;
+	health[index] = monster.health;
+	speed[index] = monster.speed;
+	scale[index] = monster.scale;
+	imageIndex[index] = monster.imageIndex;
+	state[index] = monster.state;
+	effect[index] = monster.effect;
+	effectTimer[index] = monster.effectTimer;
+	visible[index] = false;
+
+	// Side tables may still contain data from a previous monster at this index
+	weapons.erase(index);
+	bosses.erase(index);
+	if (!monster.weapons.empty()) {
+		weapons[index] = monster.weapons;
+	}
+	if (monster.isBoss) {
+		bosses[index] = BossData{};
+	}
+}
+
+void Game::Entities::MonsterStore::release(uint32_t index)
+{
+	state[index] = State::Dead;
+	visible[index] = false;
+	weapons.erase(index);
+	bosses.erase(index);
+	slots.release(index);
+}
+
+size_t Game::Entities::MonsterStore::size() const
+{
+	return position.size();
+}
+
+size_t Game::Entities::MonsterStore::alive() const
+{
+	return slots.alive();
+}
+
+void Game::Entities::MonsterStore::clear()
+{
+	position.clear();
+	previousPosition.clear();
+	velocity.clear();
+	direction.clear();
+	health.clear();
+	speed.clear();
+	scale.clear();
+	imageIndex.clear();
+	state.clear();
+	effect.clear();
+	effectTimer.clear();
+	visible.clear();
+	slots.clear();
+	weapons.clear();
+	bosses.clear();
+}
+
+bool Game::Entities::MonsterStore::isBoss(uint32_t index) const
+{
+	return bosses.find(index) != bosses.end();
+}
+
+void Game::Entities::MonsterStore::setEffect(uint32_t index, Effect effect)
+{
+	// Same logic as Entity::setEffect
+	this->effect[index] = effect;
+	if (effect == Effect::Hit) {
+		effectTimer[index] = 0.25f;
+	}
+}
+
+void Game::Entities::MonsterStore::updateEffect(uint32_t index, float delta)
+{
+	// Same logic as Entity::update
+	if (effectTimer[index] > 0.0f) {
+		effectTimer[index] -= delta;
+		if (effectTimer[index] <= 0.0f) {
+			effect[index] = Effect::None;
+		}
+	}
+}
@@ -0,0 +1,67 @@
+/*
+* Copyright(C) 2026 by Sascha Willems - www.saschawillems.de
+*
+* This code is licensed under the MIT license(MIT) (http://opensource.org/licenses/MIT)
+*/
+
+#pragma once
+
+#include <vector>
+#include <map>
+#include <stdint.h>
+#include "glm/glm.hpp"
+#include "Entity.hpp"
+#include "Monster.hpp"
+#include "Weapon.hpp"
+#include "Pool.hpp"
+
+namespace Game {
+	namespace Entities {
+
+		// Only a small number of monsters are bosses, so their data is stored in a sparse side table
+		struct BossData {
+			float experience{ 100.0f };
+			float pickupScale{ 1.5f };
+		};
+
+		// Structure-of-arrays storage for monsters
+		// Data touched every frame (movement, culling, instance buffer updates) is stored in separate contiguous arrays
+		// Rarely used data (weapons, boss data) is stored in sparse side tables keyed by monster index
+		// Slots of dead monsters are reused through a free list, so indices stay stable for the lifetime of a monster
+		class MonsterStore {
+		private:
+			PoolSlots slots{};
+			void set(uint32_t index, const Monster& monster);
+		public:
+			std::vector<glm::vec2> position{};
+			std::vector<glm::vec2> previousPosition{};
+			std::vector<glm::vec2> velocity{};
+			std::vector<glm::vec2> direction{};
+			std::vector<float> health{};
+			std::vector<float> speed{};
+			std::vector<float> scale{};
+			std::vector<uint32_t> imageIndex{};
+			std::vector<State> state{};
+			std::vector<Effect> effect{};
+			std::vector<float> effectTimer{};
+			// Not using std::vector<bool> as that's not safe to write from multiple threads
+			std::vector<uint8_t> visible{};
+
+			// Ordered maps, so iteration order doesn't depend on hashing
+			std::map<uint32_t, std::vector<Weapon>> weapons{};
+			std::map<uint32_t, BossData> bosses{};
+
+			// Adds a new monster based on the given template and returns its index, reusing a released slot if possible
+			uint32_t add(const Monster& monster);
+			// Marks the monster as dead and returns its slot to the free list
+			void release(uint32_t index);
+			size_t size() const;
+			size_t alive() const;
+			void clear();
+
+			bool isBoss(uint32_t index) const;
+			void setEffect(uint32_t index, Effect effect);
+			void updateEffect(uint32_t index, float delta);
+		};
+	}
+}
@@ -15,8 +15,8 @@ namespace Game {
 		class Player : public Entity {
 		public:
 			std::vector<Weapon> weapons;
-			float experience;
-			uint32_t level;
+			float experience{ 0.0f };
+			uint32_t level{ 0 };
 			float criticalChance{ 5.0f };
 			float criticalDamageMultiplier{ 1.5f };
 			float stamina{ 2.5f };
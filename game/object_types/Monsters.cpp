@@ -8,6 +8,8 @@
 #include <string>
 #include <fstream>
 #include <iostream>
+#include <cstring>
+#include <stdexcept>
 #include "Monsters.hpp"
 #include "json.hpp"
 
@@ -38,5 +40,88 @@ namespace Game {
 			}
 		}
 
+		namespace {
+			template<typename T>
+			void write(std::vector<uint8_t>& buffer, const T& value)
+			{
+				const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+				buffer.insert(buffer.end(), bytes, bytes + sizeof(T));
+			}
+
+			void writeString(std::vector<uint8_t>& buffer, const std::string& value)
+			{
+				write(buffer, static_cast<uint32_t>(value.size()));
+				buffer.insert(buffer.end(), value.begin(), value.end());
+			}
+
+			struct Reader {
+				const uint8_t* data;
+				size_t size;
+				size_t offset{ 0 };
+
+				template<typename T>
+				T read()
+				{
+					if (size - offset < sizeof(T)) {
+						throw std::runtime_error("Monster table is truncated");
+					}
+					T value;
+					memcpy(&value, data + offset, sizeof(T));
+					offset += sizeof(T);
+					return value;
+				}
+
+				std::string readString()
+				{
+					const uint32_t length = read<uint32_t>();
+					if (size - offset < length) {
+						throw std::runtime_error("Monster table is truncated");
+					}
+					std::string value(reinterpret_cast<const char*>(data + offset), length);
+					offset += length;
+					return value;
+				}
+			};
+		}
+
+		std::vector<uint8_t> MonsterTypes::serialize() const
+		{
+			std::vector<uint8_t> buffer;
+			write(buffer, static_cast<uint32_t>(sets.size()));
+			for (auto& set : sets) {
+				writeString(buffer, set.name);
+				write(buffer, static_cast<uint32_t>(set.types.size()));
+				for (auto& type : set.types) {
+					writeString(buffer, type.name);
+					writeString(buffer, type.image);
+					write(buffer, type.size);
+					write(buffer, type.health);
+					write(buffer, type.speed);
+				}
+			}
+			return buffer;
+		}
+
+		void MonsterTypes::loadFromMemory(const void* data, size_t size)
+		{
+			Reader reader{ .data = static_cast<const uint8_t*>(data), .size = size };
+			const uint32_t setCount = reader.read<uint32_t>();
+			for (uint32_t i = 0; i < setCount; i++) {
+				MonsterTypeSet typeSet{};
+				typeSet.name = reader.readString();
+				const uint32_t typeCount = reader.read<uint32_t>();
+				for (uint32_t j = 0; j < typeCount; j++) {
+					MonsterType type{};
+					type.name = reader.readString();
+					type.image = reader.readString();
+					type.size = reader.read<float>();
+					type.health = reader.read<float>();
+					type.speed = reader.read<float>();
+					typeSet.types.push_back(type);
+				}
+				sets.push_back(typeSet);
+			}
+		}
+
 	}
 }
\ No newline at end of file
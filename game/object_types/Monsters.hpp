@@ -7,6 +7,8 @@
 #pragma once
 
 #include <string>
+#include <vector>
+#include <stdint.h>
 
 namespace Game {
 	namespace ObjectTypes {
@@ -31,6 +33,9 @@ namespace Game {
 		public:
 			std::vector<MonsterTypeSet> sets{};
 			void loadFromFile(const std::string jsonFileName);
+			// Compact binary form of the parsed types, used by the asset archive so the json doesn't need to be parsed at runtime
+			std::vector<uint8_t> serialize() const;
+			void loadFromMemory(const void* data, size_t size);
 		};
 
 	}
@@ -0,0 +1,420 @@
+/*
+* Headless simulation runner
+*
+* Runs the game simulation without Vulkan, a window or audio at a fixed timestep with scripted input
+* and reports per-zone CPU timings as JSON (e.g. for throughput regression tests on machines without a GPU)
+*
+* Copyright(C) 2026 by Sascha Willems - www.saschawillems.de
+*
+* This code is licensed under the MIT license(MIT) (http://opensource.org/licenses/MIT)
+*/
+
+#include <iostream>
+#include <fstream>
+#include <cstring>
+#include <cassert>
+#include <string>
+#include <chrono>
+#include <algorithm>
+#include <vector>
+#include <memory>
+#include <random>
+#include <json.hpp>
+#include "CommandLineParser.hpp"
+#include "Game.hpp"
+#include "Replay.hpp"
+
+struct ZoneTiming {
+	double total{ 0.0 };
+	double max{ 0.0 };
+
+	void add(double value)
+	{
+		total += value;
+		max = std::max(max, value);
+	}
+};
+
+// Same values as the windowed application
+const glm::vec2 screenDim{ 25.0f, 25.0f };
+const uint32_t visibleTileCount{ 32 };
+
+std::string getDataPath()
+{
+#if defined(DATA_DIR)
+	return DATA_DIR;
+#else
+	return "./../data/";
+#endif
+}
+
+// FNV-1a hash over the simulation state, runs with identical input need to end up with the same hash
+class StateHash {
+private:
+	uint64_t value{ 14695981039346656037ull };
+public:
+	template<typename T>
+	void add(const T& data)
+	{
+		const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&data);
+		for (size_t i = 0; i < sizeof(T); i++) {
+			value = (value ^ bytes[i]) * 1099511628211ull;
+		}
+	}
+
+	uint64_t get() const
+	{
+		return value;
+	}
+};
+
+uint64_t getStateHash(const Game::Game& game)
+{
+	StateHash hash;
+	hash.add(game.player.position);
+	hash.add(game.player.health);
+	hash.add(game.player.experience);
+	const Game::Entities::MonsterStore& monsters = game.monsters;
+	for (size_t i = 0; i < monsters.size(); i++) {
+		hash.add(monsters.state[i]);
+		hash.add(monsters.position[i]);
+		hash.add(monsters.velocity[i]);
+		hash.add(monsters.health[i]);
+	}
+	for (const auto& projectile : game.projectiles) {
+		hash.add(projectile.state);
+		hash.add(projectile.position);
+	}
+	for (const auto& pickup : game.pickups) {
+		hash.add(pickup.state);
+		hash.add(pickup.position);
+	}
+	hash.add(game.currentRun.monstersKilled);
+	// Unmodified chunks only depend on the seed and the map size
+	for (const Game::TilemapChunk* chunk : game.tilemap.getModifiedChunks()) {
+		hash.add(chunk->position);
+		hash.add(chunk->tiles);
+	}
+	return hash.get();
+}
+
+// Deterministic input pattern: Walk in a square, sprint on every other side and push monsters away from time to time
+Game::InputState getScriptedInput(uint32_t frame)
+{
+	const uint32_t framesPerSide = 120;
+	const uint32_t side = (frame / framesPerSide) % 4;
+	Game::InputState input{};
+	input.moveRight = (side == 0);
+	input.moveDown = (side == 1);
+	input.moveLeft = (side == 2);
+	input.moveUp = (side == 3);
+	input.sprint = ((frame / framesPerSide) % 2 == 1);
+	input.push = (frame % 300 == 0);
+	return input;
+}
+
+void writeReport(const nlohmann::json& report, CommandLineParser& commandLineParser)
+{
+	if (commandLineParser.isSet("output")) {
+		std::ofstream file(commandLineParser.getValueAsString("output", "report.json"));
+		file << report.dump(4) << "\n";
+	} else {
+		std::cout << report.dump(4) << "\n";
+	}
+}
+
+// Same setup as the windowed application
+void setupGame(Game::Game& game, uint32_t seed, uint32_t initialMonsterCount, uint32_t mapWidth = TILEMAP_DEFAULT_DIM, uint32_t mapHeight = TILEMAP_DEFAULT_DIM)
+{
+	game.setSeed(seed);
+	game.playFieldSize = screenDim;
+	game.monsterTypes.loadFromFile(getDataPath() + "game/monsters.json");
+	game.tilemap.setSize(mapWidth, mapHeight);
+	game.tilemap.screenFactor = { 1.0f / (screenDim.x * 2.0f / (float)visibleTileCount), 1.0f / (screenDim.y * 2.0f / (float)visibleTileCount) };
+	game.start(initialMonsterCount);
+}
+
+// Simulates the scripted input with increasing monster counts and reports the zones involved in collision checks
+// For comparison, the cost of checking every monster against every player projectile (as done before the spatial grid) is measured once on the final state of each run
+nlohmann::json benchmarkCollisionScaling(const std::vector<uint32_t>& monsterCounts, uint32_t frameCount, uint32_t seed)
+{
+	nlohmann::json results = nlohmann::json::array();
+	for (uint32_t monsterCount : monsterCounts) {
+		// Fresh game for each count, only one exists at a time as each owns a job system registered with this thread
+		auto game = std::make_unique<Game::Game>();
+		setupGame(*game, seed, monsterCount);
+		ZoneTiming collisionGrid, monsters, playerCollision;
+		double projectileCount{ 0.0 };
+		for (uint32_t frame = 0; frame < frameCount; frame++) {
+			game->tick(getScriptedInput(frame));
+			collisionGrid.add(game->updateTimings.collisionGrid);
+			monsters.add(game->updateTimings.monsters);
+			playerCollision.add(game->updateTimings.playerCollision);
+			projectileCount += static_cast<double>(game->projectiles.alive());
+		}
+
+		const auto tStart = std::chrono::high_resolution_clock::now();
+		uint32_t bruteForceHits{ 0 };
+		const Game::Entities::MonsterStore& store = game->monsters;
+		for (size_t i = 0; i < store.size(); i++) {
+			if (store.state[i] == Game::Entities::State::Dead) {
+				continue;
+			}
+			for (const auto& projectile : game->projectiles) {
+				if ((projectile.state == Game::Entities::State::Dead) || (projectile.source != Game::Entities::Source::Player)) {
+					continue;
+				}
+				if (glm::distance(store.position[i], projectile.position) < store.scale[i]) {
+					bruteForceHits++;
+				}
+			}
+		}
+		const double bruteForceTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - tStart).count();
+
+		const double frames = std::max(frameCount, 1u);
+		results.push_back({
+			{ "monsters", monsterCount },
+			{ "avgProjectiles", projectileCount / frames },
+			{ "collisionGridAvgMs", collisionGrid.total / frames },
+			// Includes monster movement, the grid queries for projectile hits are done in the same loop
+			{ "monstersAvgMs", monsters.total / frames },
+			{ "playerCollisionAvgMs", playerCollision.total / frames },
+			{ "totalAvgMs", (collisionGrid.total + monsters.total + playerCollision.total) / frames },
+			{ "bruteForceProjectileCheckMs", bruteForceTime },
+			{ "bruteForceHits", bruteForceHits }
+		});
+		std::cerr << "Collision scaling: " << monsterCount << " monsters done\n";
+	}
+	return results;
+}
+
+// Layout of the monsters before they were moved into the MonsterStore: One polymorphic object per monster including its weapons
+class BaselineMonster : public Game::Entities::Monster {
+public:
+	bool visible{ false };
+};
+
+// Compares the monster movement loop (single threaded, without collision checks) on an array of monster objects against the structure-of-arrays MonsterStore
+nlohmann::json benchmarkMonsterStorage(const std::vector<uint32_t>& monsterCounts, uint32_t iterations)
+{
+	const float delta = 1.0f / 60.0f;
+	const glm::vec2 playerPosition{ 0.0f };
+	const float visibleDistance = std::max(screenDim.x, screenDim.y) * 1.5f;
+	// Measured time is the best of all iterations, so results aren't skewed by other processes
+	auto measure = [iterations](auto function) {
+		double best{ 1e30 };
+		for (uint32_t i = 0; i < iterations; i++) {
+			const auto tStart = std::chrono::high_resolution_clock::now();
+			function();
+			best = std::min(best, std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - tStart).count());
+		}
+		return best;
+	};
+
+	nlohmann::json results = nlohmann::json::array();
+	for (uint32_t monsterCount : monsterCounts) {
+		std::default_random_engine randomEngine(1);
+		std::uniform_real_distribution<float> positionDist(-100.0f, 100.0f);
+		std::vector<BaselineMonster> objects(monsterCount);
+		Game::Entities::MonsterStore store;
+		for (auto& monster : objects) {
+			monster.position = glm::vec2(positionDist(randomEngine), positionDist(randomEngine));
+			monster.speed = 1.0f + positionDist(randomEngine) * 0.01f;
+			store.add(monster);
+		}
+
+		uint32_t visibleCount{ 0 };
+		const double objectTime = measure([&] {
+			for (auto& monster : objects) {
+				if (monster.state == Game::Entities::State::Dead) {
+					monster.visible = false;
+					continue;
+				}
+				monster.update(delta);
+				monster.visible = glm::length(playerPosition - monster.position) < visibleDistance;
+				monster.direction = glm::normalize(playerPosition - monster.position);
+				monster.velocity += monster.direction * monster.speed * 0.01f;
+				if (glm::length(monster.velocity) > 0.1f) {
+					monster.position += monster.velocity * delta * 100.0f;
+					monster.velocity *= 0.01f * delta;
+				}
+				visibleCount += monster.visible;
+			}
+		});
+		const double storeTime = measure([&] {
+			for (size_t i = 0; i < store.size(); i++) {
+				if (store.state[i] == Game::Entities::State::Dead) {
+					store.visible[i] = false;
+					continue;
+				}
+				store.updateEffect(static_cast<uint32_t>(i), delta);
+				store.visible[i] = glm::length(playerPosition - store.position[i]) < visibleDistance;
+				store.direction[i] = glm::normalize(playerPosition - store.position[i]);
+				store.velocity[i] += store.direction[i] * store.speed[i] * 0.01f;
+				if (glm::length(store.velocity[i]) > 0.1f) {
+					store.position[i] += store.velocity[i] * delta * 100.0f;
+					store.velocity[i] *= 0.01f * delta;
+				}
+				visibleCount += store.visible[i];
+			}
+		});
+
+		results.push_back({
+			{ "monsters", monsterCount },
+			{ "monsterObjectsMs", objectTime },
+			{ "monsterStoreMs", storeTime },
+			{ "speedup", objectTime / storeTime },
+			// Keeps the loops from being optimized away
+			{ "visibleCount", visibleCount }
+		});
+		std::cerr << "Monster storage: " << monsterCount << " monsters done\n";
+	}
+	return results;
+}
+
+int main(int argc, char* argv[])
+{
+	CommandLineParser commandLineParser;
+	commandLineParser.add("help", { "--help" }, 0, "Show help");
+	commandLineParser.add("frames", { "-n", "--frames" }, 1, "No. of frames to simulate (default: 3600)");
+	commandLineParser.add("timestep", { "-t", "--timestep" }, 1, "Fixed timestep in microseconds (default: game's tick duration)");
+	commandLineParser.add("monsters", { "-m", "--monsters" }, 1, "No. of monsters spawned at start (default: 10000)");
+	commandLineParser.add("seed", { "-s", "--seed" }, 1, "Seed for the random engine (default: 1)");
+	commandLineParser.add("mapsize", { "--mapsize" }, 1, "Width and height of the tile map in tiles (default: 64)");
+	commandLineParser.add("output", { "-o", "--output" }, 1, "Write the JSON report to this file instead of stdout");
+	commandLineParser.add("record", { "--record" }, 1, "Record the scripted input to a replay file");
+	commandLineParser.add("replay", { "--replay" }, 1, "Use input, seed, timestep, monster count and map settings from a replay file (e.g. recorded in the application)");
+	commandLineParser.add("benchmark", { "--benchmark" }, 0, "Instead of a single run, report collision timings for 1k to 1M monsters and compare the monster storage layouts at 100k and 1M monsters (--frames defaults to 60)");
+	commandLineParser.parse(argc, argv);
+	if (commandLineParser.isSet("help")) {
+		commandLineParser.printHelp();
+		std::cout << "\n";
+		return 0;
+	}
+
+	if (commandLineParser.isSet("benchmark")) {
+		const uint32_t frameCount = commandLineParser.getValueAsInt("frames", 60);
+		const uint32_t seed = commandLineParser.getValueAsInt("seed", 1);
+		nlohmann::json report;
+		report["frames"] = frameCount;
+		report["seed"] = seed;
+		report["collisionScaling"] = benchmarkCollisionScaling({ 1000, 10000, 100000, 1000000 }, frameCount, seed);
+		report["monsterStorage"] = benchmarkMonsterStorage({ 100000, 1000000 }, 10);
+		writeReport(report, commandLineParser);
+		return 0;
+	}
+
+	Game::Game game;
+
+	uint32_t frameCount = commandLineParser.getValueAsInt("frames", 3600);
+	uint32_t initialMonsterCount = commandLineParser.getValueAsInt("monsters", 10000);
+	uint32_t seed = commandLineParser.getValueAsInt("seed", 1);
+	uint32_t mapWidth = std::max(commandLineParser.getValueAsInt("mapsize", TILEMAP_DEFAULT_DIM), 1);
+	uint32_t mapHeight = mapWidth;
+	if (commandLineParser.isSet("timestep")) {
+		game.tickDuration = static_cast<float>(commandLineParser.getValueAsInt("timestep", 16667)) / 1000000.0f;
+	}
+
+	Game::Replay replay;
+	const bool playbackReplay = commandLineParser.isSet("replay");
+	const bool recordReplay = !playbackReplay && commandLineParser.isSet("record");
+	if (playbackReplay) {
+		const std::string fileName = commandLineParser.getValueAsString("replay", "");
+		if (!replay.loadFromFile(fileName)) {
+			std::cerr << "Error: Could not load replay file " << fileName << "\n";
+			return -1;
+		}
+		seed = replay.seed;
+		initialMonsterCount = replay.initialMonsterCount;
+		game.tickDuration = replay.tickDuration;
+		game.waterSpreadInterval = replay.waterSpreadInterval;
+		mapWidth = replay.mapWidth;
+		mapHeight = replay.mapHeight;
+		if (!commandLineParser.isSet("frames")) {
+			frameCount = static_cast<uint32_t>(replay.getTickCount());
+		}
+	}
+
+	setupGame(game, seed, initialMonsterCount, mapWidth, mapHeight);
+
+	if (recordReplay) {
+		replay.seed = seed;
+		replay.initialMonsterCount = initialMonsterCount;
+		replay.tickDuration = game.tickDuration;
+		replay.mapWidth = mapWidth;
+		replay.mapHeight = mapHeight;
+		replay.waterSpreadInterval = game.waterSpreadInterval;
+	}
+
+	ZoneTiming update, entityUpdates, collisionGrid, monsters, monsterEvents, playerCollision, monsterWeapons, spawn, tiles;
+
+	const auto tStart = std::chrono::high_resolution_clock::now();
+	for (uint32_t frame = 0; frame < frameCount; frame++) {
+		const Game::InputState input = playbackReplay ? replay.getInput(frame) : getScriptedInput(frame);
+		if (recordReplay) {
+			replay.record(input);
+		}
+		game.tick(input);
+		const Game::UpdateTimings& timings = game.updateTimings;
+		update.add(timings.total);
+		entityUpdates.add(timings.entityUpdates);
+		collisionGrid.add(timings.collisionGrid);
+		monsters.add(timings.monsters);
+		monsterEvents.add(timings.monsterEvents);
+		playerCollision.add(timings.playerCollision);
+		monsterWeapons.add(timings.monsterWeapons);
+		spawn.add(timings.spawn);
+		tiles.add(timings.tiles);
+	}
+	const double totalTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - tStart).count();
+
+	auto zoneToJson = [frameCount](const ZoneTiming& zone) {
+		return nlohmann::json{
+			{ "totalMs", zone.total },
+			{ "avgMs", frameCount > 0 ? zone.total / frameCount : 0.0 },
+			{ "maxMs", zone.max }
+		};
+	};
+
+	nlohmann::json report;
+	report["frames"] = frameCount;
+	report["timestep"] = game.tickDuration;
+	report["seed"] = seed;
+	report["initialMonsters"] = initialMonsterCount;
+	report["mapSize"] = { mapWidth, mapHeight };
+	report["totalMs"] = totalTime;
+	report["framesPerSecond"] = totalTime > 0.0 ? frameCount / (totalTime / 1000.0) : 0.0;
+	report["zones"] = {
+		{ "update", zoneToJson(update) },
+		{ "entityUpdates", zoneToJson(entityUpdates) },
+		{ "collisionGrid", zoneToJson(collisionGrid) },
+		{ "monsters", zoneToJson(monsters) },
+		{ "monsterEvents", zoneToJson(monsterEvents) },
+		{ "playerCollision", zoneToJson(playerCollision) },
+		{ "monsterWeapons", zoneToJson(monsterWeapons) },
+		{ "spawn", zoneToJson(spawn) },
+		{ "tiles", zoneToJson(tiles) }
+	};
+	report["final"] = {
+		{ "monsters", game.monsters.alive() },
+		{ "projectiles", game.projectiles.alive() },
+		{ "pickups", game.pickups.alive() },
+		{ "numbers", game.numbers.alive() },
+		{ "monstersKilled", game.currentRun.monstersKilled },
+		{ "playerHealth", game.player.health },
+		{ "playerLevel", game.player.level },
+		{ "stateHash", getStateHash(game) }
+	};
+
+	if (recordReplay) {
+		const std::string fileName = commandLineParser.getValueAsString("record", "");
+		if (!replay.saveToFile(fileName)) {
+			std::cerr << "Error: Could not save replay file " << fileName << "\n";
+			return -1;
+		}
+	}
+
+	writeReport(report, commandLineParser);
+
+	return 0;
+}
@@ -12,18 +12,32 @@
 #include <glm/gtc/type_ptr.hpp>
 #include <stdexcept>
 #include <random>
+#include <algorithm>
+#include <filesystem>
 #include "time.h"
 #include <SFML/Audio.hpp>
+#include <SFML/Window.hpp>
 #include <json.hpp>
 #include "Game.hpp"
+#include "Replay.hpp"
+#include "StreamingStore.hpp"
+#include "StagingRing.hpp"
+#include "PipelineBatch.hpp"
+#include "TextureAtlas.hpp"
+#include "AssetLoader.hpp"
+#include "AssetArchive.hpp"
+#include "LightBinning.hpp"
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
 
 // @todo: audio (music and sfx)
 // @todo: sync2 everywhere
-// @todo: timeline semaphores
 
+// Dynamic buffers are written directly to device local host visible memory (resizable BAR)
+// Configure with USE_REBAR=OFF to use the staging path instead, e.g. for testing it on implementations where all memory is host visible
+#if !defined(NO_REBAR)
 #define USE_REBAR
+#endif
 
 #ifdef TRACY_ENABLE
 void* operator new(size_t count)
@@ -51,6 +65,13 @@ struct ShaderData {
 	glm::vec2 screenRes{ 0.0f };
 	uint32_t lightCount{ 0 };
 	float dayNightCycle{ 0.0f };
+	// Tiled lighting is disabled if maxLightsPerTile is zero
+	glm::uvec2 lightTileCount{ 0 };
+	uint32_t maxLightsPerTile{ 0 };
+	// Used by the tile index image path of the tile map (std140 aligns vec2 to 8 bytes)
+	alignas(8) glm::vec2 playerPos{ 0.0f };
+	glm::vec2 screenDim{ 0.0f };
+	glm::vec2 tilemapDim{ 0.0f };
 } shaderData;
 
 struct Vertex {
@@ -70,19 +91,63 @@ struct InstanceData {
 	uint32_t effect{ 0 };
 };
 
+// Raw sprite state uploaded for the GPU culling path, interpolation, culling and compaction into InstanceData are done in a compute shader
+struct SpriteData {
+	glm::vec2 position;
+	glm::vec2 previousPosition;
+	float scale{ 1.0f };
+	uint32_t imageIndex{ 0 };
+	uint32_t effect{ 0 };
+	uint32_t padding{ 0 };
+};
+
+// The culling shader compacts the visible sprites in order with three dispatches, see cull.slang
+enum class CullingPass : uint32_t { Count = 0, Scan = 1, Write = 2 };
+
+// Needs to match groupSize in cull.slang
+constexpr uint32_t cullingGroupSize = 256;
+
+struct CullingPushConsts {
+	uint32_t spriteCount{ 0 };
+	float alpha{ 0.0f };
+	CullingPass pass{ CullingPass::Count };
+	uint32_t groupCount{ 0 };
+};
+
+// Instance and light buffers are gathered in parallel from chunks of the entity containers
+enum class GatherCategory { Monsters, Projectiles, Pickups, Numbers };
+
+struct GatherChunk {
+	GatherCategory category;
+	size_t begin{ 0 };
+	size_t end{ 0 };
+	// First output element of this chunk, set from the prefix sum over all chunk counts
+	uint32_t offset{ 0 };
+	uint32_t count{ 0 };
+};
+
 struct TilemapInstanceData {
 	IV2 pos;
 	// @todo: smaller data type
-	uint32_t imageIndex{ 0 };
+	// One image per layer, -1 for empty tiles
+	int32_t imageIndices[TILEMAP_LAYER_COUNT]{};
 	// uint32_t effect{ 0 };
 };
 
-struct LightSource {
-	alignas(16) glm::vec2 pos{ 0.0f };
-	alignas(16) glm::vec3 color{ 1.0f };
-	float radius;
+// Instances of one tile map chunk in the chunk cache
+struct TilemapChunkDraw {
+	uint32_t firstInstance{ 0 };
+	uint32_t instanceCount{ 0 };
 };
 
+constexpr uint32_t tilemapChunkCacheSlotCount = 64;
+
+// The tile index image holds this many chunks in each dimension, chunk x, y is stored in cell x % count, y % count
+// Needs to match tileWindowSize (in tiles) in tilemap.slang
+constexpr uint32_t tilemapWindowChunkCount = 4;
+// Layers are stacked vertically in the tile index image, each of them has its own range for every cell in the frame's staging buffer
+constexpr VkDeviceSize tilemapCellLayerStagingSize = TILEMAP_CHUNK_DIM * TILEMAP_CHUNK_DIM * sizeof(uint16_t);
+
 enum class PostProcessEffect {
 	None = 0,
 	FadeIn = 1
@@ -94,6 +159,8 @@ class Application : public VulkanApplication {
 private:
 	// Changing buffers (e.g. instance, will increase by this size)
 	const uint32_t instanceBufferBlockSizeIncrease{ 2048 };
+	// No. of entities per job when gathering instances and lights
+	size_t gatherGrainSize{ 4096 };
 	struct FrameObjects : public VulkanFrameObjects {
 		Buffer* uniformBuffer{ nullptr };
 		DescriptorSet* descriptorSet{ nullptr };
@@ -102,22 +169,46 @@ private:
 		uint32_t instanceBufferSize{ 0 };
 		uint32_t instanceBufferDrawCount{ 0 };
 		uint32_t instanceBufferMaxCount{ 0 };
-		InstanceData* instances{nullptr};
 
-		LightSource* lights{ nullptr };
+		// GPU culling
+		Buffer* spriteBuffer{ nullptr };
+		Buffer* culledInstanceBuffer{ nullptr };
+		Buffer* indirectDrawBuffer{ nullptr };
+		// Visible sprites per culling workgroup, turned into output offsets by the culling shader
+		Buffer* cullingGroupOffsetsBuffer{ nullptr };
+		uint32_t spriteCount{ 0 };
+		uint32_t spriteBufferMaxCount{ 0 };
+		DescriptorSet* descriptorSetCulling{ nullptr };
+
 		uint32_t lightsBufferSize{ 0 };
 		uint32_t lightsBufferDrawCount{ 0 };
 		uint32_t lightsBufferMaxCount{ 0 };
 		Buffer* lightsBuffer{ nullptr };
 		DescriptorSet* descriptorSetLights{ nullptr };
 
+		// Tiled lighting
+		Buffer* tileLightCountsBuffer{ nullptr };
+		Buffer* tileLightIndicesBuffer{ nullptr };
+		uint32_t lightTileMaxCount{ 0 };
+		DescriptorSet* descriptorSetLightCulling{ nullptr };
+		// Inputs of the last light binning, kept to compare the GPU results against the CPU reference once the frame has finished
+		struct LightTileValidation {
+			bool pending{ false };
+			std::vector<LightSource> lights{};
+			glm::uvec2 tileCount{ 0 };
+			glm::vec2 screenRes{ 0.0f };
+			float viewportAR{ 0.0f };
+		} lightTileValidation;
+
 		Buffer* uiBuffer{ nullptr };
 		uint32_t uiBufferSize{ 0 };
 		uint32_t uiBufferVertexCount{ 0 };
 
-		// @todo: Tilemap rendering
-		uint32_t tilemapInstanceCount{ 0 };
-		Buffer* tilemapInstanceBuffer{ nullptr };
+		// Ranges of the tile map chunk cache to draw
+		std::vector<TilemapChunkDraw> tilemapDraws{};
+		// Chunks and changed tiles copied into the tile index image with this frame
+		Buffer* tilemapStagingBuffer{ nullptr };
+		std::vector<VkBufferImageCopy> tilemapImageCopies{};
 		// @todo: Separate projectiles into own set of instance buffers (due to different update frequency?)
 		//struct Projectiles {
 		//	Buffer* instanceBuffer{ nullptr };
@@ -125,17 +216,43 @@ private:
 		//	uint32_t instanceBufferDrawCount{ 0 };
 		//} projectiles;
 	};
-	TilemapInstanceData* tilemapInstances{ nullptr };
-	// One large staging buffer that's reused for all copies
-	// @todo: per frame?
-	const size_t stagingBufferSize = 64 * 1024 * 1024;
-	Buffer* stagingBuffer{ nullptr };
-	CommandBuffer* copyCommandBuffer{ nullptr };
+	// Tile instances of the visible chunks are uploaded once into slots of a buffer shared by all frames and stay there until the slot is needed for another chunk
+	struct TilemapChunkCache {
+		struct Slot {
+			uint64_t chunkKey{ 0 };
+			uint32_t instanceCount{ 0 };
+			// Last frame that drew this slot, it can only be reused once that frame has finished
+			uint64_t lastUsedFrame{ 0 };
+			bool used{ false };
+		};
+		Buffer* instanceBuffer{ nullptr };
+		std::vector<Slot> slots{};
+		std::unordered_map<uint64_t, uint32_t> chunkSlots{};
+		uint32_t tilemapRevision{ 0 };
+		uint32_t uploadCount{ 0 };
+	} tilemapChunkCache;
+	// Tile indices of the chunks around the player are stored in an R16_UINT image (Tilemap::texture) that's drawn with a single full screen triangle
+	// Its cells form a window that wraps around as the player moves, so the image has a fixed size no matter how large the map is, and a cell is only written when a new chunk moves into it
+	// Tiles changed by the game later on are updated by copying the dirty regions of each layer
+	struct TilemapIndexImage {
+		// Chunk stored in each cell
+		std::vector<uint64_t> cellChunkKeys{};
+		std::vector<bool> cellsValid{};
+		uint32_t tilemapRevision{ 0 };
+		uint32_t uploadCount{ 0 };
+		// Dirty regions copied for changed tiles
+		uint32_t regionUploadCount{ 0 };
+	} tilemapIndexImage;
+	// Without ReBAR dynamic buffers are uploaded through per-frame staging buffers, with copies recorded into the frame's command buffer
+	StagingRing* stagingRing{ nullptr };
 
 	// One set for all images
 	std::vector<VkDescriptorImageInfo> textureDescriptors{};
 	std::vector<VkDescriptorImageInfo> samplerDescriptors{};
 	std::vector<vks::Texture2D*> textures{};
+	// Sprite images are packed into an atlas, instance image indices index its rect table
+	vks::TextureAtlas* spriteAtlas{ nullptr };
+	vks::AssetLoader* assetLoader{ nullptr };
 	Sampler* spriteSampler{ nullptr };
 	Sampler* renderImageSampler{ nullptr };
 
@@ -147,18 +264,46 @@ private:
 	DescriptorSetLayout* descriptorSetLayoutTextures{ nullptr };
 	DescriptorSetLayout* descriptorSetLayoutLights{ nullptr };
 	DescriptorSetLayout* descriptorSetLayoutRenderImage{ nullptr };
+	DescriptorSetLayout* descriptorSetLayoutCulling{ nullptr };
+	DescriptorSetLayout* descriptorSetLayoutLightCulling{ nullptr };
+	DescriptorSetLayout* descriptorSetLayoutSpriteAtlas{ nullptr };
 	DescriptorSet* descriptorSetTextures{ nullptr };
 	DescriptorSet* descriptorSetSamplers{ nullptr };
 	DescriptorSet* descriptorSetRenderImage{ nullptr };
+	DescriptorSet* descriptorSetSpriteAtlas{ nullptr };
 	std::unordered_map<std::string, PipelineLayout*> pipelineLayouts;
 	std::unordered_map<std::string, Pipeline*> pipelines;
+	// Optional packed assets, needs to outlive the background music as that's streamed from the mapped archive
+	vks::AssetArchive assetArchive;
+	std::string assetArchiveFileName{};
 	sf::Music backgroundMusic;
 	Buffer* quadBuffer{ nullptr };
 	glm::vec2 screenDim{ 0.0f };
 	PostProcessEffect postProcessEffect{ PostProcessEffect::None };
 	float postProcessTimeFactor{ 1.0f };
 	uint32_t visibleTileCount{ 32 };
+	// Width and height of the tile map in tiles
+	uint32_t tilemapSize{ TILEMAP_DEFAULT_DIM };
 	uint32_t crtFrameImageIndex{ 0 };
+	// Input replay recording or playback
+	Game::Replay replay;
+	bool recordReplay{ false };
+	bool playbackReplay{ false };
+	std::string replayFileName{};
+	// Cull and compact sprite instances in a compute shader instead of on the CPU
+	bool gpuCulling{ false };
+	// Bin lights into screen tiles in a compute shader, so the post process doesn't need to iterate all lights for every pixel
+	bool tiledLighting{ true };
+	// Draw the tile map from the tile index image instead of one instanced draw per chunk
+	bool tilemapImage{ false };
+	// Read back the light tiles and compare them against the CPU reference
+	bool validateLightTiles{ false };
+	uint32_t validatedLightTileFrames{ 0 };
+	uint32_t failedLightTileFrames{ 0 };
+	// Compare cold and warm pipeline creation at startup, then exit
+	bool startupBenchmark{ false };
+	// Print a breakdown of the startup time
+	bool verbose{ false };
 public:	
 	Application() : VulkanApplication() {
 		apiVersion = VK_API_VERSION_1_3;
@@ -167,6 +312,8 @@ public:
 		Device::enabledFeatures.samplerAnisotropy = VK_TRUE;
 		Device::enabledFeatures.depthClamp = VK_TRUE;
 		Device::enabledFeatures.fillModeNonSolid = VK_TRUE;
+		// Optional, only enabled if supported, used for compressed images from the asset archive
+		Device::enabledFeatures.textureCompressionBC = VK_TRUE;
 
 		Device::enabledFeatures11.multiview = VK_TRUE;
 		Device::enabledFeatures11.shaderDrawParameters = VK_TRUE;
@@ -178,8 +325,13 @@ public:
 		//settings.sampleCount = VK_SAMPLE_COUNT_4_BIT;
 
 		audioManager = new AudioManager();
+		game.onPlaySound = [](const std::string& name) {
+			audioManager->playSnd(name);
+		};
 
 		slangCompiler = new SlangCompiler();
+		// Compiled shaders are kept next to the pipeline cache, so warm starts skip both shader compilation and pipeline compilation
+		slangCompiler->cacheDirectory = cachePath.empty() ? "" : cachePath + "shaders/";
 
 		// @todo: absolute or relative?
 		const float aspectRatio = (float)width / (float)height;
@@ -187,21 +339,83 @@ public:
 		//shaderData.projection = glm::ortho(-screenDim.x, screenDim.x, -screenDim.x, screenDim.x);
 
 		title = "Bindless Survivors";
+
+		// Game specific command line arguments
+		commandLineParser.add("seed", { "--seed" }, 1, "Seed for the game's random engine");
+		commandLineParser.add("record", { "--record" }, 1, "Record input to a replay file");
+		commandLineParser.add("replay", { "--replay" }, 1, "Play back input from a replay file");
+		commandLineParser.add("gpuculling", { "--gpuculling" }, 0, "Cull sprites on the GPU and draw them indirectly");
+		commandLineParser.add("archive", { "--archive" }, 1, "Load assets from this packed archive (default: assets.pak in the data directory if present)");
+		commandLineParser.add("mapsize", { "--mapsize" }, 1, "Width and height of the tile map in tiles, only the chunks around the player are kept in memory (default: 64)");
+		commandLineParser.add("tilemapimage", { "--tilemapimage" }, 0, "Draw the tile map with a single full screen triangle that looks up tiles in a tile index image");
+		commandLineParser.add("notiledlighting", { "--notiledlighting" }, 0, "Iterate all lights for every pixel instead of binning them into screen tiles");
+		commandLineParser.add("validatelighttiles", { "--validatelighttiles" }, 0, "Compare the light tiles binned on the GPU against a CPU reference every frame (slow)");
+		commandLineParser.add("startupbenchmark", { "--startupbenchmark" }, 0, "Create all pipelines without and then with cached shaders and pipeline data, print the timings of both and exit");
+		commandLineParser.add("verbose", { "--verbose" }, 0, "Print a breakdown of the startup time");
+		commandLineParser.parse(args);
+		assetArchiveFileName = commandLineParser.getValueAsString("archive", "");
+		if (commandLineParser.isSet("seed")) {
+			game.setSeed(commandLineParser.getValueAsInt("seed", 0));
+		}
+		gpuCulling = commandLineParser.isSet("gpuculling");
+		if (commandLineParser.isSet("mapsize")) {
+			tilemapSize = std::max(commandLineParser.getValueAsInt("mapsize", TILEMAP_DEFAULT_DIM), 1);
+		}
+		tilemapImage = commandLineParser.isSet("tilemapimage");
+		tiledLighting = !commandLineParser.isSet("notiledlighting");
+		validateLightTiles = commandLineParser.isSet("validatelighttiles");
+		startupBenchmark = commandLineParser.isSet("startupbenchmark");
+		verbose = commandLineParser.isSet("verbose");
+		if (commandLineParser.isSet("replay")) {
+			replayFileName = commandLineParser.getValueAsString("replay", "");
+			if (!replay.loadFromFile(replayFileName)) {
+				std::cerr << "Error: Could not load replay file " << replayFileName << "\n";
+				exit(-1);
+			}
+			// A replay needs to run with the same seed, timestep and simulation settings as the recorded run
+			game.setSeed(replay.seed);
+			game.tickDuration = replay.tickDuration;
+			game.waterSpreadInterval = replay.waterSpreadInterval;
+			if (commandLineParser.isSet("mapsize") && ((replay.mapWidth != tilemapSize) || (replay.mapHeight != tilemapSize))) {
+				std::cerr << "Ignoring --mapsize, the replay was recorded with a map size of " << replay.mapWidth << " x " << replay.mapHeight << "\n";
+			}
+			playbackReplay = true;
+		} else if (commandLineParser.isSet("record")) {
+			replayFileName = commandLineParser.getValueAsString("record", "");
+			recordReplay = true;
+		}
 	}
 		
 
 	~Application() {		
+		if (recordReplay) {
+			if (!replay.saveToFile(replayFileName)) {
+				std::cerr << "Error: Could not save replay file " << replayFileName << "\n";
+			}
+		}
 		vkDeviceWaitIdle(VulkanContext::device->logicalDevice);
+		if (validateLightTiles) {
+			for (FrameObjects& frame : frameObjects) {
+				validateLightTileFrame(frame);
+			}
+			std::cout << "Light tile validation: " << failedLightTileFrames << " of " << validatedLightTileFrames << " frames didn't match the CPU reference\n";
+		}
 		for (FrameObjects& frame : frameObjects) {
 			destroyBaseFrameObjects(frame);
 			delete frame.uniformBuffer;
 			delete frame.instanceBuffer;
 			delete frame.lightsBuffer;
+			delete frame.tileLightCountsBuffer;
+			delete frame.tileLightIndicesBuffer;
 			delete frame.uiBuffer;
-			delete[] frame.instances;
-			delete frame.tilemapInstanceBuffer;
+			delete frame.spriteBuffer;
+			delete frame.culledInstanceBuffer;
+			delete frame.indirectDrawBuffer;
+			delete frame.cullingGroupOffsetsBuffer;
+			delete frame.tilemapStagingBuffer;
 		}
-		delete stagingBuffer;
+		delete stagingRing;
+		delete tilemapChunkCache.instanceBuffer;
 		if (fileWatcher) {
 			fileWatcher->stop();
 			delete fileWatcher;
@@ -212,15 +426,13 @@ public:
 		for (auto& texture : textures) {
 			delete texture;
 		}
-		//for (auto& texture : tileMap.textures) {
-		//	delete texture;
-		//}
-		//delete tileMap.texture;
-		if (!copyCommandBuffer) {
-			delete copyCommandBuffer;
-		}
+		delete spriteAtlas;
+		// The tile index image is deleted with the other textures
 		delete descriptorPool;
 		delete descriptorSetLayoutUniforms;
+		delete descriptorSetLayoutCulling;
+		delete descriptorSetLayoutLightCulling;
+		delete descriptorSetLayoutSpriteAtlas;
 
 		// @todo: move to manager class
 		if (backgroundMusic.Playing) {
@@ -281,41 +493,90 @@ public:
 		loadTexture(filename, index);
 	}
 
+	// Images are decoded in the background, the asset loader needs to be finished before they're used
 	void loadAssets() {		
-		game.monsterTypes.loadFromFile(getAssetPath() + "game/monsters.json");
+		// Assets are taken from the archive if there is one, with the loose files as the fallback
+		if (assetArchiveFileName.empty()) {
+			assetArchiveFileName = getAssetPath() + "assets.pak";
+		}
+		if (assetArchive.open(assetArchiveFileName)) {
+			std::cout << "Using asset archive " << assetArchiveFileName << " (" << assetArchive.getEntryCount() << " assets)\n";
+		}
+
+		spriteAtlas = new vks::TextureAtlas({});
+		assetLoader = new vks::AssetLoader({
+			.jobSystem = &game.jobSystem,
+			.assetPath = getAssetPath(),
+			.archive = &assetArchive,
+			.atlas = spriteAtlas,
+			.textures = &textures
+		});
+
+		const vks::AssetArchiveEntry* monsterTable = assetArchive.find("game/monsters.json");
+		if (monsterTable && (monsterTable->type == vks::AssetArchiveEntryType::MonsterTable)) {
+			game.monsterTypes.loadFromMemory(assetArchive.getData(*monsterTable), monsterTable->size);
+		} else {
+			game.monsterTypes.loadFromFile(getAssetPath() + "game/monsters.json");
+		}
 		// @todo
 		for (auto& set : game.monsterTypes.sets) {
 			for (auto& type : set.types) {
-				loadTexture(getAssetPath() + "game/monsters/" + type.image, type.imageIndex);
+				type.imageIndex = assetLoader->addSprite("game/monsters/" + type.image);
 			}
 		}
 
 		// Numbers
-		game.firstNumberImageIndex = static_cast<uint32_t>(textures.size());
 		for (uint32_t i = 0; i < 10; i++) {
-			loadTexture(getAssetPath() + "game/numbers/num_" + std::to_string(i) + ".png");
+			const uint32_t index = assetLoader->addSprite("game/numbers/num_" + std::to_string(i) + ".png");
+			if (i == 0) {
+				game.firstNumberImageIndex = index;
+			}
 		}
 
 		// @todo: Player images
-		loadTexture(getAssetPath() + "game/players/human_male.png", game.player.imageIndex);
+		game.player.imageIndex = assetLoader->addSprite("game/players/human_male.png");
 
 		// @todo: Projectile images
-		loadTexture(getAssetPath() + "game/projectiles/magic_bolt_1.png", game.projectileImageIndex);
-		loadTexture(getAssetPath() + "game/projectiles/magic_bolt_4.png", game.projectileImageIndexMonster);
-		loadTexture(getAssetPath() + "game/pickups/misc_crystal_old.png", game.experienceImageIndex);
+		game.projectileImageIndex = assetLoader->addSprite("game/projectiles/magic_bolt_1.png");
+		game.projectileImageIndexMonster = assetLoader->addSprite("game/projectiles/magic_bolt_4.png");
+		game.experienceImageIndex = assetLoader->addSprite("game/pickups/misc_crystal_old.png");
 
 		// @todo: tile map
+		// Tile ids (see Game::Tiles) index these images starting at firstTileIndex
 		const std::string tileSet{ "set0" };
-		uint32_t dummyIdx;
-		loadTexture(getAssetPath() + "game/tiles/" + tileSet + "/empty.png");
-		loadTexture(getAssetPath() + "game/tiles/" + tileSet + "/floor00.png", game.tilemap.firstTileIndex);
-		loadTexture(getAssetPath() + "game/tiles/" + tileSet + "/floor01.png", game.tilemap.lastTileIndex);
-		loadTexture(getAssetPath() + "game/tiles/" + tileSet + "/floor02.png", game.tilemap.lastTileIndex);
-		loadTexture(getAssetPath() + "game/tiles/" + tileSet + "/water.png", game.tilemap.lastTileIndex);
-		loadTexture(getAssetPath() + "game/crtframe.png", crtFrameImageIndex);
+		const std::string tilePath = "game/tiles/" + tileSet + "/";
+		// Tile sets without wall images use a checkerboard placeholder, so tile ids still map to consecutive images and the tiles are visible
+		// Cells that aren't drawn in the given color are black, or transparent for overlays, so the tile below shows through
+		auto addOptionalTile = [&](const std::string& filename, glm::u8vec4 placeholderColor, bool overlay) {
+			const bool available = assetArchive.find(tilePath + filename) || std::filesystem::exists(getAssetPath() + tilePath + filename);
+			if (available) {
+				return assetLoader->addTexture(tilePath + filename);
+			}
+			std::cerr << "Tile image " << tilePath + filename << " not found, using a placeholder\n";
+			const uint32_t size{ 32 };
+			std::vector<uint8_t> pixels(size * size * 4);
+			for (uint32_t y = 0; y < size; y++) {
+				for (uint32_t x = 0; x < size; x++) {
+					const glm::u8vec4 color = (((x / 8) + (y / 8)) % 2 == 0) ? placeholderColor : glm::u8vec4(0, 0, 0, overlay ? 0 : 255);
+					memcpy(&pixels[(y * size + x) * 4], &color, 4);
+				}
+			}
+			return assetLoader->addTexture(tilePath + filename + " (placeholder)", std::move(pixels), size, size);
+		};
+		assetLoader->addTexture(tilePath + "empty.png");
+		game.tilemap.firstTileIndex = assetLoader->addTexture(tilePath + "floor00.png");
+		assetLoader->addTexture(tilePath + "floor01.png");
+		assetLoader->addTexture(tilePath + "floor02.png");
+		assetLoader->addTexture(tilePath + "water.png");
+		addOptionalTile("wall.png", { 255, 0, 255, 255 }, false);
+		game.tilemap.lastTileIndex = addOptionalTile("crack.png", { 255, 255, 0, 255 }, true);
+		crtFrameImageIndex = assetLoader->addTexture("game/crtframe.png");
 
 		// Game UI
-		loadTexture(getAssetPath() + "game/ui.png", game.uiImageIndex);
+		game.uiImageIndex = assetLoader->addTexture("game/ui.png");
+
+		assetLoader->start();
+
 		SamplerCreateInfo samplerCI {
 			.name = "Sprite sampler",
 			.magFilter = VK_FILTER_NEAREST,
@@ -345,39 +606,53 @@ public:
 		};
 
 		for (auto& it : soundFiles) {
-			audioManager->addSoundFile(it.first, getAssetPath() + it.second);
+			if (const vks::AssetArchiveEntry* sound = assetArchive.find(it.second)) {
+				audioManager->addSoundFromMemory(it.first, assetArchive.getData(*sound), sound->size);
+			} else {
+				audioManager->addSoundFile(it.first, getAssetPath() + it.second);
+			}
 		}
 	}
 	
-	void initTileMap()
+	void createTileMap()
 	{
-		auto& tilemap = game.tilemap;
-
-		//game.tilemap.setSize(TILEMAP_MAX_DIM, TILEMAP_MAX_DIM);
+		// Tiles are generated chunk by chunk around the player while playing (see updateTileMap)
+		if (playbackReplay) {
+			game.tilemap.setSize(replay.mapWidth, replay.mapHeight);
+		} else {
+			game.tilemap.setSize(tilemapSize, tilemapSize);
+		}
 		game.tilemap.screenFactor = { 1.0f / (screenDim.x * 2.0f / (float)visibleTileCount), 1.0f / (screenDim.y * 2.0f / (float)visibleTileCount) };
 		shaderData.tilemapDim = { (float)game.tilemap.width, (float)game.tilemap.height };
-		//const size_t texBufferSize = game.tilemap.width * game.tilemap.height * 4;
-		//uint32_t* texBuffer = new uint32_t[texBufferSize];
-		//memset(texBuffer, 0, texBufferSize);
-
-		// @todo: random tiles for testing
-		std::uniform_int_distribution<uint32_t> rndTile(0, static_cast<uint32_t>(0, 2));
-		for (auto x = 0; x < TILEMAP_MAX_DIM; x++) {
-			for (auto y = 0; y < TILEMAP_MAX_DIM; y++) {
-				// Border
-				if (y == 0 || y == TILEMAP_MAX_DIM - 1 || x == 0 || x == TILEMAP_MAX_DIM - 1) {
-					tilemap.data[x][y] = 3;
-					continue;
-				}
-				// @todo: testing
-				if (x % 16 == 0 && y % 16 == 0) {
-					tilemap.data[x][y] = 4;
-					continue;
-				}
-				tilemap.data[x][y] = rndTile(game.randomEngine);
-			}
-		}
+	}
 
+	// Creates the (empty) tile index image, chunks are copied into it once they're visible (see updateTilemapIndexImage)
+	// The layers are stacked vertically, so the image can be accessed like all other textures
+	void createTilemapIndexImage()
+	{
+		const uint32_t dim = tilemapWindowChunkCount * TILEMAP_CHUNK_DIM;
+		std::vector<uint16_t> tiles(dim * dim * TILEMAP_LAYER_COUNT, Game::Tiles::Empty);
+		game.tilemap.texture = new vks::Texture2D({
+			.buffer = tiles.data(),
+			.bufferSize = tiles.size() * sizeof(uint16_t),
+			.texWidth = dim,
+			.texHeight = dim * TILEMAP_LAYER_COUNT,
+			.format = VK_FORMAT_R16_UINT,
+			.createSampler = false,
+			.generateMipmaps = false
+		});
+		game.tilemap.imageIndex = static_cast<uint32_t>(textures.size());
+		textures.push_back(game.tilemap.texture);
+		tilemapIndexImage.cellChunkKeys.resize(tilemapWindowChunkCount * tilemapWindowChunkCount);
+		tilemapIndexImage.cellsValid.resize(tilemapWindowChunkCount * tilemapWindowChunkCount);
+		for (FrameObjects& frame : frameObjects) {
+			frame.tilemapStagingBuffer = new Buffer({
+				.name = "Tile map index image staging buffer",
+				.usageFlags = VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+				.size = tilemapWindowChunkCount * tilemapWindowChunkCount * TILEMAP_LAYER_COUNT * tilemapCellLayerStagingSize,
+				.map = true
+			});
+		}
 	}
 
 	void updateTextureDescriptor() {
@@ -480,48 +755,262 @@ public:
 		delete stagingBuffer;
 	}
 
-	// @todo
-	// Tile map for the background is stored as a single one integer channel format, with each pixel storing a zero-based tile index
-	void updateTileMap(FrameObjects& frame) {
-		// @todo: only visible tiles
+	// Returns the chunk's slot in the chunk cache and uploads its instances if it's not cached yet, returns false if there's no slot available right now
+	bool getTilemapChunkSlot(const Game::TilemapChunk& chunk, uint64_t frameNumber, uint32_t& slotIndex) {
+		TilemapChunkCache& cache = tilemapChunkCache;
+		const uint64_t key = Game::Tilemap::chunkKey(chunk.position);
+		auto it = cache.chunkSlots.find(key);
+		if (it != cache.chunkSlots.end()) {
+			slotIndex = it->second;
+			cache.slots[slotIndex].lastUsedFrame = frameNumber;
+			return true;
+		}
 
-		Game::Tilemap& tilemap = game.tilemap;
+		// Use a free slot or the least recently used one, slots read by frames in flight can't be overwritten
+		const uint64_t completedFrameNumber = getCompletedFrameNumber();
+		bool found{ false };
+		for (uint32_t i = 0; i < cache.slots.size(); i++) {
+			const TilemapChunkCache::Slot& slot = cache.slots[i];
+			if (slot.lastUsedFrame > completedFrameNumber) {
+				continue;
+			}
+			if (!slot.used) {
+				slotIndex = i;
+				found = true;
+				break;
+			}
+			if (!found || (slot.lastUsedFrame < cache.slots[slotIndex].lastUsedFrame)) {
+				slotIndex = i;
+				found = true;
+			}
+		}
+		if (!found) {
+			return false;
+		}
+		TilemapChunkCache::Slot& slot = cache.slots[slotIndex];
+		if (slot.used) {
+			cache.chunkSlots.erase(slot.chunkKey);
+		}
 
-		if (!tilemapInstances) {
-			tilemapInstances = new TilemapInstanceData[TILEMAP_MAX_DIM * TILEMAP_MAX_DIM];
+		// Only tiles within the map are stored, so chunks at the map's edges have fewer instances
+		const Game::Tilemap& tilemap = game.tilemap;
+		constexpr uint32_t chunkTileCount = TILEMAP_CHUNK_DIM * TILEMAP_CHUNK_DIM;
+		TilemapInstanceData instances[chunkTileCount];
+		uint32_t instanceCount{ 0 };
+		for (uint32_t y = 0; y < TILEMAP_CHUNK_DIM; y++) {
+			for (uint32_t x = 0; x < TILEMAP_CHUNK_DIM; x++) {
+				const int32_t tx = chunk.position.x * TILEMAP_CHUNK_DIM + x;
+				const int32_t ty = chunk.position.y * TILEMAP_CHUNK_DIM + y;
+				if (!tilemap.contains(tx, ty)) {
+					continue;
+				}
+				TilemapInstanceData& instance = instances[instanceCount++];
+				instance.pos = { .x = (uint32_t)tx * 2, .y = (uint32_t)ty * 2 };
+				for (uint32_t layer = 0; layer < TILEMAP_LAYER_COUNT; layer++) {
+					const uint16_t tile = chunk.tiles[layer][y * TILEMAP_CHUNK_DIM + x];
+					instance.imageIndices[layer] = (tile == Game::Tiles::Empty) ? -1 : static_cast<int32_t>(tile + tilemap.firstTileIndex);
+				}
+			}
 		}
+		const VkDeviceSize offset = static_cast<VkDeviceSize>(slotIndex) * chunkTileCount * sizeof(TilemapInstanceData);
+#if defined(USE_REBAR)
+		memcpy(static_cast<uint8_t*>(cache.instanceBuffer->mapped) + offset, instances, instanceCount * sizeof(TilemapInstanceData));
+#else
+		stagingRing->upload(instances, cache.instanceBuffer->buffer, instanceCount * sizeof(TilemapInstanceData), offset);
+#endif
+		slot = { .chunkKey = key, .instanceCount = instanceCount, .lastUsedFrame = frameNumber, .used = true };
+		cache.chunkSlots[key] = slotIndex;
+		cache.uploadCount++;
+		return true;
+	}
 
-		if (!frame.tilemapInstanceBuffer) {
-			frame.tilemapInstanceBuffer = new Buffer({
+	// Selects the cached chunks to draw, instances are only generated and uploaded for chunks that weren't visible recently, so frames without new chunks do no tile work
+	void updateTileMap(FrameObjects& frame) {
+		Game::Tilemap& tilemap = game.tilemap;
+		TilemapChunkCache& cache = tilemapChunkCache;
+
+		if (!cache.instanceBuffer) {
+			cache.instanceBuffer = new Buffer({
+				.name = "Tile map chunk instances",
 				.usageFlags = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-				.size = TILEMAP_MAX_DIM * TILEMAP_MAX_DIM * sizeof(TilemapInstanceData),
+				.size = tilemapChunkCacheSlotCount * TILEMAP_CHUNK_DIM * TILEMAP_CHUNK_DIM * sizeof(TilemapInstanceData),
+#if defined(USE_REBAR)
 				.vmaAllocFlags = VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VMA_ALLOCATION_CREATE_HOST_ACCESS_ALLOW_TRANSFER_INSTEAD_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT,
 				.map = true,
+#endif
 			});
+			cache.slots.resize(tilemapChunkCacheSlotCount);
+		}
+		if (cache.tilemapRevision != tilemap.getRevision()) {
+			// Slots are only marked as free, their last use is kept so they aren't overwritten while still in use
+			for (auto& slot : cache.slots) {
+				slot.used = false;
+			}
+			cache.chunkSlots.clear();
+			cache.tilemapRevision = tilemap.getRevision();
+		}
+
+		frame.tilemapDraws.clear();
+		frame.tilemapImageCopies.clear();
+		const glm::vec2 playerPosition = getPlayerPosition();
+		glm::ivec2 currentTilePos = glm::ivec2{ (int)(floor(playerPosition.x / 2.0f)), (int)(floor(playerPosition.y / 2.0f)) };
+		// The visible tiles are always within the chunks around the player's chunk
+		tilemap.streamAround(currentTilePos);
+
+		applyTilemapChanges(frame);
+
+		if (tilemapImage) {
+			updateTilemapIndexImage(frame, currentTilePos);
+			return;
 		}
 
-		frame.tilemapInstanceCount = 0;
-		glm::ivec2 currentTilePos = glm::ivec2{ (int)(floor(game.player.position.x / 2.0f)), (int)(floor(game.player.position.y / 2.0f)) };
-		// @todo: calculate from screen dimension
-		int32_t sx = currentTilePos.x - 10;
-		int32_t ex = currentTilePos.x + 10;
-		int32_t sy = currentTilePos.y - 10;
-		int32_t ey = currentTilePos.y + 10;
-		for (int32_t y = sy; y <= ey; y++) {
-			for (int32_t x = sx; x <= ex; x++) {
-				if ((x < 0) || (y < 0) || (x > TILEMAP_MAX_DIM - 1) || (y > TILEMAP_MAX_DIM - 1)) {
+		// Tiles are two units wide and the view spans screenDim units from the player in each direction
+		const glm::ivec2 visibleTileRadius = glm::ivec2(glm::ceil(screenDim / 2.0f)) + 1;
+		const glm::ivec2 start = glm::max(currentTilePos - visibleTileRadius, glm::ivec2(0));
+		const glm::ivec2 end = glm::min(currentTilePos + visibleTileRadius, glm::ivec2(tilemap.width, tilemap.height) - 1);
+		if (glm::any(glm::greaterThan(start, end))) {
+			return;
+		}
+		// Whole chunks overlapping the visible tiles are drawn
+		const int32_t chunkDim = static_cast<int32_t>(TILEMAP_CHUNK_DIM);
+		for (int32_t cy = start.y / chunkDim; cy <= end.y / chunkDim; cy++) {
+			for (int32_t cx = start.x / chunkDim; cx <= end.x / chunkDim; cx++) {
+				const Game::TilemapChunk* chunk = tilemap.findChunk({ cx, cy });
+				uint32_t slotIndex{ 0 };
+				if (!chunk || !getTilemapChunkSlot(*chunk, frame.frameNumber, slotIndex)) {
 					continue;
 				}
-				tilemapInstances[frame.tilemapInstanceCount] = {
-					.pos = {.x = (uint32_t)x * 2, .y = (uint32_t)y * 2 },
-					.imageIndex = tilemap.data[x][y] + game.tilemap.firstTileIndex
-				};
-				frame.tilemapInstanceCount++;
+				frame.tilemapDraws.push_back({ .firstInstance = slotIndex * TILEMAP_CHUNK_DIM * TILEMAP_CHUNK_DIM, .instanceCount = cache.slots[slotIndex].instanceCount });
 			}
 		}
-#if defined(USE_REBAR)
-		memcpy(frame.tilemapInstanceBuffer->mapped, &tilemapInstances[0], frame.tilemapInstanceCount * sizeof(TilemapInstanceData));
-#endif
+	}
+
+	// Copies a region of one of the chunk's layers into the frame's staging buffer and adds the copy to the cell of the tile index image
+	// Each cell and layer has its own range in the staging buffer, which the region's tiles are packed into row by row
+	void stageTilemapRegion(FrameObjects& frame, const Game::TilemapChunk& chunk, uint32_t cell, uint32_t layer, const Game::TilemapRect& rect) {
+		const glm::uvec2 cellPos{ cell % tilemapWindowChunkCount, cell / tilemapWindowChunkCount };
+		const glm::uvec2 extent = glm::uvec2(rect.max - rect.min) + 1u;
+		const VkDeviceSize offset = (static_cast<VkDeviceSize>(cell) * TILEMAP_LAYER_COUNT + layer) * tilemapCellLayerStagingSize;
+		uint16_t* dst = reinterpret_cast<uint16_t*>(static_cast<uint8_t*>(frame.tilemapStagingBuffer->mapped) + offset);
+		for (uint32_t y = 0; y < extent.y; y++) {
+			memcpy(&dst[y * extent.x], &chunk.tiles[layer][(rect.min.y + y) * TILEMAP_CHUNK_DIM + rect.min.x], extent.x * sizeof(uint16_t));
+		}
+		const uint32_t windowDim = tilemapWindowChunkCount * TILEMAP_CHUNK_DIM;
+		frame.tilemapImageCopies.push_back({
+			.bufferOffset = offset,
+			.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 },
+			.imageOffset = { static_cast<int32_t>(cellPos.x * TILEMAP_CHUNK_DIM) + rect.min.x, static_cast<int32_t>(layer * windowDim + cellPos.y * TILEMAP_CHUNK_DIM) + rect.min.y, 0 },
+			.imageExtent = { extent.x, extent.y, 1 }
+		});
+	}
+
+	// Brings the GPU copies of the tile map up to date with tiles changed by the game
+	// The tile index image only gets the dirty regions of the chunks it holds, but cached chunk instances are discarded and uploaded again to a new slot, as frames in flight may still read their current slot
+	void applyTilemapChanges(FrameObjects& frame) {
+		Game::Tilemap& tilemap = game.tilemap;
+		TilemapIndexImage& indexImage = tilemapIndexImage;
+		TilemapChunkCache& cache = tilemapChunkCache;
+		for (const glm::ivec2& position : tilemap.getDirtyChunks()) {
+			const uint64_t key = Game::Tilemap::chunkKey(position);
+			if (auto it = cache.chunkSlots.find(key); it != cache.chunkSlots.end()) {
+				cache.slots[it->second].used = false;
+				cache.chunkSlots.erase(it);
+			}
+			const glm::uvec2 cellPos = glm::uvec2(position) % tilemapWindowChunkCount;
+			const uint32_t cell = cellPos.y * tilemapWindowChunkCount + cellPos.x;
+			if (!indexImage.cellsValid[cell] || (indexImage.cellChunkKeys[cell] != key) || (indexImage.tilemapRevision != tilemap.getRevision())) {
+				continue;
+			}
+			// Chunks may have been evicted since they were changed, and the image is only written while it's used, so the cell is uploaded in full once it's needed again
+			const Game::TilemapChunk* chunk = tilemap.findChunk(position);
+			if (!chunk || !tilemapImage) {
+				indexImage.cellsValid[cell] = false;
+				continue;
+			}
+			for (uint32_t layer = 0; layer < TILEMAP_LAYER_COUNT; layer++) {
+				if (!chunk->dirty[layer].empty()) {
+					stageTilemapRegion(frame, *chunk, cell, layer, chunk->dirty[layer]);
+					indexImage.regionUploadCount++;
+				}
+			}
+		}
+		tilemap.clearDirtyRegions();
+	}
+
+	// Stages the tiles of chunks around the player that aren't in their cell of the tile index image yet, the copies are recorded with the frame's command buffer
+	// Frames without new or changed chunks don't touch the image at all
+	void updateTilemapIndexImage(FrameObjects& frame, glm::ivec2 currentTilePos) {
+		Game::Tilemap& tilemap = game.tilemap;
+		TilemapIndexImage& indexImage = tilemapIndexImage;
+
+		if (indexImage.tilemapRevision != tilemap.getRevision()) {
+			std::fill(indexImage.cellsValid.begin(), indexImage.cellsValid.end(), false);
+			indexImage.tilemapRevision = tilemap.getRevision();
+		}
+
+		// Same chunks as made resident by streamAround, as these are fewer than the window's cells per dimension, no two of them share a cell
+		const int32_t chunkDim = static_cast<int32_t>(TILEMAP_CHUNK_DIM);
+		const glm::ivec2 center = glm::ivec2(glm::floor(glm::vec2(currentTilePos) / static_cast<float>(chunkDim)));
+		for (int32_t cy = center.y - 1; cy <= center.y + 1; cy++) {
+			for (int32_t cx = center.x - 1; cx <= center.x + 1; cx++) {
+				// Chunks outside the map aren't resident
+				const Game::TilemapChunk* chunk = tilemap.findChunk({ cx, cy });
+				if (!chunk) {
+					continue;
+				}
+				const glm::uvec2 cellPos = glm::uvec2(cx, cy) % tilemapWindowChunkCount;
+				const uint32_t cell = cellPos.y * tilemapWindowChunkCount + cellPos.x;
+				const uint64_t key = Game::Tilemap::chunkKey(chunk->position);
+				if (indexImage.cellsValid[cell] && (indexImage.cellChunkKeys[cell] == key)) {
+					continue;
+				}
+				for (uint32_t layer = 0; layer < TILEMAP_LAYER_COUNT; layer++) {
+					stageTilemapRegion(frame, *chunk, cell, layer, { .min = glm::ivec2(0), .max = glm::ivec2(TILEMAP_CHUNK_DIM - 1) });
+				}
+				indexImage.cellChunkKeys[cell] = key;
+				indexImage.cellsValid[cell] = true;
+				indexImage.uploadCount++;
+			}
+		}
+		if (!frame.tilemapImageCopies.empty()) {
+			frame.tilemapStagingBuffer->flush();
+		}
+	}
+
+	// Player position interpolated between the last two simulation ticks, the camera follows this
+	glm::vec2 getPlayerPosition() const {
+		return glm::mix(game.player.previousPosition, game.player.position, game.getInterpolationFactor());
+	}
+
+	// Splits [0, count) of an entity category into chunks that are gathered by separate jobs
+	void addGatherChunks(std::vector<GatherChunk>& chunks, GatherCategory category, size_t count) {
+		for (size_t begin = 0; begin < count; begin += gatherGrainSize) {
+			chunks.push_back({ .category = category, .begin = begin, .end = std::min(begin + gatherGrainSize, count) });
+		}
+	}
+
+	// Gathers in two parallel passes: The first one counts the output elements of each chunk, an exclusive prefix sum over these counts
+	// then gives each chunk its output offset, so the second pass can write to the output from all jobs at once
+	// Output order is the same as for a serial gather
+	template<typename CountFunc, typename WriteFunc>
+	uint32_t parallelGather(std::vector<GatherChunk>& chunks, CountFunc countFunc, WriteFunc writeFunc) {
+		game.jobSystem.parallelFor(0, chunks.size(), 1, [&chunks, &countFunc](size_t begin, size_t end) {
+			for (size_t i = begin; i < end; i++) {
+				chunks[i].count = countFunc(chunks[i]);
+			}
+		});
+		uint32_t total{ 0 };
+		for (GatherChunk& chunk : chunks) {
+			chunk.offset = total;
+			total += chunk.count;
+		}
+		game.jobSystem.parallelFor(0, chunks.size(), 1, [&chunks, &writeFunc](size_t begin, size_t end) {
+			for (size_t i = begin; i < end; i++) {
+				writeFunc(chunks[i]);
+			}
+			vks::streaming::fence();
+		});
+		return total;
 	}
 
 	void updateInstanceBuffer(FrameObjects& frame) {
@@ -537,11 +1026,7 @@ public:
 		const int32_t minInstanceBufferCount = std::max(maxInstanceCount + instanceBufferBlockSizeIncrease - 1 - (maxInstanceCount + instanceBufferBlockSizeIncrease - 1) % instanceBufferBlockSizeIncrease, instanceBufferBlockSizeIncrease);
 		if (frame.instanceBufferMaxCount < minInstanceBufferCount) {
 			std::cout << "Resizing instance buffer for frame " << frame.index << " to " << minInstanceBufferCount << " elements\n";
-			// Host
-			delete[] frame.instances;
-			frame.instances = new InstanceData[minInstanceBufferCount];
-			// Device
-			delete frame.instanceBuffer;
+			VulkanContext::deletionQueue.retire(frame.instanceBuffer);
 			frame.instanceBuffer = new Buffer({
 				.usageFlags = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
 				.size = minInstanceBufferCount * sizeof(InstanceData),
@@ -559,95 +1044,327 @@ public:
 			frame.instanceBufferMaxCount = minInstanceBufferCount;
 		}
 
-		// Gather instances to be drawn
-		uint32_t instanceIndex{ 0 };
+		// Instances are written directly to the mapped (write-combined) device memory with ReBAR, or to the frame's staging memory without an intermediate host copy
+#if defined(USE_REBAR)
+		InstanceData* instances = static_cast<InstanceData*>(frame.instanceBuffer->mapped);
+#else
+		const StagingAllocation staging = stagingRing->allocate(maxInstanceCount * sizeof(InstanceData));
+		InstanceData* instances = static_cast<InstanceData*>(staging.data);
+#endif
 
-		// Monsters
-		for (auto i = 0; i < game.monsters.size(); i++) {
-			Game::Entities::Monster& monster = game.monsters[i];
-			if (monster.state == Game::Entities::State::Dead) {
-				continue;
-			}
-			InstanceData& instance = frame.instances[instanceIndex++];
-			instance.imageIndex = monster.imageIndex;
-			instance.pos = glm::vec3(monster.position, 0.0f);
-			instance.scale = monster.scale;
-			instance.effect = static_cast<uint32_t>(monster.effect);
-		}
+		// Positions are interpolated between the last two simulation ticks for smooth movement at any frame rate
+		const float alpha = game.getInterpolationFactor();
 
-		// Projectiles (@todo: maybe separate into own instance buffer due to diff. update frequency)
-		for (auto i = 0; i < game.projectiles.size(); i++) {
-			Game::Entities::Projectile& projectile = game.projectiles[i];
-			if (projectile.state == Game::Entities::State::Dead) {
-				continue;
-			}
-			InstanceData& instance = frame.instances[instanceIndex++];
-			instance.imageIndex = projectile.imageIndex;
-			instance.pos = glm::vec3(projectile.position, 0.0f);
-			instance.scale = projectile.scale;
-			instance.effect = static_cast<uint32_t>(projectile.effect);
-		}
+		std::vector<GatherChunk> chunks{};
+		addGatherChunks(chunks, GatherCategory::Monsters, game.monsters.size());
+		addGatherChunks(chunks, GatherCategory::Projectiles, game.projectiles.size());
+		addGatherChunks(chunks, GatherCategory::Pickups, game.pickups.size());
+		addGatherChunks(chunks, GatherCategory::Numbers, game.numbers.size());
 
-		// Pickups (@todo: maybe separate into own instance buffer due to diff. update frequency)
-		for (auto i = 0; i < game.pickups.size(); i++) {
-			Game::Entities::Pickup& pickup = game.pickups[i];
-			if (pickup.state == Game::Entities::State::Dead) {
-				continue;
-			}
-			InstanceData& instance = frame.instances[instanceIndex++];
-			instance.imageIndex = pickup.imageIndex;
-			instance.pos = glm::vec3(pickup.position, 0.0f);
-			instance.scale = pickup.scale;
-			instance.effect = static_cast<uint32_t>(pickup.effect);
-		}
+		const Game::Entities::MonsterStore& monsters = game.monsters;
 
-		// Numbers (@todo: maybe separate into own instance buffer due to diff. update frequency)
-		for (auto i = 0; i < game.numbers.size(); i++) {
-			Game::Entities::Number& number = game.numbers[i];
-			if (number.state == Game::Entities::State::Dead) {
-				continue;
+		auto countInstances = [&monsters](const GatherChunk& chunk) {
+			uint32_t count{ 0 };
+			switch (chunk.category) {
+			case GatherCategory::Monsters:
+				// Only visible monsters are drawn, dead monsters are always flagged as not visible
+				for (size_t i = chunk.begin; i < chunk.end; i++) {
+					count += monsters.visible[i] ? 1 : 0;
+				}
+				break;
+			case GatherCategory::Projectiles:
+				for (size_t i = chunk.begin; i < chunk.end; i++) {
+					count += game.projectiles[i].state != Game::Entities::State::Dead ? 1 : 0;
+				}
+				break;
+			case GatherCategory::Pickups:
+				for (size_t i = chunk.begin; i < chunk.end; i++) {
+					count += game.pickups[i].state != Game::Entities::State::Dead ? 1 : 0;
+				}
+				break;
+			case GatherCategory::Numbers:
+				// One instance per number digit
+				for (size_t i = chunk.begin; i < chunk.end; i++) {
+					count += game.numbers[i].state != Game::Entities::State::Dead ? game.numbers[i].digits : 0;
+				}
+				break;
 			}
-			// Draw one instance per number digit
-			for (auto i = 0; i < number.digits; i++) {
-				InstanceData& instance = frame.instances[instanceIndex++];
-				const char v = number.stringValue[i];
-				instance.imageIndex = game.firstNumberImageIndex + std::atoi(&v);
-				// @todo: center
-				instance.pos = glm::vec3(number.position + glm::vec2(i * number.scale * 0.6f, 0.0f), 0.0f);
-				instance.scale = number.scale;
-				instance.effect = static_cast<uint32_t>(number.effect);
+			return count;
+		};
+
+		auto writeInstances = [&monsters, instances, alpha](const GatherChunk& chunk) {
+			InstanceData* dst = instances + chunk.offset;
+			switch (chunk.category) {
+			case GatherCategory::Monsters:
+				for (size_t i = chunk.begin; i < chunk.end; i++) {
+					if (!monsters.visible[i]) {
+						continue;
+					}
+					vks::streaming::store(dst++, InstanceData{
+						.pos = glm::vec3(glm::mix(monsters.previousPosition[i], monsters.position[i], alpha), 0.0f),
+						.scale = monsters.scale[i],
+						.imageIndex = monsters.imageIndex[i],
+						.effect = static_cast<uint32_t>(monsters.effect[i])
+					});
+				}
+				break;
+			case GatherCategory::Projectiles:
+				// @todo: maybe separate into own instance buffer due to diff. update frequency
+				for (size_t i = chunk.begin; i < chunk.end; i++) {
+					const Game::Entities::Projectile& projectile = game.projectiles[i];
+					if (projectile.state == Game::Entities::State::Dead) {
+						continue;
+					}
+					vks::streaming::store(dst++, InstanceData{
+						.pos = glm::vec3(glm::mix(projectile.previousPosition, projectile.position, alpha), 0.0f),
+						.scale = projectile.scale,
+						.imageIndex = projectile.imageIndex,
+						.effect = static_cast<uint32_t>(projectile.effect)
+					});
+				}
+				break;
+			case GatherCategory::Pickups:
+				// @todo: maybe separate into own instance buffer due to diff. update frequency
+				for (size_t i = chunk.begin; i < chunk.end; i++) {
+					const Game::Entities::Pickup& pickup = game.pickups[i];
+					if (pickup.state == Game::Entities::State::Dead) {
+						continue;
+					}
+					vks::streaming::store(dst++, InstanceData{
+						.pos = glm::vec3(glm::mix(pickup.previousPosition, pickup.position, alpha), 0.0f),
+						.scale = pickup.scale,
+						.imageIndex = pickup.imageIndex,
+						.effect = static_cast<uint32_t>(pickup.effect)
+					});
+				}
+				break;
+			case GatherCategory::Numbers:
+				// @todo: maybe separate into own instance buffer due to diff. update frequency
+				for (size_t i = chunk.begin; i < chunk.end; i++) {
+					const Game::Entities::Number& number = game.numbers[i];
+					if (number.state == Game::Entities::State::Dead) {
+						continue;
+					}
+					const glm::vec2 numberPosition = glm::mix(number.previousPosition, number.position, alpha);
+					for (auto d = 0; d < number.digits; d++) {
+						const char v = number.stringValue[d];
+						vks::streaming::store(dst++, InstanceData{
+							// @todo: center
+							.pos = glm::vec3(numberPosition + glm::vec2(d * number.scale * 0.6f, 0.0f), 0.0f),
+							.scale = number.scale,
+							.imageIndex = game.firstNumberImageIndex + (v - '0'),
+							.effect = static_cast<uint32_t>(number.effect)
+						});
+					}
+				}
+				break;
 			}
-		}
+		};
+
+		const uint32_t instanceCount = parallelGather(chunks, countInstances, writeInstances);
 
 		// Player
-		frame.instances[instanceIndex] = {
-			.pos = glm::vec3(game.player.position, 0.0f),
+		vks::streaming::store(&instances[instanceCount], InstanceData{
+			.pos = glm::vec3(getPlayerPosition(), 0.0f),
 			.scale = game.player.scale,
 			.imageIndex = game.player.imageIndex,
 			.effect = static_cast<uint32_t>(game.player.effect)
-		};
+		});
+		vks::streaming::fence();
 
-		frame.instanceBufferDrawCount = instanceIndex + 1;
+		frame.instanceBufferDrawCount = instanceCount + 1;
 		
 		assert(frame.instanceBufferDrawCount > 0);
 
 		const size_t instanceBufferSize = frame.instanceBufferDrawCount * sizeof(InstanceData);
-#if defined(USE_REBAR)
-		memcpy(frame.instanceBuffer->mapped, &frame.instances[0], instanceBufferSize);
-#else
-		stagingBuffer->copyTo(frame.instances, instanceBufferSize);
-		if (!copyCommandBuffer) {
-			copyCommandBuffer = new CommandBuffer({ .device = *vulkanDevice, .pool = commandPool });
-		}
-		copyCommandBuffer->begin();
-		VkBufferCopy bufferCopy = { .size = instanceBufferSize };
-		vkCmdCopyBuffer(copyCommandBuffer->handle, stagingBuffer->buffer, frame.instanceBuffer->buffer, 1, &bufferCopy);
-		copyCommandBuffer->end();
-		copyCommandBuffer->oneTimeSubmit(queue);
+#if !defined(USE_REBAR)
+		stagingRing->copy(staging, frame.instanceBuffer->buffer, instanceBufferSize);
 #endif
 		frame.instanceBufferSize = instanceBufferSize;
 	}
 
+	// GPU culling path: Writes the raw state of all live sprites directly into host visible memory, gathered in parallel with streaming stores
+	// Visibility, interpolation and compaction into the instance buffer are done by the culling compute shader
+	void updateSpriteBuffer(FrameObjects& frame) {
+		const uint32_t maxSpriteCount =
+			static_cast<uint32_t>(game.monsters.size()) +
+			static_cast<uint32_t>(game.projectiles.size()) +
+			static_cast<uint32_t>(game.pickups.size()) +
+			// @todo: Max. 3 digits per number for now
+			(static_cast<uint32_t>(game.numbers.size()) * 3) +
+			1;
+
+		// Same chunked resizing as the instance buffer
+		const int32_t minSpriteBufferCount = std::max(maxSpriteCount + instanceBufferBlockSizeIncrease - 1 - (maxSpriteCount + instanceBufferBlockSizeIncrease - 1) % instanceBufferBlockSizeIncrease, instanceBufferBlockSizeIncrease);
+		if (frame.spriteBufferMaxCount < minSpriteBufferCount) {
+			std::cout << "Resizing sprite buffers for frame " << frame.index << " to " << minSpriteBufferCount << " elements\n";
+			VulkanContext::deletionQueue.retire(frame.spriteBuffer);
+			VulkanContext::deletionQueue.retire(frame.culledInstanceBuffer);
+			VulkanContext::deletionQueue.retire(frame.cullingGroupOffsetsBuffer);
+			// Always host visible (device local with ReBAR), only read once by the culling shader
+			frame.spriteBuffer = new Buffer({
+				.usageFlags = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+				.size = minSpriteBufferCount * sizeof(SpriteData),
+				.map = true,
+			});
+			frame.culledInstanceBuffer = new Buffer({
+				.usageFlags = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+				.size = minSpriteBufferCount * sizeof(InstanceData),
+			});
+			frame.cullingGroupOffsetsBuffer = new Buffer({
+				.usageFlags = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+				.size = (minSpriteBufferCount + cullingGroupSize - 1) / cullingGroupSize * sizeof(uint32_t),
+			});
+			frame.spriteBufferMaxCount = minSpriteBufferCount;
+		}
+		if (!frame.indirectDrawBuffer) {
+			frame.indirectDrawBuffer = new Buffer({
+				.usageFlags = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+				.size = sizeof(VkDrawIndirectCommand),
+			});
+		}
+
+		SpriteData* sprites = static_cast<SpriteData*>(frame.spriteBuffer->mapped);
+
+		// Gathered in parallel like the instance buffer, sprites are stored in the same order as the CPU path's instances
+		std::vector<GatherChunk> chunks{};
+		addGatherChunks(chunks, GatherCategory::Monsters, game.monsters.size());
+		addGatherChunks(chunks, GatherCategory::Projectiles, game.projectiles.size());
+		addGatherChunks(chunks, GatherCategory::Pickups, game.pickups.size());
+		addGatherChunks(chunks, GatherCategory::Numbers, game.numbers.size());
+
+		const Game::Entities::MonsterStore& monsters = game.monsters;
+
+		auto countSprites = [&monsters](const GatherChunk& chunk) {
+			uint32_t count{ 0 };
+			switch (chunk.category) {
+			case GatherCategory::Monsters:
+				// Unlike the CPU path all live monsters are passed, the compute shader does exact culling against the visible area
+				for (size_t i = chunk.begin; i < chunk.end; i++) {
+					count += monsters.state[i] != Game::Entities::State::Dead ? 1 : 0;
+				}
+				break;
+			case GatherCategory::Projectiles:
+				for (size_t i = chunk.begin; i < chunk.end; i++) {
+					count += game.projectiles[i].state != Game::Entities::State::Dead ? 1 : 0;
+				}
+				break;
+			case GatherCategory::Pickups:
+				for (size_t i = chunk.begin; i < chunk.end; i++) {
+					count += game.pickups[i].state != Game::Entities::State::Dead ? 1 : 0;
+				}
+				break;
+			case GatherCategory::Numbers:
+				// One sprite per number digit
+				for (size_t i = chunk.begin; i < chunk.end; i++) {
+					count += game.numbers[i].state != Game::Entities::State::Dead ? game.numbers[i].digits : 0;
+				}
+				break;
+			}
+			return count;
+		};
+
+		auto writeSprites = [&monsters, sprites](const GatherChunk& chunk) {
+			SpriteData* dst = sprites + chunk.offset;
+			switch (chunk.category) {
+			case GatherCategory::Monsters:
+				for (size_t i = chunk.begin; i < chunk.end; i++) {
+					if (monsters.state[i] == Game::Entities::State::Dead) {
+						continue;
+					}
+					vks::streaming::store(dst++, SpriteData{
+						.position = monsters.position[i],
+						.previousPosition = monsters.previousPosition[i],
+						.scale = monsters.scale[i],
+						.imageIndex = monsters.imageIndex[i],
+						.effect = static_cast<uint32_t>(monsters.effect[i])
+					});
+				}
+				break;
+			case GatherCategory::Projectiles:
+				for (size_t i = chunk.begin; i < chunk.end; i++) {
+					const Game::Entities::Projectile& projectile = game.projectiles[i];
+					if (projectile.state == Game::Entities::State::Dead) {
+						continue;
+					}
+					vks::streaming::store(dst++, SpriteData{
+						.position = projectile.position,
+						.previousPosition = projectile.previousPosition,
+						.scale = projectile.scale,
+						.imageIndex = projectile.imageIndex,
+						.effect = static_cast<uint32_t>(projectile.effect)
+					});
+				}
+				break;
+			case GatherCategory::Pickups:
+				for (size_t i = chunk.begin; i < chunk.end; i++) {
+					const Game::Entities::Pickup& pickup = game.pickups[i];
+					if (pickup.state == Game::Entities::State::Dead) {
+						continue;
+					}
+					vks::streaming::store(dst++, SpriteData{
+						.position = pickup.position,
+						.previousPosition = pickup.previousPosition,
+						.scale = pickup.scale,
+						.imageIndex = pickup.imageIndex,
+						.effect = static_cast<uint32_t>(pickup.effect)
+					});
+				}
+				break;
+			case GatherCategory::Numbers:
+				for (size_t i = chunk.begin; i < chunk.end; i++) {
+					const Game::Entities::Number& number = game.numbers[i];
+					if (number.state == Game::Entities::State::Dead) {
+						continue;
+					}
+					for (auto d = 0; d < number.digits; d++) {
+						const char v = number.stringValue[d];
+						const glm::vec2 offset = glm::vec2(d * number.scale * 0.6f, 0.0f);
+						vks::streaming::store(dst++, SpriteData{
+							.position = number.position + offset,
+							.previousPosition = number.previousPosition + offset,
+							.scale = number.scale,
+							.imageIndex = game.firstNumberImageIndex + (v - '0'),
+							.effect = static_cast<uint32_t>(number.effect)
+						});
+					}
+				}
+				break;
+			}
+		};
+
+		frame.spriteCount = parallelGather(chunks, countSprites, writeSprites);
+
+		// Player is stored after all other sprites and never culled
+		vks::streaming::store(&sprites[frame.spriteCount], SpriteData{
+			.position = game.player.position,
+			.previousPosition = game.player.previousPosition,
+			.scale = game.player.scale,
+			.imageIndex = game.player.imageIndex,
+			.effect = static_cast<uint32_t>(game.player.effect)
+		});
+		vks::streaming::fence();
+
+		if (!frame.descriptorSetCulling) {
+			frame.descriptorSetCulling = new DescriptorSet({
+				.pool = descriptorPool,
+				.layouts = { descriptorSetLayoutCulling->handle },
+				.descriptors = {
+					{.dstBinding = 0, .descriptorCount = 1, .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, .pBufferInfo = &frame.uniformBuffer->descriptor },
+					{.dstBinding = 1, .descriptorCount = 1, .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, .pBufferInfo = &frame.spriteBuffer->descriptor },
+					{.dstBinding = 2, .descriptorCount = 1, .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, .pBufferInfo = &frame.culledInstanceBuffer->descriptor },
+					{.dstBinding = 3, .descriptorCount = 1, .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, .pBufferInfo = &frame.indirectDrawBuffer->descriptor },
+					{.dstBinding = 4, .descriptorCount = 1, .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, .pBufferInfo = &frame.cullingGroupOffsetsBuffer->descriptor },
+				}
+			});
+		}
+		else {
+			frame.descriptorSetCulling->updateDescriptor(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, &frame.spriteBuffer->descriptor);
+			frame.descriptorSetCulling->updateDescriptor(2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, &frame.culledInstanceBuffer->descriptor);
+			frame.descriptorSetCulling->updateDescriptor(4, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, &frame.cullingGroupOffsetsBuffer->descriptor);
+		}
+	}
+
 	void updateLightsBuffer(FrameObjects& frame)
 	{
 		const uint32_t maxLightsCount =
@@ -659,11 +1376,7 @@ public:
 		const int32_t minLightBufferCount = std::max(maxLightsCount + instanceBufferBlockSizeIncrease - 1 - (maxLightsCount + instanceBufferBlockSizeIncrease - 1) % instanceBufferBlockSizeIncrease, instanceBufferBlockSizeIncrease);
 		if (frame.lightsBufferMaxCount < minLightBufferCount) {
 			std::cout << "Resizing lights buffer for frame " << frame.index << " to " << minLightBufferCount << " elements\n";
-			// Host
-			delete[] frame.lights;
-			frame.lights = new LightSource[minLightBufferCount];
-			// Device
-			delete frame.lightsBuffer;
+			VulkanContext::deletionQueue.retire(frame.lightsBuffer);
 			frame.lightsBuffer = new Buffer({
 				.usageFlags = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
 				.size = minLightBufferCount * sizeof(LightSource),
@@ -681,68 +1394,163 @@ public:
 			frame.lightsBufferMaxCount = minLightBufferCount;
 		}
 
-		// Gather lights to be drawn
-		uint32_t lightIndex{ 0 };
+		// Same as for instances, lights are written directly to mapped device or staging memory
+#if defined(USE_REBAR)
+		LightSource* lights = static_cast<LightSource*>(frame.lightsBuffer->mapped);
+#else
+		const StagingAllocation staging = stagingRing->allocate(maxLightsCount * sizeof(LightSource));
+		LightSource* lights = static_cast<LightSource*>(staging.data);
+#endif
+
+		const float alpha = game.getInterpolationFactor();
+		const glm::vec2 playerPosition = getPlayerPosition();
 
 		// Post process uses a different aspect ratio than internal rendering, which needs to be taken into account
-		float postProcessAR = (float)width / ((float)height * 4.0f / 3.0f);
+		const float postProcessAR = (float)width / ((float)height * 4.0f / 3.0f);
+		const glm::vec2 screenDim = this->screenDim;
 
 		// Projectiles (@todo: maybe separate into own light buffer due to diff. update frequency)
-		for (auto i = 0; i < game.projectiles.size(); i++) {
-			Game::Entities::Projectile& projectile = game.projectiles[i];
-			if (projectile.state == Game::Entities::State::Dead) {
-				continue;
+		std::vector<GatherChunk> chunks{};
+		addGatherChunks(chunks, GatherCategory::Projectiles, game.projectiles.size());
+
+		auto countLights = [](const GatherChunk& chunk) {
+			uint32_t count{ 0 };
+			for (size_t i = chunk.begin; i < chunk.end; i++) {
+				count += game.projectiles[i].state != Game::Entities::State::Dead ? 1 : 0;
 			}
-			// Must be relative to the player (which in turn is centered on the screen)
-			glm::vec2 lPos = projectile.position - game.player.position;
-			lPos /= (screenDim * 2.0f);
-			lPos.x /= postProcessAR;
-			lPos += 0.5;
-			frame.lights[lightIndex++] = {
-				.pos = lPos,
-				.color = projectile.lightColor,
-				.radius = 0.04f,
-			};
-		}
+			return count;
+		};
+
+		auto writeLights = [lights, alpha, playerPosition, postProcessAR, screenDim](const GatherChunk& chunk) {
+			LightSource* dst = lights + chunk.offset;
+			for (size_t i = chunk.begin; i < chunk.end; i++) {
+				const Game::Entities::Projectile& projectile = game.projectiles[i];
+				if (projectile.state == Game::Entities::State::Dead) {
+					continue;
+				}
+				// Must be relative to the player (which in turn is centered on the screen)
+				glm::vec2 lPos = glm::mix(projectile.previousPosition, projectile.position, alpha) - playerPosition;
+				lPos /= (screenDim * 2.0f);
+				lPos.x /= postProcessAR;
+				lPos += 0.5;
+				vks::streaming::store(dst++, LightSource{
+					.pos = lPos,
+					.color = projectile.lightColor,
+					.radius = 0.04f,
+				});
+			}
+		};
+
+		const uint32_t lightCount = parallelGather(chunks, countLights, writeLights);
 
 		// Player
-		frame.lights[lightIndex++] = {
+		vks::streaming::store(&lights[lightCount], LightSource{
 			.pos = glm::vec2(0.5),
 			.color = glm::vec3(1.0f),
 			.radius = 0.2f,
-		};
+		});
+		vks::streaming::fence();
 
-		frame.lightsBufferDrawCount = lightIndex;
+		frame.lightsBufferDrawCount = lightCount + 1;
+
+		if (validateLightTiles) {
+			frame.lightTileValidation.lights.assign(lights, lights + frame.lightsBufferDrawCount);
+		}
 
 		assert(frame.lightsBufferDrawCount > 0);
 
 		const size_t lightBufferSize = frame.lightsBufferDrawCount * sizeof(LightSource);
-#if defined(USE_REBAR)
-		memcpy(frame.lightsBuffer->mapped, &frame.lights[0], lightBufferSize);
-#else
-		stagingBuffer->copyTo(frame.lights, lightsBufferSize);
-		if (!copyCommandBuffer) {
-			copyCommandBuffer = new CommandBuffer({ .device = *vulkanDevice, .pool = commandPool });
-		}
-		copyCommandBuffer->begin();
-		VkBufferCopy bufferCopy = { .size = lightBufferSize };
-		vkCmdCopyBuffer(copyCommandBuffer->handle, stagingBuffer->buffer, frame.lightsBuffer->buffer, 1, &bufferCopy);
-		copyCommandBuffer->end();
-		copyCommandBuffer->oneTimeSubmit(queue);
+#if !defined(USE_REBAR)
+		stagingRing->copy(staging, frame.lightsBuffer->buffer, lightBufferSize);
 #endif
 		frame.lightsBufferSize = lightBufferSize;		
 
+		updateLightTileBuffers(frame);
+
 		if (!frame.descriptorSetLights) {
 			frame.descriptorSetLights = new DescriptorSet({
 				.pool = descriptorPool,
 				.layouts = { descriptorSetLayoutLights->handle },
 				.descriptors = {
-					{.dstBinding = 0, .descriptorCount = 1, .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, .pBufferInfo = &frame.lightsBuffer->descriptor }
+					{.dstBinding = 0, .descriptorCount = 1, .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, .pBufferInfo = &frame.lightsBuffer->descriptor },
+					{.dstBinding = 1, .descriptorCount = 1, .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, .pBufferInfo = &frame.tileLightCountsBuffer->descriptor },
+					{.dstBinding = 2, .descriptorCount = 1, .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, .pBufferInfo = &frame.tileLightIndicesBuffer->descriptor }
+				}
+			});
+			frame.descriptorSetLightCulling = new DescriptorSet({
+				.pool = descriptorPool,
+				.layouts = { descriptorSetLayoutLightCulling->handle },
+				.descriptors = {
+					{.dstBinding = 0, .descriptorCount = 1, .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, .pBufferInfo = &frame.uniformBuffer->descriptor },
+					{.dstBinding = 1, .descriptorCount = 1, .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, .pBufferInfo = &frame.lightsBuffer->descriptor },
+					{.dstBinding = 2, .descriptorCount = 1, .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, .pBufferInfo = &frame.tileLightCountsBuffer->descriptor },
+					{.dstBinding = 3, .descriptorCount = 1, .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, .pBufferInfo = &frame.tileLightIndicesBuffer->descriptor }
 				}
 			});
 		}
 		else {
 			frame.descriptorSetLights->updateDescriptor(0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, &frame.lightsBuffer->descriptor);
+			frame.descriptorSetLights->updateDescriptor(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, &frame.tileLightCountsBuffer->descriptor);
+			frame.descriptorSetLights->updateDescriptor(2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, &frame.tileLightIndicesBuffer->descriptor);
+			frame.descriptorSetLightCulling->updateDescriptor(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, &frame.lightsBuffer->descriptor);
+			frame.descriptorSetLightCulling->updateDescriptor(2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, &frame.tileLightCountsBuffer->descriptor);
+			frame.descriptorSetLightCulling->updateDescriptor(3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, &frame.tileLightIndicesBuffer->descriptor);
+		}
+	}
+
+	glm::uvec2 getLightTileCount() const
+	{
+		return glm::uvec2((width + lightTileSize - 1) / lightTileSize, (height + lightTileSize - 1) / lightTileSize);
+	}
+
+	// Per-tile light counts and index lists written by the light culling compute shader, these only grow (e.g. when the window is resized)
+	void updateLightTileBuffers(FrameObjects& frame)
+	{
+		const glm::uvec2 tileCount = getLightTileCount();
+		const uint32_t minTileCount = tileCount.x * tileCount.y;
+		if (frame.lightTileMaxCount >= minTileCount) {
+			return;
+		}
+		std::cout << "Resizing light tile buffers for frame " << frame.index << " to " << tileCount.x << " x " << tileCount.y << " tiles\n";
+		VulkanContext::deletionQueue.retire(frame.tileLightCountsBuffer);
+		VulkanContext::deletionQueue.retire(frame.tileLightIndicesBuffer);
+		// Validation reads the tiles back on the host
+		const uint32_t vmaAllocFlags = validateLightTiles ? VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT : 0;
+		frame.tileLightCountsBuffer = new Buffer({
+			.name = "Light tile counts",
+			.usageFlags = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+			.size = minTileCount * sizeof(uint32_t),
+			.vmaAllocFlags = vmaAllocFlags,
+			.map = validateLightTiles
+		});
+		frame.tileLightIndicesBuffer = new Buffer({
+			.name = "Light tile indices",
+			.usageFlags = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+			.size = static_cast<VkDeviceSize>(minTileCount) * maxLightsPerTile * sizeof(uint32_t),
+			.vmaAllocFlags = vmaAllocFlags,
+			.map = validateLightTiles
+		});
+		frame.lightTileMaxCount = minTileCount;
+	}
+
+	// Compares the light tiles the GPU binned for the last submission of this frame against the CPU reference, needs to be called after that submission has finished
+	void validateLightTileFrame(FrameObjects& frame)
+	{
+		FrameObjects::LightTileValidation& validation = frame.lightTileValidation;
+		if (!validation.pending) {
+			return;
+		}
+		validation.pending = false;
+		frame.tileLightCountsBuffer->invalidate();
+		frame.tileLightIndicesBuffer->invalidate();
+		const uint32_t* counts = static_cast<const uint32_t*>(frame.tileLightCountsBuffer->mapped);
+		const uint32_t* indices = static_cast<const uint32_t*>(frame.tileLightIndicesBuffer->mapped);
+		const uint32_t lightCount = static_cast<uint32_t>(validation.lights.size());
+		const uint32_t mismatches = countLightTileMismatches(counts, indices, validation.lights.data(), lightCount, validation.tileCount, validation.screenRes, validation.viewportAR);
+		validatedLightTileFrames++;
+		if (mismatches > 0) {
+			failedLightTileFrames++;
+			std::cerr << "Light tile validation failed: " << mismatches << " of " << validation.tileCount.x * validation.tileCount.y << " tiles don't match the CPU reference\n";
 		}
 	}
 
@@ -782,7 +1590,7 @@ public:
 		const size_t vertexBufferSize = v.size() * sizeof(Vertex);
 
 		if (frame.uiBufferSize < vertexBufferSize) {
-			delete frame.uiBuffer;
+			VulkanContext::deletionQueue.retire(frame.uiBuffer);
 			frame.uiBuffer = new Buffer({
 				.usageFlags = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
 				.size = vertexBufferSize,
@@ -796,19 +1604,68 @@ public:
 #if defined(USE_REBAR)
 		memcpy(frame.uiBuffer->mapped, v.data(), vertexBufferSize);
 #else
-		// todo
+		stagingRing->upload(v.data(), frame.uiBuffer->buffer, vertexBufferSize);
 #endif
 	}
 
+	void printPipelineBatchTimings(const PipelineBatchTimings& timings, uint32_t cacheHits, uint32_t cacheMisses)
+	{
+		std::cout << "\tPipelines: " << timings.total << " ms for " << pipelineList.size() << " pipelines on " << game.jobSystem.getThreadCount() << " threads\n";
+		std::cout << "\t\tShader compilation (all threads): " << timings.shaderCompilation << " ms (cache hits: " << cacheHits << ", misses: " << cacheMisses << ")\n";
+		std::cout << "\t\tPipeline creation (all threads): " << timings.pipelineCreation << " ms\n";
+		std::cout << "\t\tPipeline cache merge: " << timings.cacheMerge << " ms\n";
+	}
+
+	// Creates all pipelines of the application twice: Once with empty caches (cold start) and once from the caches filled by the first pass (warm start)
+	// Uses its own cache directory and pipeline cache, so the results don't depend on (and don't change) the application's caches
+	// Drivers may keep caches of their own, which can make the cold pass faster than an actual first start
+	void runStartupBenchmark()
+	{
+		const std::string applicationCacheDirectory = slangCompiler->cacheDirectory;
+		const std::string benchmarkCacheDirectory = (cachePath.empty() ? std::string("cache/") : cachePath) + "startupbenchmark/";
+		std::error_code error;
+		std::filesystem::remove_all(benchmarkCacheDirectory, error);
+		slangCompiler->cacheDirectory = benchmarkCacheDirectory + "shaders/";
+
+		VkPipelineCacheCreateInfo pipelineCacheCreateInfo{ .sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO };
+		VkPipelineCache benchmarkPipelineCache{ VK_NULL_HANDLE };
+		VK_CHECK_RESULT(vkCreatePipelineCache(VulkanContext::device->logicalDevice, &pipelineCacheCreateInfo, nullptr, &benchmarkPipelineCache));
+
+		double passTimes[2]{};
+		for (uint32_t pass = 0; pass < 2; pass++) {
+			const uint32_t cacheHits = slangCompiler->cacheHits;
+			const uint32_t cacheMisses = slangCompiler->cacheMisses;
+			PipelineBatch batch({ .cache = benchmarkPipelineCache });
+			std::vector<Pipeline*> benchmarkPipelines{};
+			for (auto& pipeline : pipelineList) {
+				benchmarkPipelines.push_back(batch.add(*pipeline->initialCreateInfo));
+			}
+			batch.build(game.jobSystem);
+			std::cout << ((pass == 0) ? "Cold start (empty caches):\n" : "Warm start (cached shaders and pipeline data):\n");
+			printPipelineBatchTimings(batch.timings, slangCompiler->cacheHits - cacheHits, slangCompiler->cacheMisses - cacheMisses);
+			passTimes[pass] = batch.timings.total;
+			for (auto& pipeline : benchmarkPipelines) {
+				delete pipeline;
+			}
+		}
+		std::cout << "Warm start pipeline creation is " << passTimes[0] / passTimes[1] << "x faster than a cold start\n";
+
+		vkDestroyPipelineCache(VulkanContext::device->logicalDevice, benchmarkPipelineCache, nullptr);
+		std::filesystem::remove_all(benchmarkCacheDirectory, error);
+		slangCompiler->cacheDirectory = applicationCacheDirectory;
+	}
+
 	void prepare() {
+		const auto tStartup = std::chrono::high_resolution_clock::now();
 		VulkanApplication::prepare();
 
-		// Create one large staging buffer to be reused for copies
-		stagingBuffer = new Buffer({
-			.usageFlags = VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-			.size = stagingBufferSize,
-			.map = true
+#if !defined(USE_REBAR)
+		stagingRing = new StagingRing({
+			.name = "Frame staging buffer",
+			.frameCount = getFrameCount(),
+			.size = 4 * 1024 * 1024
 		});
+#endif
 
 		fileWatcher = new FileWatcher();
 
@@ -817,21 +1674,20 @@ public:
 		loadAssets();
 		generateQuad();
 		createTileMap();
-
-		// Init player
-		auto& player = game.player;
-		player.speed = 5.0f;
-		player.scale = 1.0f;
-		player.position = glm::vec2((float)game.tilemap.width / 2.0f, (float)game.tilemap.height / 2.0f);
-		// @todo
-		//game.player.position = glm::vec2(0.0f);
-		// @todo: Proper weapon setup/selection
-		player.weapons.resize(1);
-		player.weapons[0] = game.playerWeaponTypes[1];
+		const auto tAssets = std::chrono::high_resolution_clock::now();
 
 		// @todo: for benchmarking, this is > 60 fps on my setup
-		//spawnMonsters(1150000);
-		game.spawnMonsters(game.spawnTriggerMonsterCount);
+		//game.start(1150000);
+		const uint32_t initialMonsterCount = playbackReplay ? replay.initialMonsterCount : game.spawnTriggerMonsterCount;
+		game.start(initialMonsterCount);
+		if (recordReplay) {
+			replay.seed = game.getSeed();
+			replay.initialMonsterCount = initialMonsterCount;
+			replay.tickDuration = game.tickDuration;
+			replay.mapWidth = game.tilemap.width;
+			replay.mapHeight = game.tilemap.height;
+			replay.waterSpreadInterval = game.waterSpreadInterval;
+		}
 
 		// @todo: move camera out of vulkanapplication (so we can have multiple cameras)
 		camera.type = Camera::CameraType::firstperson;
@@ -855,11 +1711,11 @@ public:
 			.maxSets = 32,
 //			.maxSets = getFrameCount() + 2,
 			.poolSizes = {
-				{.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, .descriptorCount = 8 /*getFrameCount()*/ },
+				{.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, .descriptorCount = 16 /*getFrameCount() * 2*/ },
 				{.type = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, .descriptorCount = 4096 /*@todo*/},
 				{.type = VK_DESCRIPTOR_TYPE_SAMPLER, .descriptorCount = 256 /*@todo*/},
 				{.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, .descriptorCount = 4 /*@todo*/},
-				{.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, .descriptorCount = 4 /*@todo*/},
+				{.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, .descriptorCount = 64 /*@todo*/},
 			}
 		});
 
@@ -879,12 +1735,58 @@ public:
 			});
 		}
 
+		// Lights and the per-tile light lists
 		descriptorSetLayoutLights = new DescriptorSetLayout({
 			.bindings = {
 				{ .binding = 0, .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, .descriptorCount = 1, .stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT },
+				{ .binding = 1, .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, .descriptorCount = 1, .stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT },
+				{ .binding = 2, .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, .descriptorCount = 1, .stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT },
+			}
+		});
+
+		descriptorSetLayoutLightCulling = new DescriptorSetLayout({
+			.bindings = {
+				{ .binding = 0, .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, .descriptorCount = 1, .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT },
+				{ .binding = 1, .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, .descriptorCount = 1, .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT },
+				{ .binding = 2, .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, .descriptorCount = 1, .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT },
+				{ .binding = 3, .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, .descriptorCount = 1, .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT },
 			}
 		});
 		
+		descriptorSetLayoutCulling = new DescriptorSetLayout({
+			.bindings = {
+				{ .binding = 0, .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, .descriptorCount = 1, .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT },
+				{ .binding = 1, .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, .descriptorCount = 1, .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT },
+				{ .binding = 2, .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, .descriptorCount = 1, .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT },
+				{ .binding = 3, .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, .descriptorCount = 1, .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT },
+				{ .binding = 4, .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, .descriptorCount = 1, .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT },
+			}
+		});
+
+		// Images have been decoding in the background since loadAssets
+		assetLoader->finish();
+		delete assetLoader;
+		assetLoader = nullptr;
+
+		// Needs to be part of the texture descriptor set
+		createTilemapIndexImage();
+
+		descriptorSetLayoutSpriteAtlas = new DescriptorSetLayout({
+			.bindings = {
+				{ .binding = 0, .descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, .descriptorCount = 1, .stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT },
+				{ .binding = 1, .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, .descriptorCount = 1, .stageFlags = VK_SHADER_STAGE_VERTEX_BIT },
+			}
+		});
+
+		descriptorSetSpriteAtlas = new DescriptorSet({
+			.pool = descriptorPool,
+			.layouts = { descriptorSetLayoutSpriteAtlas->handle },
+			.descriptors = {
+				{.dstBinding = 0, .descriptorCount = 1, .descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, .pImageInfo = &spriteAtlas->texture->descriptor },
+				{.dstBinding = 1, .descriptorCount = 1, .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, .pBufferInfo = &spriteAtlas->rectBuffer->descriptor },
+			}
+		});
+
 		updateTextureDescriptor();
 
 		VkPipelineRenderingCreateInfo pipelineRenderingCreateInfo{
@@ -899,10 +1801,13 @@ public:
 			.colorWriteMask = 0xf
 		};
 
+		// All pipelines are created in parallel once they have been added to the batch
+		PipelineBatch pipelineBatch({ .cache = pipelineCache });
+
 		// Sprites
 
 		pipelineLayouts["sprite"] = new PipelineLayout({
-			.layouts = { descriptorSetLayoutTextures->handle, descriptorSetLayoutSamplers->handle, descriptorSetLayoutUniforms->handle },
+			.layouts = { descriptorSetLayoutTextures->handle, descriptorSetLayoutSamplers->handle, descriptorSetLayoutUniforms->handle, descriptorSetLayoutSpriteAtlas->handle },
 		});
 
 		PipelineVertexInput vertexInput = {
@@ -921,7 +1826,7 @@ public:
 			}
 		};
 
-		pipelines["sprite"] = new Pipeline({
+		pipelines["sprite"] = pipelineBatch.add({
 			.shaders = {
 				.filename = getAssetPath() + "shaders/sprite.slang",
 				.stages = { VK_SHADER_STAGE_VERTEX_BIT, VK_SHADER_STAGE_FRAGMENT_BIT }
@@ -967,6 +1872,43 @@ public:
 		});
  		pipelineList.push_back(pipelines["sprite"]);
 
+		// Sprite culling (compute)
+		pipelineLayouts["cull"] = new PipelineLayout({
+			.layouts = { descriptorSetLayoutCulling->handle },
+			.pushConstantRanges = {
+				{.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT, .offset = 0, .size = sizeof(CullingPushConsts) }
+			}
+		});
+
+		pipelines["cull"] = pipelineBatch.add({
+			.bindPoint = VK_PIPELINE_BIND_POINT_COMPUTE,
+			.shaders = {
+				.filename = getAssetPath() + "shaders/cull.slang",
+				.stages = { VK_SHADER_STAGE_COMPUTE_BIT }
+			},
+			.cache = pipelineCache,
+			.layout = *pipelineLayouts["cull"],
+			.enableHotReload = true
+		});
+		pipelineList.push_back(pipelines["cull"]);
+
+		// Light culling (compute)
+		pipelineLayouts["lightcull"] = new PipelineLayout({
+			.layouts = { descriptorSetLayoutLightCulling->handle }
+		});
+
+		pipelines["lightcull"] = pipelineBatch.add({
+			.bindPoint = VK_PIPELINE_BIND_POINT_COMPUTE,
+			.shaders = {
+				.filename = getAssetPath() + "shaders/lightcull.slang",
+				.stages = { VK_SHADER_STAGE_COMPUTE_BIT }
+			},
+			.cache = pipelineCache,
+			.layout = *pipelineLayouts["lightcull"],
+			.enableHotReload = true
+		});
+		pipelineList.push_back(pipelines["lightcull"]);
+
 		// Tilemap
 		pipelineLayouts["tilemap"] = new PipelineLayout({
 			.layouts = { descriptorSetLayoutTextures->handle, descriptorSetLayoutSamplers->handle, descriptorSetLayoutUniforms->handle },
@@ -976,7 +1918,7 @@ public:
 			}
 		});
 
-		pipelines["tilemap"] = new Pipeline({
+		pipelines["tilemap"] = pipelineBatch.add({
 			.shaders = {
 				.filename = getAssetPath() + "shaders/tilemap.slang",
 				.stages = { VK_SHADER_STAGE_VERTEX_BIT, VK_SHADER_STAGE_FRAGMENT_BIT }
@@ -1040,12 +1982,12 @@ public:
 				{.location = 0, .binding = 0, .format = VK_FORMAT_R32G32B32_SFLOAT, .offset = offsetof(Vertex, pos) },
 				{.location = 1, .binding = 0, .format = VK_FORMAT_R32G32_SFLOAT, .offset = offsetof(Vertex, uv) },
 				// Instanced
-				{.location = 2, .binding = 1, .format = VK_FORMAT_R32G32B32_SFLOAT, .offset = offsetof(TilemapInstanceData, pos) },
-				{.location = 3, .binding = 1, .format = VK_FORMAT_R32_SINT, .offset = offsetof(TilemapInstanceData, imageIndex) },
+				{.location = 2, .binding = 1, .format = VK_FORMAT_R32G32_SINT, .offset = offsetof(TilemapInstanceData, pos) },
+				{.location = 3, .binding = 1, .format = VK_FORMAT_R32G32B32_SINT, .offset = offsetof(TilemapInstanceData, imageIndices) },
 			}
 		};
 
-		pipelines["tilemap-naive"] = new Pipeline({
+		pipelines["tilemap-naive"] = pipelineBatch.add({
 			.shaders = {
 				.filename = getAssetPath() + "shaders/tilemap-naive.slang",
 				.stages = { VK_SHADER_STAGE_VERTEX_BIT, VK_SHADER_STAGE_FRAGMENT_BIT }
@@ -1110,7 +2052,7 @@ public:
 			}
 		});
 
-		pipelines["crtframe"] = new Pipeline({
+		pipelines["crtframe"] = pipelineBatch.add({
 			.shaders = {
 				.filename = getAssetPath() + "shaders/frame.slang",
 				.stages = { VK_SHADER_STAGE_VERTEX_BIT, VK_SHADER_STAGE_FRAGMENT_BIT }
@@ -1174,7 +2116,7 @@ public:
 			}
 		});
 
-		pipelines["gameui"] = new Pipeline({
+		pipelines["gameui"] = pipelineBatch.add({
 			.shaders = {
 				.filename = getAssetPath() + "shaders/ui.slang",
 				.stages = { VK_SHADER_STAGE_VERTEX_BIT, VK_SHADER_STAGE_FRAGMENT_BIT }
@@ -1259,7 +2201,7 @@ public:
 			}
 		});
 
-		pipelines["postprocess"] = new Pipeline({
+		pipelines["postprocess"] = pipelineBatch.add({
 			.shaders = {
 				.filename = getAssetPath() + "shaders/postprocess.slang",
 				.stages = { VK_SHADER_STAGE_VERTEX_BIT, VK_SHADER_STAGE_FRAGMENT_BIT }
@@ -1305,6 +2247,24 @@ public:
 		});
 		pipelineList.push_back(pipelines["postprocess"]);
 
+		pipelineBatch.build(game.jobSystem);
+		const auto tPipelines = std::chrono::high_resolution_clock::now();
+
+		if (verbose || startupBenchmark) {
+			const PipelineBatchTimings& pipelineTimings = pipelineBatch.timings;
+			auto milliseconds = [](auto from, auto to) { return std::chrono::duration<double, std::milli>(to - from).count(); };
+			std::cout << "Startup timings:\n";
+			std::cout << "\tAssets: " << milliseconds(tStartup, tAssets) << " ms\n";
+			printPipelineBatchTimings(pipelineTimings, slangCompiler->cacheHits, slangCompiler->cacheMisses);
+			std::cout << "\tTotal: " << milliseconds(tStartup, tPipelines) << " ms\n";
+		}
+
+		if (startupBenchmark) {
+			runStartupBenchmark();
+			// Nothing is rendered in benchmark mode
+			requestExit();
+		}
+
 		for (auto& pipeline : pipelineList) {
 			fileWatcher->addPipeline(pipeline);
 		}
@@ -1314,7 +2274,10 @@ public:
 		fileWatcher->start();
 
 		// @todo
-		if (backgroundMusic.openFromFile(getAssetPath() + "music/18._infinite_darkness.mp3")) {
+		const std::string musicFile{ "music/18._infinite_darkness.mp3" };
+		const vks::AssetArchiveEntry* music = assetArchive.find(musicFile);
+		const bool musicLoaded = music ? backgroundMusic.openFromMemory(assetArchive.getData(*music), music->size) : backgroundMusic.openFromFile(getAssetPath() + musicFile);
+		if (musicLoaded) {
 			backgroundMusic.setVolume(30);
 			backgroundMusic.setLoop(true);
 			backgroundMusic.play();
@@ -1336,6 +2299,87 @@ public:
 		CommandBuffer* cb = frame.commandBuffer;
 		cb->begin();
 
+#if !defined(USE_REBAR)
+		// Dynamic buffer data staged during this frame needs to be copied before any of it is read
+		if (stagingRing->hasPendingCopies()) {
+			stagingRing->recordCopies(cb);
+			cb->insertMemoryBarrier(
+				VK_ACCESS_TRANSFER_WRITE_BIT,
+				VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_SHADER_READ_BIT,
+				VK_PIPELINE_STAGE_TRANSFER_BIT,
+				VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+		}
+#endif
+
+		// Chunks that moved into the tile index image's window
+		if (tilemapImage) {
+			game.tilemap.texture->recordRegionUpdate(cb->handle, frame.tilemapStagingBuffer->buffer, frame.tilemapImageCopies);
+		}
+
+		// Cull sprites and compact the visible ones into the instance buffer, which also writes the instance count for the indirect draw
+		if (gpuCulling) {
+			const VkDrawIndirectCommand drawCommand{ .vertexCount = 6, .instanceCount = 0, .firstVertex = 0, .firstInstance = 0 };
+			cb->updateBuffer(frame.indirectDrawBuffer->buffer, 0, sizeof(VkDrawIndirectCommand), &drawCommand);
+			cb->insertBufferMemoryBarrier(
+				frame.indirectDrawBuffer->buffer,
+				VK_ACCESS_TRANSFER_WRITE_BIT,
+				VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+				VK_PIPELINE_STAGE_TRANSFER_BIT,
+				VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+			// One thread per sprite + the player
+			CullingPushConsts cullingPushConsts{
+				.spriteCount = frame.spriteCount,
+				.alpha = game.getInterpolationFactor(),
+				.groupCount = (frame.spriteCount + 1 + cullingGroupSize - 1) / cullingGroupSize
+			};
+			cb->bindDescriptorSets(pipelineLayouts["cull"], { frame.descriptorSetCulling }, 0, VK_PIPELINE_BIND_POINT_COMPUTE);
+			cb->bindPipeline(pipelines["cull"]);
+			// Visible sprites per workgroup, then a single workgroup turns them into output offsets, then each workgroup writes its sprites in order
+			for (CullingPass pass : { CullingPass::Count, CullingPass::Scan, CullingPass::Write }) {
+				cullingPushConsts.pass = pass;
+				cb->updatePushConstant(pipelineLayouts["cull"], 0, &cullingPushConsts);
+				cb->dispatch((pass == CullingPass::Scan) ? 1 : cullingPushConsts.groupCount, 1, 1);
+				if (pass != CullingPass::Write) {
+					cb->insertBufferMemoryBarrier(
+						frame.cullingGroupOffsetsBuffer->buffer,
+						VK_ACCESS_SHADER_WRITE_BIT,
+						VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+						VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+						VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+				}
+			}
+			cb->insertBufferMemoryBarrier(
+				frame.culledInstanceBuffer->buffer,
+				VK_ACCESS_SHADER_WRITE_BIT,
+				VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT,
+				VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+				VK_PIPELINE_STAGE_VERTEX_INPUT_BIT);
+			cb->insertBufferMemoryBarrier(
+				frame.indirectDrawBuffer->buffer,
+				VK_ACCESS_SHADER_WRITE_BIT,
+				VK_ACCESS_INDIRECT_COMMAND_READ_BIT,
+				VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+				VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT);
+		}
+
+		// Bin lights into screen tiles for the post process
+		if (tiledLighting) {
+			const glm::uvec2 tileCount = getLightTileCount();
+			cb->bindDescriptorSets(pipelineLayouts["lightcull"], { frame.descriptorSetLightCulling }, 0, VK_PIPELINE_BIND_POINT_COMPUTE);
+			cb->bindPipeline(pipelines["lightcull"]);
+			// One workgroup per tile
+			cb->dispatch(tileCount.x, tileCount.y, 1);
+			const VkBuffer tileBuffers[2] = { frame.tileLightCountsBuffer->buffer, frame.tileLightIndicesBuffer->buffer };
+			for (VkBuffer buffer : tileBuffers) {
+				cb->insertBufferMemoryBarrier(
+					buffer,
+					VK_ACCESS_SHADER_WRITE_BIT,
+					VK_ACCESS_SHADER_READ_BIT,
+					VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+					VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+			}
+		}
+
 		// New structures are used to define the attachments used in dynamic rendering
 		VkRenderingAttachmentInfo colorAttachment{};
 		VkRenderingAttachmentInfo depthStencilAttachment{};		
@@ -1425,35 +2469,43 @@ public:
 		} pushConsts{};
 		pushConsts.uints[0] = game.tilemap.imageIndex;
 		pushConsts.uints[1] = game.tilemap.firstTileIndex;
-		pushConsts.floats[0] = (float)width / 32.0f;
-		pushConsts.floats[1] = (float)height / 32.0f;
-
-		pushConsts.floats[0] = 1024.0f / (float)visibleTileCount;
-		pushConsts.floats[1] = 1024.0f / (float)visibleTileCount;
-
-#ifdef TILEMAP_VAR_A
-		cb->bindDescriptorSets(pipelineLayouts["tilemap"], { descriptorSetTextures, game.tilemap.descriptorSetSampler, frame.descriptorSet });
-		cb->bindPipeline(pipelines["tilemap"]);
-		cb->updatePushConstant(pipelineLayouts["tilemap"], 0, &pushConsts);
-		cb->draw(3, 1, 0, 0);
-#else
-		// Tilemap variant B
-		// @todo: only display tiles actually visible (update similar to instance buffer for sprites)
-		cb->bindVertexBuffers(0, 1, { quadBuffer->buffer });
-		cb->bindVertexBuffers(1, 1, { frame.tilemapInstanceBuffer->buffer });
-		cb->bindDescriptorSets(pipelineLayouts["tilemap-naive"], { descriptorSetTextures, descriptorSetSamplers, frame.descriptorSet });
-		cb->bindPipeline(pipelines["tilemap-naive"]);
-		cb->draw(6, frame.tilemapInstanceCount, 0, 0);
-#endif
+		// Tiles visible from the center of the screen to its edges, as tiles are two units wide and the view spans screenDim units in each direction
+		pushConsts.floats[0] = screenDim.x;
+		pushConsts.floats[1] = screenDim.y;
+
+		if (tilemapImage) {
+			// Tilemap variant A
+			// Single full screen triangle, tile indices are looked up from the tile index image
+			cb->bindDescriptorSets(pipelineLayouts["tilemap"], { descriptorSetTextures, game.tilemap.descriptorSetSampler, frame.descriptorSet });
+			cb->bindPipeline(pipelines["tilemap"]);
+			cb->updatePushConstant(pipelineLayouts["tilemap"], 0, &pushConsts);
+			cb->draw(3, 1, 0, 0);
+		} else {
+			// Tilemap variant B
+			// One instanced draw per visible chunk from the chunk cache
+			cb->bindVertexBuffers(0, 1, { quadBuffer->buffer });
+			cb->bindVertexBuffers(1, 1, { tilemapChunkCache.instanceBuffer->buffer });
+			cb->bindDescriptorSets(pipelineLayouts["tilemap-naive"], { descriptorSetTextures, descriptorSetSamplers, frame.descriptorSet });
+			cb->bindPipeline(pipelines["tilemap-naive"]);
+			for (const TilemapChunkDraw& draw : frame.tilemapDraws) {
+				cb->draw(6, draw.instanceCount, 0, draw.firstInstance);
+			}
+		}
 
 		// Draw sprites using instancing
 		// Instancing buffer stores sprite index, position, scale, direction (to flip/rotate) uv, maybe color for health state
 
 		cb->bindVertexBuffers(0, 1, { quadBuffer->buffer });
-		cb->bindVertexBuffers(1, 1, { frame.instanceBuffer->buffer });
-		cb->bindDescriptorSets(pipelineLayouts["sprite"], { descriptorSetTextures, descriptorSetSamplers, frame.descriptorSet });
+		cb->bindVertexBuffers(1, 1, { gpuCulling ? frame.culledInstanceBuffer->buffer : frame.instanceBuffer->buffer });
+		cb->bindDescriptorSets(pipelineLayouts["sprite"], { descriptorSetTextures, descriptorSetSamplers, frame.descriptorSet, descriptorSetSpriteAtlas });
 		cb->bindPipeline(pipelines["sprite"]);
-		cb->draw(6, frame.instanceBufferDrawCount, 0, 0);		
+		if (gpuCulling) {
+			// Order of the compacted instances depends on shader execution, the player is in a fixed slot after them and drawn last so it's always on top
+			cb->drawIndirect(frame.indirectDrawBuffer->buffer, 0, 1, sizeof(VkDrawIndirectCommand));
+			cb->draw(6, 1, 0, frame.spriteCount);
+		} else {
+			cb->draw(6, frame.instanceBufferDrawCount, 0, 0);
+		}
 		// Game overlay
 		// @todo: before or after post process?
 		cb->bindVertexBuffers(0, 1, { frame.uiBuffer->buffer });
@@ -1520,18 +2572,44 @@ public:
 
 		FrameObjects& currentFrame = frameObjects[getCurrentFrameIndex()];
 		VulkanApplication::prepareFrame(currentFrame);
+		if (validateLightTiles) {
+			validateLightTileFrame(currentFrame);
+		}
+#if !defined(USE_REBAR)
+		// The frame that last used this frame's staging buffer has finished by now, so it can be reused
+		stagingRing->beginFrame(getCurrentFrameIndex());
+#endif
 		updateOverlay(getCurrentFrameIndex());
 		// @todo
 		{
 			ZoneScopedN("Game update");
 			if (!paused) {
-				game.update(frameTimer);
-				game.updateInput(frameTimer);
+				const Game::InputState keyboardInput{
+					.moveLeft = sf::Keyboard::isKeyPressed(sf::Keyboard::A),
+					.moveRight = sf::Keyboard::isKeyPressed(sf::Keyboard::D),
+					.moveUp = sf::Keyboard::isKeyPressed(sf::Keyboard::W),
+					.moveDown = sf::Keyboard::isKeyPressed(sf::Keyboard::S),
+					.sprint = sf::Keyboard::isKeyPressed(sf::Keyboard::LShift),
+					.push = sf::Keyboard::isKeyPressed(sf::Keyboard::Space)
+				};
+				// The simulation runs at a fixed timestep, so depending on the frame time there may be zero or multiple ticks per frame
+				const uint32_t ticks = game.advanceTime(frameTimer);
+				for (uint32_t i = 0; i < ticks; i++) {
+					const Game::InputState input = playbackReplay ? replay.getInput(game.tickCount) : keyboardInput;
+					if (recordReplay) {
+						replay.record(input);
+					}
+					game.tick(input);
+				}
 			}
 		}
 		{
 			ZoneScopedN("Instance buffer update");
-			updateInstanceBuffer(currentFrame);
+			if (gpuCulling) {
+				updateSpriteBuffer(currentFrame);
+			} else {
+				updateInstanceBuffer(currentFrame);
+			}
 		}
 		{
 			ZoneScopedN("Tilemap buffer update");
@@ -1551,23 +2629,35 @@ public:
 
 		shaderData.timer = timer;
 		//shaderData.view = glm::mat4(1.0f);
-		shaderData.mvp = glm::translate(glm::mat4(1.0f), -glm::vec3(game.player.position / screenDim, 0.0f));
+		shaderData.mvp = glm::translate(glm::mat4(1.0f), -glm::vec3(getPlayerPosition() / screenDim, 0.0f));
 		shaderData.mvp *= glm::ortho(-screenDim.x, screenDim.x, -screenDim.x, screenDim.x);
 		shaderData.screenRes = glm::vec2((float)width, (float)height);
+		shaderData.playerPos = getPlayerPosition();
+		shaderData.screenDim = screenDim;
 		shaderData.lightCount = currentFrame.lightsBufferDrawCount;
 		shaderData.dayNightCycle = game.dayNightCycle <= 1.0f ? game.dayNightCycle : 2.0 - game.dayNightCycle;
 		float vpHeight = (float)height;
 		float vpWidth = vpHeight * 4.0f / 3.0f;
 		shaderData.viewportAR = (4.0f / 3.0f) * ((float)width/vpWidth);
+		shaderData.lightTileCount = getLightTileCount();
+		shaderData.maxLightsPerTile = tiledLighting ? maxLightsPerTile : 0;
+		if (validateLightTiles && tiledLighting) {
+			currentFrame.lightTileValidation.pending = true;
+			currentFrame.lightTileValidation.tileCount = shaderData.lightTileCount;
+			currentFrame.lightTileValidation.screenRes = shaderData.screenRes;
+			currentFrame.lightTileValidation.viewportAR = shaderData.viewportAR;
+		}
 		memcpy(currentFrame.uniformBuffer->mapped, &shaderData, sizeof(ShaderData)); // @todo: buffer function
 
 		recordCommandBuffer(currentFrame);
 		VulkanApplication::submitFrame(currentFrame);
 
+		// Shaders are recompiled in the background, finished pipelines are swapped in between frames
 		for (auto& pipeline : pipelineList) {
 			if (pipeline->wantsReload) {
-				pipeline->reload();
+				pipeline->reloadAsync();
 			}
+			pipeline->applyReload();
 		}
 	}
 
@@ -1605,10 +2695,17 @@ public:
 		ImGui::SetNextWindowPos(ImVec2(30, 30), ImGuiSetCond_FirstUseEver);
 		ImGui::SetNextWindowSize(ImVec2(0, 50), ImGuiSetCond_FirstUseEver);
 		ImGui::Begin("Statistics", 0, ImGuiWindowFlags_None);
-		ImGui::Text("Monsters: %d", static_cast<uint32_t>(game.monsters.size()));
-		ImGui::Text("Projectiles: %d", static_cast<uint32_t>(game.projectiles.size()));
-		ImGui::Text("Pickups: %d", static_cast<uint32_t>(game.pickups.size()));
-		ImGui::Text("Numbers: %d", static_cast<uint32_t>(game.numbers.size()));
+		ImGui::Text("Monsters: %d / %d", static_cast<uint32_t>(game.monsters.alive()), static_cast<uint32_t>(game.monsters.size()));
+		ImGui::Text("Projectiles: %d / %d", static_cast<uint32_t>(game.projectiles.alive()), static_cast<uint32_t>(game.projectiles.size()));
+		ImGui::Text("Pickups: %d / %d", static_cast<uint32_t>(game.pickups.alive()), static_cast<uint32_t>(game.pickups.size()));
+		ImGui::Text("Numbers: %d / %d", static_cast<uint32_t>(game.numbers.alive()), static_cast<uint32_t>(game.numbers.size()));
+		ImGui::Text("Tile map chunks: %d (uploads: %d)", game.tilemap.getResidentChunkCount(), tilemapImage ? tilemapIndexImage.uploadCount : tilemapChunkCache.uploadCount);
+		if (tilemapImage) {
+			ImGui::Text("Tile map region uploads: %d", tilemapIndexImage.regionUploadCount);
+		}
+		ImGui::Checkbox("GPU culling", &gpuCulling);
+		ImGui::Checkbox("Tile index image", &tilemapImage);
+		ImGui::Checkbox("Tiled lighting", &tiledLighting);
 		ImGui::End();
 		ImGui::SetNextWindowPos(ImVec2(50, 50), ImGuiSetCond_FirstUseEver);
 		ImGui::SetNextWindowSize(ImVec2(0, 50), ImGuiSetCond_FirstUseEver);
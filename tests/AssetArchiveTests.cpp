@@ -0,0 +1,55 @@
+/*
+* Unit tests for the validation of asset archive entries
+*
+* Copyright(C) 2026 by Sascha Willems - www.saschawillems.de
+*
+* This code is licensed under the MIT license(MIT) (http://opensource.org/licenses/MIT)
+*/
+
+#include "AssetArchive.hpp"
+#include "Check.hpp"
+
+using vks::AssetArchiveImageFormat;
+using vks::getAssetArchiveImageSize;
+
+void testRGBA8Size()
+{
+	CHECK(getAssetArchiveImageSize(AssetArchiveImageFormat::RGBA8, 32, 32, 1) == 32 * 32 * 4);
+	CHECK(getAssetArchiveImageSize(AssetArchiveImageFormat::RGBA8, 3, 5, 1) == 3 * 5 * 4);
+	// Levels are stored back to back, down to 1 x 1
+	CHECK(getAssetArchiveImageSize(AssetArchiveImageFormat::RGBA8, 4, 2, 3) == (4 * 2 + 2 * 1 + 1 * 1) * 4);
+}
+
+// 4 x 4 texel blocks of 16 bytes, partial blocks at the edges and small mip levels take a whole block
+void testBC3Size()
+{
+	CHECK(getAssetArchiveImageSize(AssetArchiveImageFormat::BC3, 32, 32, 1) == 8 * 8 * 16);
+	CHECK(getAssetArchiveImageSize(AssetArchiveImageFormat::BC3, 5, 3, 1) == 2 * 1 * 16);
+	// Full chain of a 32 x 16 image: 8 x 4, 4 x 2, 2 x 1 blocks and then three levels of a single block
+	CHECK(getAssetArchiveImageSize(AssetArchiveImageFormat::BC3, 32, 16, 6) == (32 + 8 + 2 + 1 + 1 + 1) * 16);
+	CHECK(getAssetArchiveImageSize(AssetArchiveImageFormat::BC3, 32, 16, 7) == 0);
+}
+
+// Entries that can't be valid report a size of zero, so they never match the size stored in the entry
+void testInvalidImages()
+{
+	CHECK(getAssetArchiveImageSize(AssetArchiveImageFormat::None, 32, 32, 1) == 0);
+	CHECK(getAssetArchiveImageSize(static_cast<AssetArchiveImageFormat>(42), 32, 32, 1) == 0);
+	CHECK(getAssetArchiveImageSize(AssetArchiveImageFormat::RGBA8, 0, 32, 1) == 0);
+	CHECK(getAssetArchiveImageSize(AssetArchiveImageFormat::RGBA8, 32, 0, 1) == 0);
+	CHECK(getAssetArchiveImageSize(AssetArchiveImageFormat::RGBA8, 32, 32, 0) == 0);
+	// A 32 x 32 image has 6 levels
+	CHECK(getAssetArchiveImageSize(AssetArchiveImageFormat::RGBA8, 32, 32, 6) != 0);
+	CHECK(getAssetArchiveImageSize(AssetArchiveImageFormat::RGBA8, 32, 32, 7) == 0);
+	// Corrupted dimensions must not overflow into a plausible size
+	CHECK(getAssetArchiveImageSize(AssetArchiveImageFormat::RGBA8, 0xFFFFFFFF, 0xFFFFFFFF, 1) == 0);
+	CHECK(getAssetArchiveImageSize(AssetArchiveImageFormat::RGBA8, 0x80000000, 2, 1) == 0);
+}
+
+int main()
+{
+	Tests::run("RGBA8 size", testRGBA8Size);
+	Tests::run("BC3 size", testBC3Size);
+	Tests::run("Invalid images", testInvalidImages);
+	return Tests::result();
+}
@@ -0,0 +1,54 @@
+/*
+* Minimal checks for the test executables
+*
+* Failed checks are reported with their location and the test returns a non-zero exit code, which makes ctest report it as failed
+*
+* Copyright(C) 2026 by Sascha Willems - www.saschawillems.de
+*
+* This code is licensed under the MIT license(MIT) (http://opensource.org/licenses/MIT)
+*/
+
+#pragma once
+
+#include <iostream>
+#include <functional>
+#include <string>
+#include <atomic>
+
+namespace Tests {
+
+	// Checks may fail on worker threads
+	inline std::atomic<int>& failedChecks()
+	{
+		static std::atomic<int> count{ 0 };
+		return count;
+	}
+
+	inline void check(bool condition, const char* expression, const char* file, int line)
+	{
+		if (!condition) {
+			std::cerr << file << ":" << line << ": check failed: " << expression << "\n";
+			failedChecks()++;
+		}
+	}
+
+	// Runs a named test case and reports whether all of its checks passed
+	inline void run(const std::string& name, const std::function<void()>& test)
+	{
+		const int failedBefore = failedChecks();
+		test();
+		std::cout << ((failedChecks() == failedBefore) ? "[passed] " : "[FAILED] ") << name << "\n";
+	}
+
+	inline int result()
+	{
+		if (failedChecks() > 0) {
+			std::cerr << failedChecks() << " check(s) failed\n";
+			return 1;
+		}
+		return 0;
+	}
+
+}
+
+#define CHECK(condition) Tests::check((condition), #condition, __FILE__, __LINE__)
@@ -0,0 +1,226 @@
+/*
+* Job system throughput benchmark
+*
+* Compares the work-stealing job system against the thread pool with per-thread queues it replaced (copied below as the baseline)
+* Both use the same total no. of threads: The pool's threads plus a waiting caller vs. the job system's workers plus the caller that runs jobs while waiting
+*
+* Copyright(C) 2026 by Sascha Willems - www.saschawillems.de
+*
+* This code is licensed under the MIT license(MIT) (http://opensource.org/licenses/MIT)
+*/
+
+#include <iostream>
+#include <vector>
+#include <queue>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <cassert>
+#include <algorithm>
+#include "CommandLineParser.hpp"
+#include "JobSystem.hpp"
+
+namespace Baseline
+{
+	// vks::Thread and vks::ThreadPool as they were before the job system replaced them
+	class Thread
+	{
+	private:
+		bool destroying{ false };
+		std::thread worker;
+		std::queue<std::function<void()>> jobQueue;
+		std::mutex queueMutex;
+		std::condition_variable condition;
+
+		void queueLoop()
+		{
+			while (true)
+			{
+				std::function<void()> job;
+				{
+					std::unique_lock<std::mutex> lock(queueMutex);
+					condition.wait(lock, [this] { return !jobQueue.empty() || destroying; });
+					if (destroying)
+					{
+						break;
+					}
+					job = jobQueue.front();
+				}
+
+				job();
+
+				{
+					std::lock_guard<std::mutex> lock(queueMutex);
+					jobQueue.pop();
+					condition.notify_one();
+				}
+			}
+		}
+
+	public:
+		Thread()
+		{
+			worker = std::thread(&Thread::queueLoop, this);
+		}
+
+		~Thread()
+		{
+			if (worker.joinable())
+			{
+				wait();
+				queueMutex.lock();
+				destroying = true;
+				condition.notify_one();
+				queueMutex.unlock();
+				worker.join();
+			}
+		}
+
+		void addJob(std::function<void()> function)
+		{
+			std::lock_guard<std::mutex> lock(queueMutex);
+			jobQueue.push(std::move(function));
+			condition.notify_one();
+		}
+
+		void wait()
+		{
+			std::unique_lock<std::mutex> lock(queueMutex);
+			condition.wait(lock, [this]() { return jobQueue.empty(); });
+		}
+	};
+
+	class ThreadPool
+	{
+	public:
+		std::vector<std::unique_ptr<Thread>> threads;
+
+		void setThreadCount(uint32_t count)
+		{
+			threads.clear();
+			for (uint32_t i = 0; i < count; i++)
+			{
+				threads.push_back(std::make_unique<Thread>());
+			}
+		}
+
+		void wait()
+		{
+			for (auto& thread : threads)
+			{
+				thread->wait();
+			}
+		}
+	};
+}
+
+// Keeps the compiler from optimizing the work away
+std::atomic<uint64_t> sink{ 0 };
+
+// Simulates the cost of processing an item, the amount of work is given in iterations
+void work(uint32_t iterations)
+{
+	float value{ 1.0f };
+	for (uint32_t i = 0; i < iterations; i++) {
+		value = std::sqrt(value + static_cast<float>(i));
+	}
+	sink.fetch_add(static_cast<uint64_t>(value), std::memory_order_relaxed);
+}
+
+template<typename Function>
+double measure(uint32_t repetitions, Function function)
+{
+	// Best of all repetitions, to filter out noise from other processes
+	double best{ 1e30 };
+	for (uint32_t i = 0; i < repetitions; i++) {
+		const auto tStart = std::chrono::high_resolution_clock::now();
+		function();
+		best = std::min(best, std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - tStart).count());
+	}
+	return best;
+}
+
+void report(const char* name, uint32_t jobCount, double poolTime, double jobSystemTime)
+{
+	std::cout << name << "\n";
+	std::cout << "\tThread pool:  " << poolTime << " ms (" << static_cast<uint64_t>(jobCount / (poolTime / 1000.0)) << " jobs/s)\n";
+	std::cout << "\tJob system:   " << jobSystemTime << " ms (" << static_cast<uint64_t>(jobCount / (jobSystemTime / 1000.0)) << " jobs/s)\n";
+	std::cout << "\tSpeedup:      " << poolTime / jobSystemTime << "x\n";
+}
+
+int main(int argc, char* argv[])
+{
+	CommandLineParser commandLineParser;
+	commandLineParser.add("help", { "--help" }, 0, "Show help");
+	commandLineParser.add("threads", { "-t", "--threads" }, 1, "Total no. of threads (default: no. of hardware threads)");
+	commandLineParser.add("jobs", { "-j", "--jobs" }, 1, "No. of jobs per benchmark (default: 100000)");
+	commandLineParser.add("repetitions", { "-r", "--repetitions" }, 1, "No. of repetitions, the best one is reported (default: 5)");
+	commandLineParser.parse(argc, argv);
+	if (commandLineParser.isSet("help")) {
+		commandLineParser.printHelp();
+		return 0;
+	}
+
+	const uint32_t threadCount = std::max(commandLineParser.getValueAsInt("threads", std::max(std::thread::hardware_concurrency(), 2u)), 2);
+	const uint32_t jobCount = commandLineParser.getValueAsInt("jobs", 100000);
+	const uint32_t repetitions = commandLineParser.getValueAsInt("repetitions", 5);
+
+	Baseline::ThreadPool threadPool;
+	threadPool.setThreadCount(threadCount - 1);
+	vks::JobSystem jobSystem(threadCount - 1);
+	std::cout << "Benchmarking " << jobCount << " jobs on " << threadCount << " threads\n";
+
+	// Many small jobs of equal cost, distributed round robin for the thread pool (scheduling overhead)
+	{
+		const uint32_t iterations = 50;
+		const double poolTime = measure(repetitions, [&] {
+			for (uint32_t i = 0; i < jobCount; i++) {
+				threadPool.threads[i % threadPool.threads.size()]->addJob([iterations] { work(iterations); });
+			}
+			threadPool.wait();
+		});
+		const double jobSystemTime = measure(repetitions, [&] {
+			vks::JobCounter counter;
+			for (uint32_t i = 0; i < jobCount; i++) {
+				jobSystem.run([iterations] { work(iterations); }, &counter);
+			}
+			jobSystem.wait(counter);
+		});
+		report("Small jobs", jobCount, poolTime, jobSystemTime);
+	}
+
+	// Items of very different cost (e.g. monsters crowding in one area) with the expensive ones at the start
+	// The pool gets one fixed range per thread (like the game's hand partitioning did), the job system uses parallelFor with a small grain size
+	{
+		const size_t expensiveCount = jobCount / 8;
+		auto cost = [expensiveCount](size_t index) { return static_cast<uint32_t>((index < expensiveCount) ? 1000 : 20); };
+		const double poolTime = measure(repetitions, [&] {
+			const size_t rangeSize = (jobCount + threadPool.threads.size() - 1) / threadPool.threads.size();
+			for (size_t t = 0; t < threadPool.threads.size(); t++) {
+				const size_t begin = std::min(t * rangeSize, static_cast<size_t>(jobCount));
+				const size_t end = std::min(begin + rangeSize, static_cast<size_t>(jobCount));
+				threadPool.threads[t]->addJob([begin, end, &cost] {
+					for (size_t i = begin; i < end; i++) {
+						work(cost(i));
+					}
+				});
+			}
+			threadPool.wait();
+		});
+		const double jobSystemTime = measure(repetitions, [&] {
+			jobSystem.parallelFor(0, jobCount, 256, [&cost](size_t begin, size_t end) {
+				for (size_t i = begin; i < end; i++) {
+					work(cost(i));
+				}
+			});
+		});
+		report("Imbalanced items", jobCount, poolTime, jobSystemTime);
+	}
+
+	return 0;
+}
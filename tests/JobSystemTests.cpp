@@ -0,0 +1,222 @@
+/*
+* Unit tests for the work-stealing job system
+*
+* Copyright(C) 2026 by Sascha Willems - www.saschawillems.de
+*
+* This code is licensed under the MIT license(MIT) (http://opensource.org/licenses/MIT)
+*/
+
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <memory>
+#include "JobSystem.hpp"
+#include "Check.hpp"
+
+// Deque operations from a single thread: The owner works LIFO, thieves take the oldest job
+void testDequeOrder()
+{
+	vks::JobDeque deque;
+	std::vector<vks::Job> jobs(4);
+	CHECK(deque.pop() == nullptr);
+	CHECK(deque.steal() == nullptr);
+	for (auto& job : jobs) {
+		CHECK(deque.push(&job));
+	}
+	CHECK(deque.pop() == &jobs[3]);
+	CHECK(deque.steal() == &jobs[0]);
+	CHECK(deque.pop() == &jobs[2]);
+	CHECK(deque.pop() == &jobs[1]);
+	CHECK(deque.pop() == nullptr);
+	CHECK(deque.steal() == nullptr);
+}
+
+void testDequeFull()
+{
+	vks::JobDeque deque;
+	vks::Job job;
+	uint32_t pushed{ 0 };
+	while (deque.push(&job)) {
+		pushed++;
+		if (pushed > 100000) {
+			break;
+		}
+	}
+	CHECK(pushed == 4096);
+	// Space freed by a steal (at the top) can be reused
+	CHECK(deque.steal() == &job);
+	CHECK(deque.push(&job));
+	CHECK(!deque.push(&job));
+}
+
+// The owner pushes and pops while thieves steal concurrently, every job has to be taken exactly once
+void testDequeConcurrentSteal()
+{
+	constexpr uint32_t jobCount = 200000;
+	constexpr uint32_t thiefCount = 3;
+	vks::JobDeque deque;
+	std::vector<vks::Job> jobs(jobCount);
+	std::unique_ptr<std::atomic<uint32_t>[]> taken(new std::atomic<uint32_t>[jobCount]);
+	for (uint32_t i = 0; i < jobCount; i++) {
+		taken[i] = 0;
+	}
+	auto take = [&](vks::Job* job) {
+		taken[job - jobs.data()].fetch_add(1, std::memory_order_relaxed);
+	};
+
+	std::atomic<bool> ownerDone{ false };
+	std::vector<std::thread> thieves;
+	for (uint32_t t = 0; t < thiefCount; t++) {
+		thieves.emplace_back([&] {
+			while (true) {
+				// Read before stealing, so a failed steal after the owner finished means the deque is empty
+				const bool done = ownerDone.load();
+				if (vks::Job* job = deque.steal()) {
+					take(job);
+				} else if (done) {
+					break;
+				} else {
+					std::this_thread::yield();
+				}
+			}
+		});
+	}
+
+	for (uint32_t i = 0; i < jobCount; i++) {
+		while (!deque.push(&jobs[i])) {
+			if (vks::Job* job = deque.pop()) {
+				take(job);
+			}
+		}
+		// Pop every third job to mix owner and thief accesses, including races for the last job
+		if (i % 3 == 0) {
+			if (vks::Job* job = deque.pop()) {
+				take(job);
+			}
+		}
+	}
+	while (vks::Job* job = deque.pop()) {
+		take(job);
+	}
+	ownerDone = true;
+	for (auto& thief : thieves) {
+		thief.join();
+	}
+
+	uint32_t wrongCount{ 0 };
+	for (uint32_t i = 0; i < jobCount; i++) {
+		if (taken[i] != 1) {
+			wrongCount++;
+		}
+	}
+	CHECK(wrongCount == 0);
+}
+
+void testRunAndWait()
+{
+	vks::JobSystem jobSystem(3);
+	CHECK(jobSystem.getThreadCount() == 4);
+	// More jobs than fit into a deque, the rest goes to the shared queue
+	constexpr uint32_t jobCount = 10000;
+	std::atomic<uint32_t> sum{ 0 };
+	vks::JobCounter counter;
+	CHECK(counter.done());
+	for (uint32_t i = 0; i < jobCount; i++) {
+		jobSystem.run([&sum, i] { sum.fetch_add(i, std::memory_order_relaxed); }, &counter);
+	}
+	jobSystem.wait(counter);
+	CHECK(counter.done());
+	CHECK(sum == jobCount * (jobCount - 1) / 2);
+}
+
+void testParallelFor()
+{
+	vks::JobSystem jobSystem(3);
+	constexpr size_t count = 10007;
+	for (size_t grainSize : { size_t(0), size_t(1), size_t(7), size_t(256), count, count * 2 }) {
+		std::vector<std::atomic<uint32_t>> visits(count);
+		jobSystem.parallelFor(0, count, grainSize, [&visits, grainSize](size_t begin, size_t end) {
+			CHECK(begin < end);
+			CHECK(end - begin <= std::max(grainSize, size_t(1)));
+			for (size_t i = begin; i < end; i++) {
+				visits[i].fetch_add(1, std::memory_order_relaxed);
+			}
+		});
+		uint32_t wrongCount{ 0 };
+		for (auto& visit : visits) {
+			if (visit != 1) {
+				wrongCount++;
+			}
+		}
+		CHECK(wrongCount == 0);
+	}
+	// Empty range
+	bool called{ false };
+	jobSystem.parallelFor(5, 5, 1, [&called](size_t, size_t) { called = true; });
+	CHECK(!called);
+}
+
+// Jobs that wait for jobs they started themselves must not deadlock, even with all workers busy waiting
+void testNestedWait()
+{
+	vks::JobSystem jobSystem(2);
+	std::atomic<uint32_t> innerRuns{ 0 };
+	jobSystem.parallelFor(0, 64, 1, [&jobSystem, &innerRuns](size_t, size_t) {
+		jobSystem.parallelFor(0, 16, 1, [&innerRuns](size_t, size_t) {
+			innerRuns.fetch_add(1, std::memory_order_relaxed);
+		});
+	});
+	CHECK(innerRuns == 64 * 16);
+}
+
+// Threads that aren't part of the job system submit to the shared queue and block in wait instead of running jobs
+void testExternalThread()
+{
+	vks::JobSystem jobSystem(2);
+	std::atomic<uint32_t> runs{ 0 };
+	std::thread external([&jobSystem, &runs] {
+		vks::JobCounter counter;
+		for (uint32_t i = 0; i < 1000; i++) {
+			jobSystem.run([&runs] { runs.fetch_add(1, std::memory_order_relaxed); }, &counter);
+		}
+		jobSystem.wait(counter);
+	});
+	external.join();
+	CHECK(runs == 1000);
+}
+
+// Jobs without a counter still run, and pending jobs are discarded (not run) when the job system is destroyed
+void testUntrackedJobsAndShutdown()
+{
+	std::atomic<uint32_t> runs{ 0 };
+	{
+		vks::JobSystem jobSystem(1);
+		for (uint32_t i = 0; i < 100; i++) {
+			jobSystem.run([&runs] { runs.fetch_add(1, std::memory_order_relaxed); });
+		}
+		vks::JobCounter counter;
+		jobSystem.run([] {}, &counter);
+		jobSystem.wait(counter);
+	}
+	CHECK(runs <= 100);
+	// The creating thread is no longer a worker, so a new job system can register it again
+	vks::JobSystem jobSystem(1);
+	vks::JobCounter counter;
+	uint32_t value{ 0 };
+	jobSystem.run([&value] { value = 1; }, &counter);
+	jobSystem.wait(counter);
+	CHECK(value == 1);
+}
+
+int main()
+{
+	Tests::run("Deque order", testDequeOrder);
+	Tests::run("Deque full", testDequeFull);
+	Tests::run("Deque concurrent steal", testDequeConcurrentSteal);
+	Tests::run("Run and wait", testRunAndWait);
+	Tests::run("Parallel for", testParallelFor);
+	Tests::run("Nested wait", testNestedWait);
+	Tests::run("External thread", testExternalThread);
+	Tests::run("Untracked jobs and shutdown", testUntrackedJobsAndShutdown);
+	return Tests::result();
+}
@@ -0,0 +1,176 @@
+/*
+* Unit tests for the CPU light binning used as the reference for the light culling compute shader
+*
+* Copyright(C) 2026 by Sascha Willems - www.saschawillems.de
+*
+* This code is licensed under the MIT license(MIT) (http://opensource.org/licenses/MIT)
+*/
+
+#include <vector>
+#include "LightBinning.hpp"
+#include "Check.hpp"
+
+using Tiles = std::vector<std::vector<uint32_t>>;
+
+// 64 x 32 pixels are 4 x 2 tiles, each tile covers 0.25 x 0.5 in uv space
+const glm::vec2 screenRes{ 64.0f, 32.0f };
+const glm::uvec2 tileCount{ 4, 2 };
+
+LightSource light(glm::vec2 pos, float radius)
+{
+	return LightSource{ .pos = pos, .radius = radius };
+}
+
+// Fills tiles in the layout written by lightcull.slang
+void writeTiles(const Tiles& tiles, std::vector<uint32_t>& counts, std::vector<uint32_t>& indices)
+{
+	counts.assign(tiles.size(), 0);
+	indices.assign(tiles.size() * maxLightsPerTile, 0);
+	for (size_t tile = 0; tile < tiles.size(); tile++) {
+		counts[tile] = static_cast<uint32_t>(tiles[tile].size());
+		for (size_t i = 0; i < tiles[tile].size() && i < maxLightsPerTile; i++) {
+			indices[tile * maxLightsPerTile + i] = tiles[tile][i];
+		}
+	}
+}
+
+void testNoLights()
+{
+	const Tiles tiles = binLights(nullptr, 0, tileCount, screenRes, 2.0f);
+	CHECK(tiles == Tiles(8));
+}
+
+void testFixedLights()
+{
+	const std::vector<LightSource> lights{
+		// Small light in the center of tile 0
+		light({ 0.125f, 0.25f }, 0.01f),
+		// Small light on the corner shared by tiles 1, 2, 5 and 6
+		light({ 0.5f, 0.5f }, 0.05f),
+		// Large light on the edge between tiles 1 and 2, reaches 0.3 vertically but only 0.15 horizontally with an aspect ratio of 2
+		light({ 0.5f, 0.25f }, 0.3f),
+	};
+	const Tiles tiles = binLights(lights.data(), 3, tileCount, screenRes, 2.0f);
+	const Tiles expected{
+		{ 0 }, { 1, 2 }, { 1, 2 }, {},
+		{}, { 1, 2 }, { 1, 2 }, {},
+	};
+	CHECK(tiles == expected);
+}
+
+// The horizontal distance is scaled by the aspect ratio, with an aspect ratio of 1 the large light also reaches the outer tiles of the first row
+void testAspectRatio()
+{
+	const std::vector<LightSource> lights{
+		light({ 0.125f, 0.25f }, 0.01f),
+		light({ 0.5f, 0.5f }, 0.05f),
+		light({ 0.5f, 0.25f }, 0.3f),
+	};
+	const Tiles tiles = binLights(lights.data(), 3, tileCount, screenRes, 1.0f);
+	const Tiles expected{
+		{ 0, 2 }, { 1, 2 }, { 1, 2 }, { 2 },
+		{}, { 1, 2 }, { 1, 2 }, {},
+	};
+	CHECK(tiles == expected);
+}
+
+void testLightsOutsideScreen()
+{
+	// Left of the screen, only reaches the first tile while the horizontal distance isn't scaled
+	const LightSource left = light({ -0.1f, 0.25f }, 0.15f);
+	CHECK(binLights(&left, 1, tileCount, screenRes, 1.0f) == Tiles({ { 0 }, {}, {}, {}, {}, {}, {}, {} }));
+	CHECK(binLights(&left, 1, tileCount, screenRes, 2.0f) == Tiles(8));
+	// Tiles on the right and bottom edge may extend beyond the screen: 40 x 16 pixels are 3 x 1 tiles, with the last one covering 0.8 to 1.2 horizontally
+	const LightSource right = light({ 1.1f, 0.5f }, 0.01f);
+	CHECK(binLights(&right, 1, { 3, 1 }, { 40.0f, 16.0f }, 1.0f) == Tiles({ {}, {}, { 0 } }));
+}
+
+// A light only affects tiles closer than its radius, at exactly its radius it's attenuated to zero
+void testRadiusIsExclusive()
+{
+	const LightSource edge = light({ 0.75f, 0.25f }, 0.25f);
+	const Tiles expected{
+		{}, {}, { 0 }, { 0 },
+		{}, {}, {}, {},
+	};
+	CHECK(binLights(&edge, 1, tileCount, screenRes, 1.0f) == expected);
+	// The radius scale moves the light into (or out of) the neighbouring tiles
+	const Tiles scaled = binLights(&edge, 1, tileCount, screenRes, 1.0f, 1.0001f);
+	CHECK(scaled[1] == std::vector<uint32_t>{ 0 });
+	CHECK(scaled[6] == std::vector<uint32_t>{ 0 });
+	CHECK(scaled[0].empty());
+}
+
+void testMismatches()
+{
+	const std::vector<LightSource> lights{
+		light({ 0.125f, 0.25f }, 0.01f),
+		light({ 0.5f, 0.5f }, 0.05f),
+		light({ 0.5f, 0.25f }, 0.3f),
+		light({ 0.75f, 0.25f }, 0.25f),
+	};
+	const uint32_t lightCount = static_cast<uint32_t>(lights.size());
+	std::vector<uint32_t> counts, indices;
+	auto mismatches = [&](const Tiles& tiles) {
+		writeTiles(tiles, counts, indices);
+		return countLightTileMismatches(counts.data(), indices.data(), lights.data(), lightCount, tileCount, screenRes, 1.0f);
+	};
+	const Tiles reference = binLights(lights.data(), lightCount, tileCount, screenRes, 1.0f);
+	CHECK(mismatches(reference) == 0);
+
+	// The order of lights in a tile doesn't matter
+	Tiles reversed = reference;
+	for (auto& tile : reversed) {
+		std::reverse(tile.begin(), tile.end());
+	}
+	CHECK(mismatches(reversed) == 0);
+
+	// Missing lights
+	Tiles missing = reference;
+	missing[0].clear();
+	missing[5].pop_back();
+	CHECK(mismatches(missing) == 2);
+
+	// Lights binned into tiles they don't affect
+	Tiles extra = reference;
+	extra[4].push_back(0);
+	CHECK(mismatches(extra) == 1);
+
+	// The last light is exactly at its radius from tiles 1 and 6, which may be binned either way
+	Tiles boundary = reference;
+	boundary[1].push_back(3);
+	boundary[6].push_back(3);
+	CHECK(mismatches(boundary) == 0);
+}
+
+void testOverflow()
+{
+	// More lights on a single spot than fit into a tile
+	std::vector<LightSource> lights(maxLightsPerTile + 1, light({ 0.125f, 0.25f }, 0.01f));
+	const uint32_t lightCount = static_cast<uint32_t>(lights.size());
+	const Tiles tiles = binLights(lights.data(), lightCount, tileCount, screenRes, 1.0f);
+	CHECK(tiles[0].size() == maxLightsPerTile + 1);
+
+	std::vector<uint32_t> counts, indices;
+	writeTiles(tiles, counts, indices);
+	CHECK(countLightTileMismatches(counts.data(), indices.data(), lights.data(), lightCount, tileCount, screenRes, 1.0f) == 0);
+	// A tile must not be marked as overflowing if it doesn't hold too many lights
+	counts[1] = maxLightsPerTile + 1;
+	CHECK(countLightTileMismatches(counts.data(), indices.data(), lights.data(), lightCount, tileCount, screenRes, 1.0f) == 1);
+	// An overflowing tile that was cut off at maxLightsPerTile is missing lights
+	counts[1] = 0;
+	counts[0] = maxLightsPerTile;
+	CHECK(countLightTileMismatches(counts.data(), indices.data(), lights.data(), lightCount, tileCount, screenRes, 1.0f) == 1);
+}
+
+int main()
+{
+	Tests::run("No lights", testNoLights);
+	Tests::run("Fixed lights", testFixedLights);
+	Tests::run("Aspect ratio", testAspectRatio);
+	Tests::run("Lights outside the screen", testLightsOutsideScreen);
+	Tests::run("Radius is exclusive", testRadiusIsExclusive);
+	Tests::run("Mismatches", testMismatches);
+	Tests::run("Overflow", testOverflow);
+	return Tests::result();
+}
@@ -0,0 +1,237 @@
+/*
+* Unit tests for the chunked tile map: streaming, eviction and regeneration of chunks and the per-layer dirty regions
+*
+* Copyright(C) 2026 by Sascha Willems - www.saschawillems.de
+*
+* This code is licensed under the MIT license(MIT) (http://opensource.org/licenses/MIT)
+*/
+
+#include <cstring>
+#include <vector>
+#include "Tilemap.hpp"
+#include "Check.hpp"
+
+using Game::Tilemap;
+using Game::TilemapChunk;
+using Game::TilemapLayer;
+
+// 128 x 128 chunks, far more than the resident budget
+constexpr uint32_t mapDim = 4096;
+
+// Tile position of the center of a chunk
+glm::ivec2 chunkCenter(glm::ivec2 chunk)
+{
+	return chunk * static_cast<int32_t>(TILEMAP_CHUNK_DIM) + static_cast<int32_t>(TILEMAP_CHUNK_DIM / 2);
+}
+
+bool sameTiles(const TilemapChunk& a, const TilemapChunk& b)
+{
+	return memcmp(a.tiles, b.tiles, sizeof(a.tiles)) == 0;
+}
+
+// Moves far enough away from a chunk to have it evicted
+void streamAway(Tilemap& tilemap)
+{
+	for (int32_t x = 0; x < 12; x++) {
+		for (int32_t y = 0; y < 12; y++) {
+			tilemap.streamAround(chunkCenter({ 100 + x * 2, 100 + y * 2 }));
+		}
+	}
+}
+
+void testResidencyBound()
+{
+	Tilemap tilemap;
+	tilemap.setSize(mapDim, mapDim);
+	tilemap.setSeed(1);
+	// Walk diagonally across the map, each step needs a new 3 x 3 block of chunks
+	for (int32_t i = 0; i < 120; i++) {
+		const glm::ivec2 chunk{ i, i };
+		tilemap.streamAround(chunkCenter(chunk));
+		CHECK(tilemap.getResidentChunkCount() <= tilemap.maxResidentChunks);
+		for (int32_t y = -1; y <= 1; y++) {
+			for (int32_t x = -1; x <= 1; x++) {
+				if ((chunk.x + x >= 0) && (chunk.y + y >= 0)) {
+					CHECK(tilemap.findChunk(chunk + glm::ivec2(x, y)) != nullptr);
+				}
+			}
+		}
+	}
+	CHECK(tilemap.getResidentChunkCount() == tilemap.maxResidentChunks);
+	// Chunks that have been left behind are evicted
+	CHECK(tilemap.findChunk({ 0, 0 }) == nullptr);
+	// The chunks required at once are kept even if they exceed the budget
+	tilemap.streamAround(chunkCenter({ 64, 64 }), 5);
+	CHECK(tilemap.getResidentChunkCount() == 11 * 11);
+	// Chunks outside the map are never loaded
+	tilemap.streamAround({ 0, 0 }, 1);
+	CHECK(tilemap.findChunk({ -1, -1 }) == nullptr);
+	CHECK(tilemap.findChunk({ 1, 1 }) != nullptr);
+}
+
+void testRegeneration()
+{
+	Tilemap tilemap;
+	tilemap.setSize(mapDim, mapDim);
+	tilemap.setSeed(7);
+	const glm::ivec2 position{ 3, 5 };
+	tilemap.streamAround(chunkCenter(position), 0);
+	const TilemapChunk original = *tilemap.findChunk(position);
+
+	streamAway(tilemap);
+	CHECK(tilemap.findChunk(position) == nullptr);
+	tilemap.streamAround(chunkCenter(position), 0);
+	const TilemapChunk* regenerated = tilemap.findChunk(position);
+	CHECK(regenerated != nullptr);
+	CHECK(sameTiles(*regenerated, original));
+
+	// Generation only depends on the seed and the map size, not on what has been generated before
+	Tilemap other;
+	other.setSize(mapDim, mapDim);
+	other.setSeed(7);
+	CHECK(other.getTile(position.x * TILEMAP_CHUNK_DIM, position.y * TILEMAP_CHUNK_DIM) == original.getTile(0, 0));
+	CHECK(sameTiles(*other.findChunk(position), original));
+	other.setSeed(8);
+	other.streamAround(chunkCenter(position), 0);
+	CHECK(!sameTiles(*other.findChunk(position), original));
+}
+
+void testSetTileSurvivesEviction()
+{
+	Tilemap tilemap;
+	tilemap.setSize(mapDim, mapDim);
+	tilemap.setSeed(1);
+	const glm::ivec2 tile{ 40, 70 };
+	const uint16_t generated = tilemap.getTile(tile.x, tile.y);
+	const uint16_t changed = (generated == Game::Tiles::Floor0) ? Game::Tiles::Floor1 : Game::Tiles::Floor0;
+	tilemap.setTile(tile.x, tile.y, TilemapLayer::Ground, changed);
+	tilemap.setTile(tile.x, tile.y, TilemapLayer::Overlay, Game::Tiles::Crack);
+
+	streamAway(tilemap);
+	const glm::ivec2 chunk = tile / static_cast<int32_t>(TILEMAP_CHUNK_DIM);
+	CHECK(tilemap.findChunk(chunk) == nullptr);
+	// Modified chunks that have been evicted don't count towards the budget
+	CHECK(tilemap.getResidentChunkCount() <= tilemap.maxResidentChunks);
+
+	CHECK(tilemap.getTile(tile.x, tile.y) == changed);
+	CHECK(tilemap.getTile(tile.x, tile.y, TilemapLayer::Overlay) == Game::Tiles::Crack);
+	CHECK(tilemap.findChunk(chunk)->modified);
+	// Other tiles of the chunk keep their generated values
+	Tilemap reference;
+	reference.setSize(mapDim, mapDim);
+	reference.setSeed(1);
+	CHECK(tilemap.getTile(tile.x + 1, tile.y) == reference.getTile(tile.x + 1, tile.y));
+
+	// Changing the seed discards all changes
+	tilemap.setSeed(2);
+	tilemap.setSeed(1);
+	CHECK(tilemap.getTile(tile.x, tile.y) == generated);
+	CHECK(tilemap.getTile(tile.x, tile.y, TilemapLayer::Overlay) == Game::Tiles::Empty);
+}
+
+// Floor tile that differs from the generated one
+uint16_t otherFloor(Tilemap& tilemap, int32_t x, int32_t y)
+{
+	return (tilemap.getTile(x, y) == Game::Tiles::Floor0) ? Game::Tiles::Floor1 : Game::Tiles::Floor0;
+}
+
+void testDirtyRegions()
+{
+	Tilemap tilemap;
+	tilemap.setSize(mapDim, mapDim);
+	tilemap.setSeed(1);
+	// Chunk (1, 2) covers tiles 32..63 x 64..95
+	tilemap.setTile(37, 70, TilemapLayer::Ground, otherFloor(tilemap, 37, 70));
+	tilemap.setTile(33, 90, TilemapLayer::Ground, otherFloor(tilemap, 33, 90));
+	tilemap.setTile(60, 66, TilemapLayer::Overlay, Game::Tiles::Crack);
+	// Setting a tile to its current value doesn't change anything
+	tilemap.setTile(50, 80, TilemapLayer::Decoration, tilemap.getTile(50, 80, TilemapLayer::Decoration));
+
+	const TilemapChunk* chunk = tilemap.findChunk({ 1, 2 });
+	// Each layer accumulates the bounds of its own changes in local coordinates
+	const Game::TilemapRect& ground = chunk->dirty[static_cast<uint32_t>(TilemapLayer::Ground)];
+	CHECK(ground.min == glm::ivec2(1, 6));
+	CHECK(ground.max == glm::ivec2(5, 26));
+	const Game::TilemapRect& overlay = chunk->dirty[static_cast<uint32_t>(TilemapLayer::Overlay)];
+	CHECK(overlay.min == glm::ivec2(28, 2));
+	CHECK(overlay.max == glm::ivec2(28, 2));
+	CHECK(chunk->dirty[static_cast<uint32_t>(TilemapLayer::Decoration)].empty());
+	// A chunk is only listed once, no matter how many of its tiles and layers changed
+	CHECK(tilemap.getDirtyChunks() == std::vector<glm::ivec2>({ { 1, 2 } }));
+
+	// Tiles outside the map can't be changed
+	tilemap.setTile(-1, 5, TilemapLayer::Ground, Game::Tiles::Water);
+	tilemap.setTile(mapDim, 5, TilemapLayer::Ground, Game::Tiles::Water);
+	CHECK(tilemap.getDirtyChunks().size() == 1);
+
+	tilemap.setTile(0, 0, TilemapLayer::Overlay, Game::Tiles::Crack);
+	CHECK(tilemap.getDirtyChunks() == std::vector<glm::ivec2>({ { 1, 2 }, { 0, 0 } }));
+
+	tilemap.clearDirtyRegions();
+	CHECK(tilemap.getDirtyChunks().empty());
+	for (const auto& rect : tilemap.findChunk({ 1, 2 })->dirty) {
+		CHECK(rect.empty());
+	}
+	// Clearing the dirty regions doesn't undo the changes
+	CHECK(tilemap.getTile(60, 66, TilemapLayer::Overlay) == Game::Tiles::Crack);
+	CHECK(tilemap.findChunk({ 1, 2 })->modified);
+
+	// Chunks become dirty again with the next change
+	tilemap.setTile(61, 66, TilemapLayer::Overlay, Game::Tiles::Crack);
+	CHECK(tilemap.getDirtyChunks() == std::vector<glm::ivec2>({ { 1, 2 } }));
+	CHECK(tilemap.findChunk({ 1, 2 })->dirty[static_cast<uint32_t>(TilemapLayer::Overlay)].min == glm::ivec2(29, 2));
+}
+
+void testDirtyChunksAcrossEviction()
+{
+	Tilemap tilemap;
+	tilemap.setSize(mapDim, mapDim);
+	tilemap.setSeed(1);
+	tilemap.setTile(40, 40, TilemapLayer::Overlay, Game::Tiles::Crack);
+	tilemap.setTile(200, 200, TilemapLayer::Overlay, Game::Tiles::Crack);
+
+	// Evicted chunks stay listed with their dirty regions, so changes made just before the eviction aren't lost for the users of the tile data
+	streamAway(tilemap);
+	CHECK(tilemap.findChunk({ 1, 1 }) == nullptr);
+	CHECK(tilemap.getDirtyChunks() == std::vector<glm::ivec2>({ { 1, 1 }, { 6, 6 } }));
+	tilemap.streamAround({ 40, 40 }, 0);
+	const Game::TilemapRect& overlay = tilemap.findChunk({ 1, 1 })->dirty[static_cast<uint32_t>(TilemapLayer::Overlay)];
+	CHECK(overlay.min == glm::ivec2(8, 8));
+	CHECK(overlay.max == glm::ivec2(8, 8));
+
+	// Clearing also resets the dirty regions of chunks that are evicted at that time
+	tilemap.clearDirtyRegions();
+	CHECK(tilemap.getDirtyChunks().empty());
+	CHECK(tilemap.findChunk({ 6, 6 }) == nullptr);
+	tilemap.streamAround({ 200, 200 }, 0);
+	for (const auto& rect : tilemap.findChunk({ 6, 6 })->dirty) {
+		CHECK(rect.empty());
+	}
+	CHECK(tilemap.getTile(200, 200, TilemapLayer::Overlay) == Game::Tiles::Crack);
+
+	// Changes to an evicted chunk that has been loaded again mark it as dirty once more
+	streamAway(tilemap);
+	tilemap.setTile(201, 200, TilemapLayer::Overlay, Game::Tiles::Crack);
+	CHECK(tilemap.getDirtyChunks() == std::vector<glm::ivec2>({ { 6, 6 } }));
+
+	// Modified chunks are reported in order of their position, whether they're resident or not
+	const std::vector<const TilemapChunk*> modified = tilemap.getModifiedChunks();
+	CHECK(modified.size() == 2);
+	CHECK(modified[0]->position == glm::ivec2(1, 1));
+	CHECK(modified[1]->position == glm::ivec2(6, 6));
+
+	// Changing the map discards all dirty chunks
+	tilemap.setSize(mapDim / 2, mapDim / 2);
+	CHECK(tilemap.getDirtyChunks().empty());
+	CHECK(tilemap.getModifiedChunks().empty());
+}
+
+int main()
+{
+	Tests::run("Residency bound", testResidencyBound);
+	Tests::run("Regeneration", testRegeneration);
+	Tests::run("setTile survives eviction", testSetTileSurvivesEviction);
+	Tests::run("Dirty regions", testDirtyRegions);
+	Tests::run("Dirty chunks across eviction", testDirtyChunksAcrossEviction);
+	return Tests::result();
+}
@@ -0,0 +1,253 @@
+/*
+* Block compression and mip generation for the asset packer
+*
+* BC3 encoder using the principal axis of each block's colors for the color endpoints and the alpha range for the alpha endpoints
+* Fully transparent texels are ignored when fitting the colors, so sprite outlines don't pull the endpoints towards their (invisible) background
+*
+* Copyright(C) 2026 by Sascha Willems - www.saschawillems.de
+*
+* This code is licensed under the MIT license(MIT) (http://opensource.org/licenses/MIT)
+*/
+
+#pragma once
+
+#include <vector>
+#include <array>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdint.h>
+
+namespace BlockCompression {
+
+	constexpr uint32_t bc3BlockSize = 16;
+
+	static uint16_t packColor565(const float color[3])
+	{
+		const uint16_t r = static_cast<uint16_t>(std::clamp(std::lround(color[0] * 31.0f / 255.0f), 0L, 31L));
+		const uint16_t g = static_cast<uint16_t>(std::clamp(std::lround(color[1] * 63.0f / 255.0f), 0L, 63L));
+		const uint16_t b = static_cast<uint16_t>(std::clamp(std::lround(color[2] * 31.0f / 255.0f), 0L, 31L));
+		return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+	}
+
+	static std::array<int, 3> unpackColor565(uint16_t color)
+	{
+		const int r = (color >> 11) & 31;
+		const int g = (color >> 5) & 63;
+		const int b = color & 31;
+		return { (r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2) };
+	}
+
+	// Compresses 4 x 4 RGBA8 texels (row major) into a 16 byte BC3 block
+	static void compressBlockBC3(const uint8_t* texels, uint8_t* block)
+	{
+		// Alpha
+		uint8_t alphaMin = 255, alphaMax = 0;
+		for (uint32_t i = 0; i < 16; i++) {
+			alphaMin = std::min(alphaMin, texels[i * 4 + 3]);
+			alphaMax = std::max(alphaMax, texels[i * 4 + 3]);
+		}
+		block[0] = alphaMax;
+		block[1] = alphaMin;
+		uint64_t alphaIndices{ 0 };
+		if (alphaMax != alphaMin) {
+			// Eight alpha values are interpolated if the first endpoint is larger than the second one
+			int palette[8] = { alphaMax, alphaMin };
+			for (int k = 2; k < 8; k++) {
+				palette[k] = ((8 - k) * alphaMax + (k - 1) * alphaMin) / 7;
+			}
+			for (uint32_t i = 0; i < 16; i++) {
+				const int alpha = texels[i * 4 + 3];
+				uint64_t best{ 0 };
+				for (int k = 1; k < 8; k++) {
+					if (std::abs(palette[k] - alpha) < std::abs(palette[best] - alpha)) {
+						best = k;
+					}
+				}
+				alphaIndices |= best << (3 * i);
+			}
+		}
+		for (uint32_t i = 0; i < 6; i++) {
+			block[2 + i] = static_cast<uint8_t>(alphaIndices >> (8 * i));
+		}
+
+		// Color endpoints along the principal axis of the visible texels
+		bool visible[16];
+		uint32_t visibleCount{ 0 };
+		for (uint32_t i = 0; i < 16; i++) {
+			visible[i] = texels[i * 4 + 3] > 0;
+			visibleCount += visible[i] ? 1 : 0;
+		}
+		if (visibleCount == 0) {
+			std::fill_n(visible, 16, true);
+			visibleCount = 16;
+		}
+		float mean[3] = { 0.0f, 0.0f, 0.0f };
+		for (uint32_t i = 0; i < 16; i++) {
+			for (uint32_t c = 0; c < 3 && visible[i]; c++) {
+				mean[c] += texels[i * 4 + c];
+			}
+		}
+		for (uint32_t c = 0; c < 3; c++) {
+			mean[c] /= static_cast<float>(visibleCount);
+		}
+		float covariance[3][3] = {};
+		for (uint32_t i = 0; i < 16; i++) {
+			if (!visible[i]) {
+				continue;
+			}
+			const float d[3] = { texels[i * 4] - mean[0], texels[i * 4 + 1] - mean[1], texels[i * 4 + 2] - mean[2] };
+			for (uint32_t a = 0; a < 3; a++) {
+				for (uint32_t b = 0; b < 3; b++) {
+					covariance[a][b] += d[a] * d[b];
+				}
+			}
+		}
+		float axis[3] = { 1.0f, 1.0f, 1.0f };
+		for (uint32_t iteration = 0; iteration < 8; iteration++) {
+			float next[3];
+			for (uint32_t a = 0; a < 3; a++) {
+				next[a] = covariance[a][0] * axis[0] + covariance[a][1] * axis[1] + covariance[a][2] * axis[2];
+			}
+			const float length = std::sqrt(next[0] * next[0] + next[1] * next[1] + next[2] * next[2]);
+			if (length < 1e-6f) {
+				break;
+			}
+			for (uint32_t a = 0; a < 3; a++) {
+				axis[a] = next[a] / length;
+			}
+		}
+		float projMin = 1e9f, projMax = -1e9f;
+		for (uint32_t i = 0; i < 16; i++) {
+			if (!visible[i]) {
+				continue;
+			}
+			const float projection = (texels[i * 4] - mean[0]) * axis[0] + (texels[i * 4 + 1] - mean[1]) * axis[1] + (texels[i * 4 + 2] - mean[2]) * axis[2];
+			projMin = std::min(projMin, projection);
+			projMax = std::max(projMax, projection);
+		}
+		float endpoint0[3], endpoint1[3];
+		for (uint32_t c = 0; c < 3; c++) {
+			endpoint0[c] = std::clamp(mean[c] + axis[c] * projMax, 0.0f, 255.0f);
+			endpoint1[c] = std::clamp(mean[c] + axis[c] * projMin, 0.0f, 255.0f);
+		}
+		uint16_t color0 = packColor565(endpoint0);
+		uint16_t color1 = packColor565(endpoint1);
+		if (color0 < color1) {
+			std::swap(color0, color1);
+		}
+		block[8] = static_cast<uint8_t>(color0);
+		block[9] = static_cast<uint8_t>(color0 >> 8);
+		block[10] = static_cast<uint8_t>(color1);
+		block[11] = static_cast<uint8_t>(color1 >> 8);
+
+		uint32_t colorIndices{ 0 };
+		if (color0 != color1) {
+			const std::array<int, 3> c0 = unpackColor565(color0);
+			const std::array<int, 3> c1 = unpackColor565(color1);
+			std::array<int, 3> palette[4] = { c0, c1 };
+			for (uint32_t c = 0; c < 3; c++) {
+				palette[2][c] = (2 * c0[c] + c1[c]) / 3;
+				palette[3][c] = (c0[c] + 2 * c1[c]) / 3;
+			}
+			for (uint32_t i = 0; i < 16; i++) {
+				uint32_t best{ 0 };
+				int bestDistance = INT32_MAX;
+				for (uint32_t k = 0; k < 4; k++) {
+					int distance{ 0 };
+					for (uint32_t c = 0; c < 3; c++) {
+						const int d = palette[k][c] - texels[i * 4 + c];
+						distance += d * d;
+					}
+					if (distance < bestDistance) {
+						bestDistance = distance;
+						best = k;
+					}
+				}
+				colorIndices |= best << (2 * i);
+			}
+		}
+		for (uint32_t i = 0; i < 4; i++) {
+			block[12 + i] = static_cast<uint8_t>(colorIndices >> (8 * i));
+		}
+	}
+
+	// Compresses an RGBA8 image, blocks at the right and bottom edges of images that aren't a multiple of four repeat the edge texels
+	static std::vector<uint8_t> compressBC3(const uint8_t* pixels, uint32_t width, uint32_t height)
+	{
+		const uint32_t blocksX = (width + 3) / 4;
+		const uint32_t blocksY = (height + 3) / 4;
+		std::vector<uint8_t> blocks(static_cast<size_t>(blocksX) * blocksY * bc3BlockSize);
+		uint8_t texels[64];
+		for (uint32_t by = 0; by < blocksY; by++) {
+			for (uint32_t bx = 0; bx < blocksX; bx++) {
+				for (uint32_t y = 0; y < 4; y++) {
+					for (uint32_t x = 0; x < 4; x++) {
+						const uint32_t srcX = std::min(bx * 4 + x, width - 1);
+						const uint32_t srcY = std::min(by * 4 + y, height - 1);
+						memcpy(&texels[(y * 4 + x) * 4], &pixels[(static_cast<size_t>(srcY) * width + srcX) * 4], 4);
+					}
+				}
+				compressBlockBC3(texels, &blocks[(static_cast<size_t>(by) * blocksX + bx) * bc3BlockSize]);
+			}
+		}
+		return blocks;
+	}
+
+	static float srgbToLinear(uint8_t value)
+	{
+		const float c = value / 255.0f;
+		return (c <= 0.04045f) ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+	}
+
+	static uint8_t linearToSrgb(float value)
+	{
+		const float c = (value <= 0.0031308f) ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+		return static_cast<uint8_t>(std::clamp(std::lround(c * 255.0f), 0L, 255L));
+	}
+
+	// Halves an sRGB RGBA8 image with a box filter, filtering the colors in linear space
+	static std::vector<uint8_t> downsample(const uint8_t* pixels, uint32_t width, uint32_t height)
+	{
+		const uint32_t dstWidth = std::max(width / 2, 1u);
+		const uint32_t dstHeight = std::max(height / 2, 1u);
+		std::vector<uint8_t> result(static_cast<size_t>(dstWidth) * dstHeight * 4);
+		for (uint32_t y = 0; y < dstHeight; y++) {
+			for (uint32_t x = 0; x < dstWidth; x++) {
+				float color[4] = {};
+				for (uint32_t sy = 0; sy < 2; sy++) {
+					for (uint32_t sx = 0; sx < 2; sx++) {
+						const uint8_t* texel = &pixels[(static_cast<size_t>(std::min(y * 2 + sy, height - 1)) * width + std::min(x * 2 + sx, width - 1)) * 4];
+						for (uint32_t c = 0; c < 3; c++) {
+							color[c] += srgbToLinear(texel[c]);
+						}
+						color[3] += texel[3];
+					}
+				}
+				uint8_t* dst = &result[(static_cast<size_t>(y) * dstWidth + x) * 4];
+				for (uint32_t c = 0; c < 3; c++) {
+					dst[c] = linearToSrgb(color[c] / 4.0f);
+				}
+				dst[3] = static_cast<uint8_t>(std::lround(color[3] / 4.0f));
+			}
+		}
+		return result;
+	}
+
+	// Compresses the image and its full mip chain, the levels are stored back to back starting with the largest
+	static std::vector<uint8_t> compressBC3WithMips(const uint8_t* pixels, uint32_t width, uint32_t height, uint32_t& mipLevels)
+	{
+		mipLevels = static_cast<uint32_t>(std::floor(std::log2(std::max(width, height)))) + 1;
+		std::vector<uint8_t> result = compressBC3(pixels, width, height);
+		std::vector<uint8_t> level(pixels, pixels + static_cast<size_t>(width) * height * 4);
+		for (uint32_t i = 1; i < mipLevels; i++) {
+			level = downsample(level.data(), width, height);
+			width = std::max(width / 2, 1u);
+			height = std::max(height / 2, 1u);
+			const std::vector<uint8_t> blocks = compressBC3(level.data(), width, height);
+			result.insert(result.end(), blocks.begin(), blocks.end());
+		}
+		return result;
+	}
+
+}
@@ -0,0 +1,197 @@
+/*
+* Asset packer
+*
+* Packs the loose asset files into a single archive that the application memory maps at startup
+* Images are stored decoded (or block compressed with their mip chain), the monster table is stored parsed and audio files are stored as is
+*
+* Copyright(C) 2026 by Sascha Willems - www.saschawillems.de
+*
+* This code is licensed under the MIT license(MIT) (http://opensource.org/licenses/MIT)
+*/
+
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <algorithm>
+#include <cstring>
+#include <cctype>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+#include "CommandLineParser.hpp"
+#include "AssetArchive.hpp"
+#include "BlockCompression.hpp"
+#include "object_types/Monsters.hpp"
+
+// Directories below the data directory that contain game assets
+const std::vector<std::string> assetDirectories = { "game", "sounds", "music" };
+
+struct PackedAsset {
+	vks::AssetArchiveEntry entry{};
+	std::vector<uint8_t> data{};
+};
+
+static bool hasExtension(const std::filesystem::path& path, std::initializer_list<const char*> extensions)
+{
+	std::string extension = path.extension().string();
+	std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+	return std::find_if(extensions.begin(), extensions.end(), [&extension](const char* e) { return extension == e; }) != extensions.end();
+}
+
+static std::vector<uint8_t> readFile(const std::filesystem::path& path)
+{
+	std::ifstream file(path, std::ios::binary | std::ios::ate);
+	if (!file.is_open()) {
+		throw std::runtime_error("Could not open " + path.string());
+	}
+	std::vector<uint8_t> data(static_cast<size_t>(file.tellg()));
+	file.seekg(0);
+	file.read(reinterpret_cast<char*>(data.data()), data.size());
+	return data;
+}
+
+// Returns false for files that aren't assets
+static bool packFile(const std::filesystem::path& path, const std::string& name, bool compress, PackedAsset& asset)
+{
+	if (name.size() >= sizeof(asset.entry.name)) {
+		throw std::runtime_error("Asset name " + name + " is too long for the archive index");
+	}
+	strncpy(asset.entry.name, name.c_str(), sizeof(asset.entry.name) - 1);
+
+	if (hasExtension(path, { ".png", ".jpg", ".jpeg", ".tga", ".bmp" })) {
+		int width, height, channels;
+		unsigned char* pixels = stbi_load(path.string().c_str(), &width, &height, &channels, 4);
+		if (!pixels) {
+			throw std::runtime_error("Could not decode " + path.string());
+		}
+		asset.entry.type = vks::AssetArchiveEntryType::Image;
+		asset.entry.width = static_cast<uint32_t>(width);
+		asset.entry.height = static_cast<uint32_t>(height);
+		// Block compressed images can't be packed into the sprite atlas unless they're made of whole blocks
+		if (compress && (width % 4 == 0) && (height % 4 == 0)) {
+			// Mips can't be generated with blits for compressed formats, so they're stored with the image
+			asset.entry.format = vks::AssetArchiveImageFormat::BC3;
+			asset.data = BlockCompression::compressBC3WithMips(pixels, asset.entry.width, asset.entry.height, asset.entry.mipLevels);
+		} else {
+			asset.entry.format = vks::AssetArchiveImageFormat::RGBA8;
+			asset.data.assign(pixels, pixels + static_cast<size_t>(width) * height * 4);
+		}
+		stbi_image_free(pixels);
+		return true;
+	}
+
+	if (name == "game/monsters.json") {
+		Game::ObjectTypes::MonsterTypes monsterTypes;
+		monsterTypes.loadFromFile(path.string());
+		asset.entry.type = vks::AssetArchiveEntryType::MonsterTable;
+		asset.data = monsterTypes.serialize();
+		return true;
+	}
+
+	if (hasExtension(path, { ".wav", ".ogg", ".flac", ".mp3" })) {
+		// Music is streamed while playing, so it's kept separate from sounds which are decoded at load time
+		asset.entry.type = name.starts_with("music/") ? vks::AssetArchiveEntryType::Music : vks::AssetArchiveEntryType::Sound;
+		asset.data = readFile(path);
+		return true;
+	}
+
+	return false;
+}
+
+static void writeArchive(const std::string& fileName, std::vector<PackedAsset>& assets)
+{
+	// Written to a temporary file first, so a running application never maps a partially written archive
+	const std::string tempFileName = fileName + ".tmp";
+	{
+		std::ofstream file(tempFileName, std::ios::binary | std::ios::trunc);
+		if (!file.is_open()) {
+			throw std::runtime_error("Could not create " + tempFileName);
+		}
+		vks::AssetArchiveHeader header{};
+		header.entryCount = static_cast<uint32_t>(assets.size());
+		header.entrySize = sizeof(vks::AssetArchiveEntry);
+
+		const auto align = [](uint64_t offset) { return (offset + vks::assetArchiveAlignment - 1) & ~(vks::assetArchiveAlignment - 1); };
+		const std::vector<char> zeros(vks::assetArchiveAlignment, 0);
+		uint64_t offset = sizeof(vks::AssetArchiveHeader);
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		for (auto& asset : assets) {
+			const uint64_t aligned = align(offset);
+			file.write(zeros.data(), aligned - offset);
+			asset.entry.offset = aligned;
+			asset.entry.size = asset.data.size();
+			file.write(reinterpret_cast<const char*>(asset.data.data()), asset.data.size());
+			offset = aligned + asset.data.size();
+		}
+
+		header.indexOffset = align(offset);
+		file.write(zeros.data(), header.indexOffset - offset);
+		for (auto& asset : assets) {
+			file.write(reinterpret_cast<const char*>(&asset.entry), sizeof(asset.entry));
+		}
+		file.seekp(0);
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		if (!file.good()) {
+			throw std::runtime_error("Could not write " + tempFileName);
+		}
+	}
+	std::filesystem::rename(tempFileName, fileName);
+}
+
+int main(int argc, char* argv[])
+{
+	CommandLineParser commandLineParser;
+	commandLineParser.add("help", { "--help" }, 0, "Show help");
+	commandLineParser.add("data", { "-d", "--data" }, 1, "Data directory containing the loose asset files");
+	commandLineParser.add("output", { "-o", "--output" }, 1, "Archive file to write (default: assets.pak in the data directory)");
+	commandLineParser.add("compress", { "-c", "--compress" }, 0, "Store images BC3 compressed with precomputed mips (reduces memory and upload size, but is lossy, so it's off by default for pixel art)");
+	commandLineParser.parse(argc, argv);
+	if (commandLineParser.isSet("help")) {
+		commandLineParser.printHelp();
+		return 0;
+	}
+
+#if defined(DATA_DIR)
+	const std::string defaultDataDir = DATA_DIR;
+#else
+	const std::string defaultDataDir = "./../data/";
+#endif
+	const std::filesystem::path dataDir = commandLineParser.getValueAsString("data", defaultDataDir);
+	const std::string outputFileName = commandLineParser.getValueAsString("output", (dataDir / "assets.pak").string());
+	const bool compress = commandLineParser.isSet("compress");
+
+	try {
+		std::vector<PackedAsset> assets;
+		uint64_t looseSize{ 0 };
+		for (auto& directory : assetDirectories) {
+			if (!std::filesystem::is_directory(dataDir / directory)) {
+				std::cerr << "Skipping missing asset directory " << (dataDir / directory).string() << "\n";
+				continue;
+			}
+			for (auto& file : std::filesystem::recursive_directory_iterator(dataDir / directory)) {
+				if (!file.is_regular_file()) {
+					continue;
+				}
+				const std::string name = file.path().lexically_relative(dataDir).generic_string();
+				PackedAsset asset{};
+				if (packFile(file.path(), name, compress, asset)) {
+					looseSize += file.file_size();
+					assets.push_back(std::move(asset));
+				}
+			}
+		}
+		// Sorted for reproducible archives
+		std::sort(assets.begin(), assets.end(), [](const PackedAsset& a, const PackedAsset& b) { return strcmp(a.entry.name, b.entry.name) < 0; });
+
+		writeArchive(outputFileName, assets);
+		std::cout << "Packed " << assets.size() << " assets (" << looseSize / 1024 << " KiB of loose files) into " << outputFileName << " (" << std::filesystem::file_size(outputFileName) / 1024 << " KiB)\n";
+	}
+	catch (const std::exception& e) {
+		std::cerr << "Error: " << e.what() << "\n";
+		return 1;
+	}
+
+	return 0;
+}